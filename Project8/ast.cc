@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 
 #include "ast.h"
@@ -7,6 +9,57 @@ extern void yyerror(std::string err_string);
 extern void yyerror2(std::string err_string, int orig_line);
 
 
+// Helpers for collecting the effects of function bodies.
+namespace {
+  // Variables declared outside of any block or function are global.
+  bool IsGlobal(tableEntry * var_entry)
+  {
+    return var_entry->GetScope() == 0 && !var_entry->GetTemp();
+  }
+
+  // Note an assignment to the variable (or array element) that this node refers to.
+  void NoteWrite(ASTNode * node, FunctionEffects & effects)
+  {
+    if (ASTNode_Variable * var_node = dynamic_cast<ASTNode_Variable *>(node)) {
+      if (IsGlobal(var_node->GetVarEntry())) effects.writes_globals = true;
+    } else if (dynamic_cast<ASTNode_ArrayAccess *>(node) != NULL) {
+      effects.mutates_arrays = true;
+      NoteWrite(node->GetChild(0), effects);
+      node->GetChild(1)->CollectEffects(effects);
+    } else {
+      node->CollectEffects(effects);
+    }
+  }
+}
+
+
+// Helpers for evaluating code at compile time.
+namespace {
+  // Each node evaluated uses up one unit of fuel, so loops and recursion must end.
+  bool UseFuel(EvalState & state) { return --state.fuel >= 0; }
+
+  // Run one pass of a loop body; returns false if evaluation failed.  Afterward,
+  // state.flow is NEXT to keep looping, or BREAK / RETURN to stop.
+  bool EvaluateLoopBody(ASTNode * body, EvalState & state)
+  {
+    double value;
+    if (body && !body->Evaluate(state, value)) return false;
+    if (state.flow == EvalState::CONTINUE) state.flow = EvalState::NEXT;
+    return true;
+  }
+
+  // Write a value the way TubeCode expects a constant; false if it has no exact form.
+  bool ConstString(double value, std::string & out)
+  {
+    std::stringstream ss;
+    ss.precision(17);
+    ss << value;
+    out = ss.str();
+    return out.find_first_of("einf") == std::string::npos && std::stod(out) == value;
+  }
+}
+
+
 ///////////////
 //  ASTNode
 
@@ -18,6 +71,22 @@ void ASTNode::TransferChildren(ASTNode * in_node)
   in_node->children.resize(0);
 }
 
+int ASTNode::CountNodes()
+{
+  int count = 1;
+  for (int i = 0; i < (int) children.size(); i++) {
+    if (children[i] != NULL) count += children[i]->CountNodes();
+  }
+  return count;
+}
+
+void ASTNode::CollectEffects(FunctionEffects & effects)
+{
+  for (int i = 0; i < (int) children.size(); i++) {
+    if (children[i] != NULL) children[i]->CollectEffects(effects);
+  }
+}
+
 
 /////////////////////
 //  ASTNode_Root
@@ -34,15 +103,39 @@ tableEntry * ASTNode_Root::CompileTubeIC(symbolTable & table, IC_Array & ica)
   return NULL;
 }
 
+bool ASTNode_Root::Evaluate(EvalState & state, double & value)
+{
+  if (!UseFuel(state)) return false;
+  for (int i = 0; i < (int) children.size(); i++) {
+    if (!children[i]->Evaluate(state, value)) return false;
+    if (state.flow != EvalState::NEXT) break;
+  }
+  value = 0.0;
+  return true;
+}
+
 
 /////////////////////////
 //  ASTNode_Variable
 
+void ASTNode_Variable::CollectEffects(FunctionEffects & effects)
+{
+  if (IsGlobal(var_entry)) effects.reads_globals = true;
+}
+
 tableEntry * ASTNode_Variable::CompileTubeIC(symbolTable & table, IC_Array & ica)
 {
   return var_entry;
 }
 
+bool ASTNode_Variable::Evaluate(EvalState & state, double & value)
+{
+  auto found = state.vars.find(var_entry->GetVarID());
+  if (found == state.vars.end()) return false;   // Not set by the code being evaluated.
+  value = found->second;
+  return UseFuel(state);
+}
+
 
 ////////////////////////
 //  ASTNode_Literal
@@ -58,42 +151,115 @@ tableEntry * ASTNode_Literal::CompileTubeIC(symbolTable & table, IC_Array & ica)
   if (type == Type::VALUE || type == Type::CHAR) {
     ica.Add("val_copy", lexeme, out_var);
   } else if (type == Type::STRING) {
-    // Drop the beginning and ending quotes and process escape chars.
-    std::string str_value = "";
-    for (int i = 1; i < (int) lexeme.size() - 1; i++) {
-      if (lexeme[i] == '\\') {
-        switch (lexeme[++i]) {
-        case '\\': str_value += '\\'; break;
-        case '"':  str_value += '"';  break;
-        case 't':  str_value += '\t'; break;
-        case 'n':  str_value += '\n'; break;
-        };
-      } else {
-        str_value += lexeme[i];
-      }
-    }        
-
-    std::stringstream size_str;
-    size_str << str_value.size();
-    ica.Add("ar_set_siz", out_var, size_str.str());
-    for (int i = 0; i < (int) str_value.size(); i++) {
-      std::stringstream set_val;
-      switch (str_value[i]) {
-      case '\\': set_val << "'\\\\'"; break;
-      case '\t': set_val << "'\\t'"; break;
-      case '\n': set_val << "'\\n'"; break;
-      case '\'': set_val << "'\\''"; break;
-      default: set_val << "'" << str_value[i] << "'";
+    std::string str_value;
+    GetString(str_value);
+
+    // The characters are only written out once, into the literal pool at the start of
+    // the program; each use copies (or, if it is never changed, shares) that array.
+    std::vector<std::string> chars;
+    for (char c : str_value) chars.push_back(CharConst(c));
+    tableEntry * pool_var = table.GetLiteralVar(type, str_value);
+    ica.AddLiteral(pool_var, chars);
+    ica.Add("ar_copy", pool_var, out_var, "", "Copy string literal from the pool.");
+  } else {
+    std::cerr << "INTERNAL ERROR: Unknown type!" << std::endl;
+  }
+
+  return out_var;
+}
+
+bool ASTNode_Literal::GetString(std::string & out)
+{
+  if (type != Type::STRING) return false;
+
+  // Drop the beginning and ending quotes and process escape chars.
+  out = "";
+  for (int i = 1; i < (int) lexeme.size() - 1; i++) {
+    if (lexeme[i] == '\\') {
+      switch (lexeme[++i]) {
+      case '\\': out += '\\'; break;
+      case '"':  out += '"';  break;
+      case 't':  out += '\t'; break;
+      case 'n':  out += '\n'; break;
       };
+    } else {
+      out += lexeme[i];
+    }
+  }
+  return true;
+}
 
-      std::stringstream idx_str;
-      idx_str << i;
-      ica.Add("ar_set_idx", out_var, idx_str.str(), set_val.str());
+bool ASTNode_Literal::Evaluate(EvalState & state, double & value)
+{
+  if (type == Type::VALUE) value = std::stod(lexeme);
+  else if (type == Type::CHAR) {
+    value = lexeme[1];
+    if (lexeme[1] == '\\') {
+      switch (lexeme[2]) {
+      case 'n': value = '\n'; break;
+      case 't': value = '\t'; break;
+      default: value = lexeme[2];
+      };
     }
-  } else {
-    std::cerr << "INTERNAL ERROR: Unknown type!" << std::endl;
   }
+  else return false;
+  return UseFuel(state);
+}
+
+
+/////////////////////////
+// ASTNode_ArrayLiteral
 
+ASTNode_ArrayLiteral::ASTNode_ArrayLiteral(ASTNode * in_list)
+  : ASTNode(Type::VALUE_ARRAY)
+{
+  TransferChildren(in_list);
+
+  // The elements decide the type: all vals make an array(val), all chars a string.
+  const int elem_type = children[0]->GetType();
+  if (elem_type == Type::CHAR) SetType(Type::STRING);
+  for (ASTNode * child : children) {
+    if (child->GetType() != elem_type || (elem_type != Type::VALUE && elem_type != Type::CHAR)) {
+      std::string err_message = "array literal elements must all be of type 'val' or all 'char' (found '";
+      err_message += Type::AsString(child->GetType());
+      err_message += "')";
+      yyerror(err_message);
+      exit(1);
+    }
+  }
+}
+
+tableEntry * ASTNode_ArrayLiteral::CompileTubeIC(symbolTable & table, IC_Array & ica)
+{
+  tableEntry * out_var = table.GetTempVar(type);
+
+  // When every element is known at compile time, the array goes into the literal pool
+  // with the string literals: it is built once, and each use copies (or shares) it.
+  std::vector<std::string> values;
+  std::string key;
+  for (ASTNode * child : children) {
+    EvalState state;
+    double value;
+    std::string value_str;
+    if (!child->Evaluate(state, value) || state.vars.size() != 0 || !ConstString(value, value_str)) break;
+    if (type == Type::STRING) value_str = CharConst((char) value);
+    values.push_back(value_str);
+    key += value_str + ",";
+  }
+  if (values.size() == children.size()) {
+    tableEntry * pool_var = table.GetLiteralVar(type, key);
+    ica.AddLiteral(pool_var, values);
+    ica.Add("ar_copy", pool_var, out_var, "", "Copy array literal from the pool.");
+    return out_var;
+  }
+
+  // Otherwise fill it in an element at a time.
+  ica.Add("ar_set_siz", out_var, std::to_string(children.size()));
+  for (int i = 0; i < (int) children.size(); i++) {
+    tableEntry * elem_var = children[i]->CompileTubeIC(table, ica);
+    ica.Add("ar_set_idx", out_var, std::to_string(i), elem_var);
+    if (elem_var->GetTemp() == true) table.RemoveEntry( elem_var );
+  }
   return out_var;
 }
 
@@ -104,6 +270,10 @@ tableEntry * ASTNode_Literal::CompileTubeIC(symbolTable & table, IC_Array & ica)
 ASTNode_Assign::ASTNode_Assign(ASTNode * lhs, ASTNode * rhs)
   : ASTNode(lhs->GetType())
 { 
+  if (Type::IsFixedArray(lhs->GetType())) {
+    yyerror("cannot assign to a fixed-size array as a whole; assign to its elements");
+    exit(1);
+  }
   if (lhs->GetType() != rhs->GetType()) {
     std::string err_message = "types do not match for assignment (lhs='";
     err_message += Type::AsString(lhs->GetType());
@@ -117,9 +287,39 @@ ASTNode_Assign::ASTNode_Assign(ASTNode * lhs, ASTNode * rhs)
   children.push_back(rhs);
 }
 
+void ASTNode_Assign::CollectEffects(FunctionEffects & effects)
+{
+  NoteWrite(children[0], effects);
+  children[1]->CollectEffects(effects);
+}
+
 tableEntry * ASTNode_Assign::CompileTubeIC(symbolTable & table,
 						IC_Array & ica)
 {
+  // An element of a fixed-size array found at run time is stored through its address,
+  // which is checked once the value is ready; nothing is stored if it is out of range.
+  ASTNode_ArrayAccess * fixed_lhs = dynamic_cast<ASTNode_ArrayAccess *>(children[0]);
+  if (fixed_lhs != NULL && Type::IsFixedArray(fixed_lhs->GetChild(0)->GetType())) {
+    EvalState state;
+    double index;
+    if (!fixed_lhs->GetChild(1)->Evaluate(state, index) || state.vars.size() != 0) {
+      tableEntry * array_var = fixed_lhs->GetChild(0)->CompileTubeIC(table, ica);
+      const std::string bad_label = table.NextLabelID("fixed_index_bad_");
+      const std::string done_label = table.NextLabelID("fixed_index_done_");
+      tableEntry * addr_var = fixed_lhs->CompileFixedAddress(table, ica);
+      tableEntry * rhs_var = children[1]->CompileTubeIC(table, ica);
+      fixed_lhs->CompileRangeCheck(table, ica, addr_var, bad_label);
+      ica.Add("store", rhs_var, addr_var, std::to_string(array_var->GetVarID()))
+        .AddArg(std::to_string(array_var->GetElements().size()));
+      ica.Add("jump", done_label);
+      ica.AddLabel(bad_label);
+      fixed_lhs->CompileRangeError(ica);
+      ica.AddLabel(done_label);
+      table.RemoveEntry( addr_var );
+      return rhs_var;
+    }
+  }
+
   tableEntry * lhs_var = children[0]->CompileTubeIC(table, ica);
   tableEntry * rhs_var = children[1]->CompileTubeIC(table, ica);
 
@@ -150,6 +350,16 @@ tableEntry * ASTNode_Assign::CompileTubeIC(symbolTable & table,
   return lhs_var;
 }
 
+bool ASTNode_Assign::Evaluate(EvalState & state, double & value)
+{
+  ASTNode_Variable * lhs = dynamic_cast<ASTNode_Variable *>(children[0]);
+  if (lhs == NULL || !Type::IsScalar(type) || IsGlobal(lhs->GetVarEntry())) return false;
+  if (!UseFuel(state)) return false;
+  if (!children[1]->Evaluate(state, value)) return false;
+  state.vars[lhs->GetVarEntry()->GetVarID()] = value;
+  return true;
+}
+
 
 /////////////////////
 // ASTNode_Math1
@@ -195,6 +405,14 @@ tableEntry * ASTNode_Math1::CompileTubeIC(symbolTable & table, IC_Array & ica)
   return out_var;
 }
 
+bool ASTNode_Math1::Evaluate(EvalState & state, double & value)
+{
+  if (!UseFuel(state) || !children[0]->Evaluate(state, value)) return false;
+  if (math_op == '-') value = -value;
+  else value = (value == 0.0);
+  return true;
+}
+
 
 
 /////////////////////
@@ -249,6 +467,7 @@ tableEntry * ASTNode_Math2::CompileTubeIC(symbolTable & table, IC_Array & ica)
   else if (math_op == '-') { ica.Add("sub",  i1, i2, o3); }
   else if (math_op == '*') { ica.Add("mult", i1, i2, o3); }
   else if (math_op == '/') { ica.Add("div",  i1, i2, o3); }
+  else if (math_op == '%') { ica.Add("mod",  i1, i2, o3); }
   else if (math_op == COMP_EQU)  { ica.Add("test_equ",  i1, i2, o3); }
   else if (math_op == COMP_NEQU) { ica.Add("test_nequ", i1, i2, o3); }
   else if (math_op == COMP_GTR)  { ica.Add("test_gtr",  i1, i2, o3); }
@@ -266,6 +485,32 @@ tableEntry * ASTNode_Math2::CompileTubeIC(symbolTable & table, IC_Array & ica)
   return o3;
 }
 
+bool ASTNode_Math2::Evaluate(EvalState & state, double & value)
+{
+  double in1, in2;
+  if (!UseFuel(state)) return false;
+  if (!children[0]->Evaluate(state, in1) || !children[1]->Evaluate(state, in2)) return false;
+
+  if (math_op == '+') value = in1 + in2;
+  else if (math_op == '-') value = in1 - in2;
+  else if (math_op == '*') value = in1 * in2;
+  else if (math_op == '/') {
+    if (in2 == 0.0) return false;   // Leave the error for run time.
+    value = in1 / in2;
+  }
+  else if (math_op == '%') {
+    if (!ModValue(in1, in2, value)) return false;   // Leave the error for run time.
+  }
+  else if (math_op == COMP_EQU)  value = (in1 == in2);
+  else if (math_op == COMP_NEQU) value = (in1 != in2);
+  else if (math_op == COMP_GTR)  value = (in1 > in2);
+  else if (math_op == COMP_GTE)  value = (in1 >= in2);
+  else if (math_op == COMP_LESS) value = (in1 < in2);
+  else if (math_op == COMP_LTE)  value = (in1 <= in2);
+  else return false;
+  return true;
+}
+
 
 /////////////////////
 // ASTNode_Bool2
@@ -327,6 +572,16 @@ tableEntry * ASTNode_Bool2::CompileTubeIC(symbolTable & table, IC_Array & ica)
   return out_var;
 }
 
+bool ASTNode_Bool2::Evaluate(EvalState & state, double & value)
+{
+  if (!UseFuel(state) || !children[0]->Evaluate(state, value)) return false;
+  value = (value != 0.0);
+  if ((bool_op == '&' && value == 0.0) || (bool_op == '|' && value != 0.0)) return true;
+  if (!children[1]->Evaluate(state, value)) return false;
+  value = (value != 0.0);
+  return true;
+}
+
 
 ///////////////////////////
 // ASTNode_ArrayAccess
@@ -334,7 +589,11 @@ tableEntry * ASTNode_Bool2::CompileTubeIC(symbolTable & table, IC_Array & ica)
 ASTNode_ArrayAccess::ASTNode_ArrayAccess(ASTNode * in1, ASTNode * in2)
   : ASTNode(Type::InternalType(in1->GetType()))
 {
-  if (Type::IsArray(in1->GetType()) == false) {
+  if (Type::IsFixedArray(in1->GetType()) && dynamic_cast<ASTNode_Variable *>(in1) == NULL) {
+    yyerror("fixed-size arrays can only be indexed by name");
+    exit(1);
+  }
+  if (Type::IsArray(in1->GetType()) == false && Type::IsFixedArray(in1->GetType()) == false) {
     std::string err_message = "cannot index into a non-array type '";
     err_message += Type::AsString(in1->GetType());
     err_message += "'.";
@@ -352,9 +611,94 @@ ASTNode_ArrayAccess::ASTNode_ArrayAccess(ASTNode * in1, ASTNode * in2)
 }
 
 
+tableEntry * ASTNode_ArrayAccess::CompileFixedAddress(symbolTable & table, IC_Array & ica)
+{
+  tableEntry * array_var = children[0]->CompileTubeIC(table, ica);
+
+  // A constant added to (or taken from) the index can go into the first address.
+  ASTNode * index_node = children[1];
+  int base = array_var->GetVarID();
+  ASTNode_Math2 * sum = dynamic_cast<ASTNode_Math2 *>(index_node);
+  if (sum != NULL && (sum->GetOp() == '+' || sum->GetOp() == '-')) {
+    for (int side = 1; side >= 0; side--) {
+      EvalState offset_state;
+      double offset;
+      if (side == 0 && sum->GetOp() == '-') break;
+      if (!sum->GetChild(side)->Evaluate(offset_state, offset) || offset_state.vars.size() ||
+          std::fabs(offset) >= 10000 || offset != (int) offset) continue;
+      base += (sum->GetOp() == '+') ? (int) offset : -(int) offset;
+      index_node = sum->GetChild(1 - side);
+      break;
+    }
+  }
+
+  tableEntry * index_var = index_node->CompileTubeIC(table, ica);
+  tableEntry * addr_var = table.GetTempVar(Type::VALUE);
+  ica.Add("add", index_var, std::to_string(base), addr_var);
+  if (index_var->GetTemp() == true) table.RemoveEntry( index_var );
+  return addr_var;
+}
+
+void ASTNode_ArrayAccess::CompileRangeCheck(symbolTable & table, IC_Array & ica, tableEntry * addr_var,
+                                            const std::string & bad_label)
+{
+  tableEntry * array_var = children[0]->CompileTubeIC(table, ica);
+  const int first = array_var->GetVarID();
+  const int count = (int) array_var->GetElements().size();
+  tableEntry * test_var = table.GetTempVar(Type::VALUE);
+  ica.Add("test_less", addr_var, std::to_string(first), test_var);
+  ica.Add("jump_if_n0", test_var, bad_label);
+  ica.Add("test_gte", addr_var, std::to_string(first + count), test_var);
+  ica.Add("jump_if_n0", test_var, bad_label);
+  table.RemoveEntry( test_var );
+}
+
+void ASTNode_ArrayAccess::CompileRangeError(IC_Array & ica)
+{
+  std::stringstream msg;
+  msg << "ERROR(line " << line_num << "): index out of range for fixed-size array '"
+      << static_cast<ASTNode_Variable *>(children[0])->GetVarEntry()->GetName() << "'" << std::endl;
+  for (char c : msg.str()) ica.Add("out_char", CharConst(c));
+}
+
 tableEntry * ASTNode_ArrayAccess::CompileTubeIC(symbolTable & table, IC_Array & ica)
 {
   tableEntry * in_var0 = children[0]->CompileTubeIC(table, ica);
+
+  // The elements of a fixed-size array are variables in consecutive memory cells: a
+  // constant index picks one out directly, and any other index is added to the address
+  // of the first to load it (arguments 3 and 4 give the cells the load might touch).
+  // An index out of range reads as 0, after an error, as it does for other arrays.
+  if (Type::IsFixedArray(in_var0->GetType())) {
+    const std::vector<tableEntry *> & elements = in_var0->GetElements();
+    EvalState state;
+    double index;
+    if (children[1]->Evaluate(state, index) && state.vars.size() == 0) {
+      if (index < 0 || index >= elements.size() || index != (int) index) {
+        std::stringstream msg;
+        msg << "index " << index << " is out of range for fixed-size array '" << in_var0->GetName()
+            << "' (size " << elements.size() << ")";
+        yyerror2(msg.str(), line_num);
+        exit(1);
+      }
+      return elements[(int) index];
+    }
+    const std::string bad_label = table.NextLabelID("fixed_index_bad_");
+    const std::string done_label = table.NextLabelID("fixed_index_done_");
+    tableEntry * addr_var = CompileFixedAddress(table, ica);
+    CompileRangeCheck(table, ica, addr_var, bad_label);
+    tableEntry * out_var = table.GetTempVar(type);
+    ica.Add("load", addr_var, out_var, std::to_string(in_var0->GetVarID()))
+      .AddArg(std::to_string(elements.size()));
+    ica.Add("jump", done_label);
+    ica.AddLabel(bad_label);
+    CompileRangeError(ica);
+    ica.Add("val_copy", "0", out_var);
+    ica.AddLabel(done_label);
+    table.RemoveEntry( addr_var );
+    return out_var;
+  }
+
   tableEntry * in_var1 = children[1]->CompileTubeIC(table, ica);
   tableEntry * out_var = table.GetTempVar(type);
     
@@ -372,7 +716,7 @@ tableEntry * ASTNode_ArrayAccess::CompileTubeIC(symbolTable & table, IC_Array &
 // ASTNode_FunctionCall
 
 ASTNode_FunctionCall::ASTNode_FunctionCall(tableFunction * in_fun, symbolTable & table)
-    : ASTNode(in_fun->GetReturnType()), fun_entry(in_fun)
+    : ASTNode(in_fun->GetReturnType()), fun_entry(in_fun), caller(table.GetCurFunction())
 {
   // If we are currently in a function definition, track all internal variables
   // to backup in case of recursion.
@@ -388,29 +732,73 @@ ASTNode_FunctionCall::ASTNode_FunctionCall(tableFunction * in_fun, symbolTable &
   }
 }
 
+void ASTNode_FunctionCall::CollectEffects(FunctionEffects & effects)
+{
+  effects.calls.insert(fun_entry);
+  ASTNode::CollectEffects(effects);
+}
+
 tableEntry * ASTNode_FunctionCall::CompileTubeIC(symbolTable & table, IC_Array & ica)
 {
-  // Collect all of the arguments, but don't yet transfer them into place.
+  // If the call only needs constants (and touches nothing outside itself), work out
+  // the result now and skip the call entirely.
+  EvalState state;
+  double result;
+  std::string result_str;
+  if (Evaluate(state, result) && state.vars.size() == 0 && ConstString(result, result_str)) {
+    tableEntry * out_var = table.GetTempVar(type);
+    ica.Add("val_copy", result_str, out_var, "", "Call evaluated at compile time.");
+    return out_var;
+  }
+
+  // Note which arguments are constants; if there are any, call a copy of the function
+  // specialized for them instead (when one can be made).
   const std::vector<tableEntry *> & fun_args = fun_entry->GetArgs();
-  std::vector<tableEntry *> arg_result_vars(children.size());
+  std::vector<std::string> const_args(children.size());
+  bool any_const = false;
   for (int i = 0; i < (int) children.size(); i++) {
-    arg_result_vars[i] = children[i]->CompileTubeIC(table, ica);
+    EvalState arg_state;
+    double arg_value;
+    if (fun_args[i]->IsScalar() && children[i]->Evaluate(arg_state, arg_value) &&
+        arg_state.vars.size() == 0 && ConstString(arg_value, const_args[i])) {
+      any_const = true;
+    } else {
+      const_args[i] = "";
+    }
+  }
+  std::string call_label = fun_entry->GetCallLabel();
+  if (any_const) call_label = fun_entry->GetCloneLabel(const_args, table.GetCloneBudget());
+  if (call_label == "") {
+    call_label = fun_entry->GetCallLabel();
+    const_args.assign(children.size(), "");
+  }
+
+  // Collect all of the other arguments, but don't yet transfer them into place.
+  std::vector<tableEntry *> arg_result_vars(children.size(), NULL);
+  for (int i = 0; i < (int) children.size(); i++) {
+    if (const_args[i] == "") arg_result_vars[i] = children[i]->CompileTubeIC(table, ica);
   }
 
   // Determine the names of the labels that we will be using.
-  std::string call_label = fun_entry->GetCallLabel();
   std::string return_label = table.NextLabelID("function_return_");
 
+  // Variables only need to be backed up if the call can come back around to this same
+  // function (i.e., they are in the same group of mutually recursive functions).
+  const bool recursive = caller != NULL && caller->GetSCC() == fun_entry->GetSCC();
+  const std::vector<tableEntry *> no_vars;
+  const std::vector<tableEntry *> & backup_vars = recursive ? this->backup_vars : no_vars;
+
   // Determine which temporary variables we need to backup before making the call.
   std::vector<int> backup_temp_scalars;
-  backup_temp_scalars.insert(backup_temp_scalars.begin(),
-                             table.GetTempScalars().begin(),
-                             table.GetTempScalars().end());
-  
   std::vector<int> backup_temp_arrays;
-  backup_temp_arrays.insert(backup_temp_arrays.begin(),
-                            table.GetTempArrays().begin(),
-                            table.GetTempArrays().end());
+  if (recursive) {
+    backup_temp_scalars.insert(backup_temp_scalars.begin(),
+                               table.GetTempScalars().begin(),
+                               table.GetTempScalars().end());
+    backup_temp_arrays.insert(backup_temp_arrays.begin(),
+                              table.GetTempArrays().begin(),
+                              table.GetTempArrays().end());
+  }
 
   // Backup all of the local variables.
   for (tableEntry * cur_var : backup_vars) {
@@ -436,6 +824,7 @@ tableEntry * ASTNode_FunctionCall::CompileTubeIC(symbolTable & table, IC_Array &
   // Put the new function arguments into place (any old ones are backed up).
   for (int i = 0; i < (int) arg_result_vars.size(); i++) {
     tableEntry * cur_var = arg_result_vars[i];
+    if (cur_var == NULL) continue;          // Built into the specialized copy.
     if (Type::IsArray(cur_var->GetType())) {  // Array!
       ica.Add("ar_copy", cur_var, fun_args[i]);
     } else {                                  // Regular variable.
@@ -480,6 +869,31 @@ tableEntry * ASTNode_FunctionCall::CompileTubeIC(symbolTable & table, IC_Array &
   return out_var;
 }
 
+bool ASTNode_FunctionCall::Evaluate(EvalState & state, double & value)
+{
+  ASTNode * body = fun_entry->GetAST();
+  if (body == NULL || !Type::IsScalar(type) || type == Type::VOID) return false;
+  if (!UseFuel(state) || state.depth >= 100) return false;
+
+  // Work out the arguments, then run the body with only the parameters set.
+  const std::vector<tableEntry *> & fun_args = fun_entry->GetArgs();
+  std::map<int, double> call_vars;
+  for (int i = 0; i < (int) children.size(); i++) {
+    if (!fun_args[i]->IsScalar() || !children[i]->Evaluate(state, value)) return false;
+    call_vars[fun_args[i]->GetVarID()] = value;
+  }
+
+  call_vars.swap(state.vars);
+  state.depth++;
+  bool ok = body->Evaluate(state, value) && state.flow == EvalState::RETURN;
+  state.depth--;
+  call_vars.swap(state.vars);
+
+  state.flow = EvalState::NEXT;
+  value = state.result;
+  return ok;
+}
+
 
 void ASTNode_FunctionCall::TypeCheckArgs()
 {
@@ -526,8 +940,17 @@ ASTNode_MethodCall::ASTNode_MethodCall(ASTNode * in_base, std::string in_name)
     exit(1);
   }
 
+  // A fixed-size array's size is part of its type.
+  if (Type::IsFixedArray(in_base->GetType()) && name != "size") {
+    std::string err_message = "cannot ";
+    err_message += name;
+    err_message += "() a fixed-size array";
+    yyerror(err_message);
+    exit(1);
+  }
+
   // @CAO For the moment, require the base to be an array.
-  if (!Type::IsArray(in_base->GetType())) {
+  if (!Type::IsArray(in_base->GetType()) && !Type::IsFixedArray(in_base->GetType())) {
     std::string err_message = "array methods cannot be run on type '";
     err_message += Type::AsString(in_base->GetType());
     err_message += "'";
@@ -537,12 +960,37 @@ ASTNode_MethodCall::ASTNode_MethodCall(ASTNode * in_base, std::string in_name)
 }
 
 
+void ASTNode_MethodCall::CollectEffects(FunctionEffects & effects)
+{
+  if (name == "size") {
+    ASTNode::CollectEffects(effects);
+    return;
+  }
+
+  // Every other method changes the array.
+  effects.mutates_arrays = true;
+  NoteWrite(children[0], effects);
+  for (int i = 1; i < (int) children.size(); i++) children[i]->CollectEffects(effects);
+}
+
+bool ASTNode_MethodCall::Evaluate(EvalState & state, double & value)
+{
+  if (name != "size" || !Type::IsFixedArray(children[0]->GetType()) || !UseFuel(state)) return false;
+  ASTNode_Variable * array_node = dynamic_cast<ASTNode_Variable *>(children[0]);
+  if (array_node == NULL) return false;
+  value = array_node->GetVarEntry()->GetElements().size();
+  return true;
+}
+
 tableEntry * ASTNode_MethodCall::CompileTubeIC(symbolTable & table, IC_Array & ica)
 {
   tableEntry * array_var = children[0]->CompileTubeIC(table, ica);
   tableEntry * out_var = table.GetTempVar(type);
 
-  if (name == "size") {
+  if (Type::IsFixedArray(array_var->GetType())) {
+    ica.Add("val_copy", std::to_string(array_var->GetElements().size()), out_var);
+  }
+  else if (name == "size") {
     ica.Add("ar_get_siz", array_var, out_var);
   }
   else if (name == "resize") {
@@ -668,6 +1116,15 @@ tableEntry * ASTNode_If::CompileTubeIC(symbolTable & table, IC_Array & ica)
   return NULL;
 }
 
+bool ASTNode_If::Evaluate(EvalState & state, double & value)
+{
+  if (!UseFuel(state) || !children[0]->Evaluate(state, value)) return false;
+  ASTNode * branch = (value != 0.0) ? children[1] : children[2];
+  if (branch && !branch->Evaluate(state, value)) return false;
+  value = 0.0;
+  return true;
+}
+
 
 /////////////////////
 // ASTNode_While
@@ -716,6 +1173,19 @@ tableEntry * ASTNode_While::CompileTubeIC(symbolTable & table, IC_Array & ica)
   return NULL;
 }
 
+bool ASTNode_While::Evaluate(EvalState & state, double & value)
+{
+  while (true) {
+    if (!UseFuel(state) || !children[0]->Evaluate(state, value)) return false;
+    if (value == 0.0) break;
+    if (!EvaluateLoopBody(children[1], state)) return false;
+    if (state.flow != EvalState::NEXT) break;
+  }
+  if (state.flow == EvalState::BREAK) state.flow = EvalState::NEXT;
+  value = 0.0;
+  return true;
+}
+
 
 /////////////////////
 // ASTNode_For
@@ -786,6 +1256,210 @@ tableEntry * ASTNode_For::CompileTubeIC(symbolTable & table, IC_Array & ica)
   return NULL;
 }
 
+bool ASTNode_For::Evaluate(EvalState & state, double & value)
+{
+  ASTNode * node_init = children[0];
+  ASTNode * node_test = children[1];
+  ASTNode * node_inc  = children[2];
+  ASTNode * node_body = children[3];
+
+  if (node_init && !node_init->Evaluate(state, value)) return false;
+  while (true) {
+    if (!UseFuel(state)) return false;
+    if (node_test) {
+      if (!node_test->Evaluate(state, value)) return false;
+      if (value == 0.0) break;
+    }
+    if (!EvaluateLoopBody(node_body, state)) return false;
+    if (state.flow != EvalState::NEXT) break;
+    if (node_inc && !node_inc->Evaluate(state, value)) return false;
+  }
+  if (state.flow == EvalState::BREAK) state.flow = EvalState::NEXT;
+  value = 0.0;
+  return true;
+}
+
+
+/////////////////////
+// ASTNode_Switch
+
+ASTNode_Switch::ASTNode_Switch(ASTNode * selector)
+  : ASTNode(Type::VOID), default_id(-1)
+{
+  if (selector->GetType() != Type::VALUE && selector->GetType() != Type::CHAR) {
+    std::string err_message = "switch selector must be of type 'val' or 'char' (found '";
+    err_message += Type::AsString(selector->GetType());
+    err_message += "')";
+    yyerror(err_message);
+    exit(1);
+  }
+
+  children.push_back(selector);
+}
+
+
+void ASTNode_Switch::CheckCases()
+{
+  std::vector<ASTNode *> case_list(children.begin() + 1, children.end());
+  children.resize(1);
+  case_values.assign(1, 0.0);
+
+  for (int i = 0; i + 1 < (int) case_list.size(); i += 2) {
+    ASTNode * value_node = case_list[i];
+    if (value_node == NULL) {
+      if (default_id != -1) {
+        yyerror("switch has more than one default case");
+        exit(1);
+      }
+      default_id = (int) children.size();
+      children.push_back(case_list[i+1]);
+      case_values.push_back(0.0);
+      continue;
+    }
+
+    if (value_node->GetType() != children[0]->GetType()) {
+      std::string err_message = "case value of type '";
+      err_message += Type::AsString(value_node->GetType());
+      err_message += "' does not match switch type '";
+      err_message += Type::AsString(children[0]->GetType());
+      err_message += "'";
+      yyerror2(err_message, value_node->GetLineNum());
+      exit(1);
+    }
+
+    // Case values must be constants, each used only once.
+    EvalState state;
+    double value = 0.0;
+    std::string value_str;
+    if (!value_node->Evaluate(state, value) || state.vars.size() != 0 || !ConstString(value, value_str)) {
+      yyerror2("case values must be constants", value_node->GetLineNum());
+      exit(1);
+    }
+    for (int k = 1; k < (int) case_values.size(); k++) {
+      if (k == default_id || case_values[k] != value) continue;
+      yyerror2("duplicate case value '" + value_str + "' in switch", value_node->GetLineNum());
+      exit(1);
+    }
+    delete value_node;
+
+    children.push_back(case_list[i+1]);
+    case_values.push_back(value);
+  }
+}
+
+
+void ASTNode_Switch::CompileDispatch(symbolTable & table, IC_Array & ica, tableEntry * selector,
+                                     const std::vector<std::pair<double, std::string> > & cases,
+                                     int begin, int end, const std::string & default_label)
+{
+  const int min_table_cases = 5;    // Fewer cases are quicker to test one by one
+  const int max_table_slots = 3;    // Largest table allowed, per case in it
+  const int max_test_cases = 3;     // Largest group of cases tested one by one
+
+  const int count = end - begin;
+  const double low = cases[begin].first;
+  const double span = cases[end-1].first - low + 1.0;
+  bool whole = std::fabs(low) < 1e9;
+  for (int i = begin; i < end; i++) {
+    if (cases[i].first != std::floor(cases[i].first)) whole = false;
+  }
+  tableEntry * test_var = table.GetTempVar(Type::VALUE);
+
+  if (count >= min_table_cases && whole && span <= max_table_slots * count) {
+    // A dense run of whole numbers jumps straight through a table of labels.  The
+    // offset must come through "mod" unchanged, which only a whole number smaller
+    // than the table size does; negative ones go to the default.
+    std::string low_str, span_str;
+    ConstString(low, low_str);
+    ConstString(span, span_str);
+    tableEntry * offset_var = selector;
+    if (low != 0.0) {
+      offset_var = table.GetTempVar(Type::VALUE);
+      ica.Add("sub", selector, low_str, offset_var);
+    }
+    tableEntry * index_var = table.GetTempVar(Type::VALUE);
+    ica.Add("mod", offset_var, span_str, index_var);
+    ica.Add("test_nequ", offset_var, index_var, test_var);
+    ica.Add("jump_if_n0", test_var, default_label);
+    IC_Entry & jump = ica.Add("jump_table", index_var, default_label);
+    for (int value = 0, next = begin; value < (int) span; value++) {
+      if (cases[next].first == low + value) jump.AddArg(cases[next++].second);
+      else jump.AddArg(default_label);
+    }
+    if (offset_var != selector) table.RemoveEntry( offset_var );
+    table.RemoveEntry( index_var );
+  }
+  else if (count <= max_test_cases) {
+    for (int i = begin; i < end; i++) {
+      std::string value_str;
+      ConstString(cases[i].first, value_str);
+      ica.Add("test_equ", selector, value_str, test_var);
+      ica.Add("jump_if_n0", test_var, cases[i].second);
+    }
+    ica.Add("jump", default_label);
+  }
+  else {
+    // Otherwise, split the cases in half and look in the half the selector falls in.
+    const int mid = begin + count / 2;
+    const std::string upper_label = table.NextLabelID("switch_upper_");
+    std::string mid_str;
+    ConstString(cases[mid].first, mid_str);
+    ica.Add("test_gte", selector, mid_str, test_var);
+    ica.Add("jump_if_n0", test_var, upper_label);
+    CompileDispatch(table, ica, selector, cases, begin, mid, default_label);
+    ica.AddLabel(upper_label);
+    CompileDispatch(table, ica, selector, cases, mid, end, default_label);
+  }
+
+  table.RemoveEntry( test_var );
+}
+
+
+tableEntry * ASTNode_Switch::CompileTubeIC(symbolTable & table, IC_Array & ica)
+{
+  std::string end_label = table.NextLabelID("switch_end_");
+
+  // Give each body a label, and sort the cases by value to find the right one quickly.
+  std::vector<std::string> body_labels(children.size(), end_label);
+  std::vector<std::pair<double, std::string> > cases;
+  for (int i = 1; i < (int) children.size(); i++) {
+    body_labels[i] = table.NextLabelID(i == default_id ? "switch_default_" : "switch_case_");
+    if (i != default_id) cases.push_back(std::make_pair(case_values[i], body_labels[i]));
+  }
+  std::sort(cases.begin(), cases.end());
+  const std::string & default_label = body_labels[default_id == -1 ? 0 : default_id];
+
+  tableEntry * in_var0 = children[0]->CompileTubeIC(table, ica);
+  if (cases.size()) CompileDispatch(table, ica, in_var0, cases, 0, (int) cases.size(), default_label);
+  else ica.Add("jump", default_label);
+  if (in_var0->GetTemp() == true) table.RemoveEntry( in_var0 );
+
+  // Only the chosen body runs; then leave the switch.
+  for (int i = 1; i < (int) children.size(); i++) {
+    ica.AddLabel(body_labels[i]);
+    if (children[i]) {
+      tableEntry * in_var = children[i]->CompileTubeIC(table, ica);
+      if (in_var && in_var->GetTemp() == true) table.RemoveEntry( in_var );
+    }
+    if (i + 1 < (int) children.size()) ica.Add("jump", end_label);
+  }
+  ica.AddLabel(end_label);
+
+  return NULL;
+}
+
+bool ASTNode_Switch::Evaluate(EvalState & state, double & value)
+{
+  if (!UseFuel(state) || !children[0]->Evaluate(state, value)) return false;
+  int body_id = default_id;
+  for (int i = 1; i < (int) children.size(); i++) {
+    if (i != default_id && case_values[i] == value) body_id = i;
+  }
+  if (body_id != -1 && children[body_id] && !children[body_id]->Evaluate(state, value)) return false;
+  value = 0.0;
+  return true;
+}
+
 
 /////////////////////
 // ASTNode_Break
@@ -808,6 +1482,12 @@ tableEntry * ASTNode_Break::CompileTubeIC(symbolTable & table, IC_Array & ica)
   return NULL;
 }
 
+bool ASTNode_Break::Evaluate(EvalState & state, double & value)
+{
+  state.flow = EvalState::BREAK;
+  return UseFuel(state);
+}
+
 
 /////////////////////
 // ASTNode_Continue
@@ -830,6 +1510,12 @@ tableEntry * ASTNode_Continue::CompileTubeIC(symbolTable & table, IC_Array & ica
   return NULL;
 }
 
+bool ASTNode_Continue::Evaluate(EvalState & state, double & value)
+{
+  state.flow = EvalState::CONTINUE;
+  return UseFuel(state);
+}
+
 
 /////////////////////
 // ASTNode_Print
@@ -842,10 +1528,45 @@ ASTNode_Print::ASTNode_Print(ASTNode * out_child)
 }
 
 
+void ASTNode_Print::CollectEffects(FunctionEffects & effects)
+{
+  effects.does_output = true;
+  ASTNode::CollectEffects(effects);
+}
+
 tableEntry * ASTNode_Print::CompileTubeIC(symbolTable & table, IC_Array & ica)
 {
+  // Text known at compile time (string literals and constant chars) is written out a
+  // character at a time, with no array to build or loop over; runs of it are collected
+  // so they come out together.  Constant values are printed without a temporary.
+  std::string text;
+  auto flush_text = [&text, &ica]() {
+    for (char c : text) ica.Add("out_char", CharConst(c));
+    text = "";
+  };
+
   // Collect the output arguments as they are calculated...
   for (int i = 0; i < (int) children.size(); i++) {
+    std::string str_value, const_str;
+    EvalState state;
+    double value;
+    ASTNode_Literal * literal = dynamic_cast<ASTNode_Literal *>(children[i]);
+    if (literal && literal->GetString(str_value)) {
+      text += str_value;
+      continue;
+    }
+    if (Type::IsScalar(children[i]->GetType()) && children[i]->Evaluate(state, value) &&
+        state.vars.size() == 0 && ConstString(value, const_str)) {
+      if (children[i]->GetType() == Type::CHAR) {
+        text += (char) value;
+        continue;
+      }
+      flush_text();
+      ica.Add("out_val", const_str);
+      continue;
+    }
+    flush_text();
+
     tableEntry * cur_var = children[i]->CompileTubeIC(table, ica);
     switch (cur_var->GetType()) {
     case Type::VALUE:
@@ -888,6 +1609,31 @@ tableEntry * ASTNode_Print::CompileTubeIC(symbolTable & table, IC_Array & ica)
         table.FreeTempVar(entry_var);
       }
       break;
+    case Type::FIXED_VALUE_ARRAY:
+      {
+        // The elements are in consecutive cells, so just step an address across them.
+        const std::string first = std::to_string(cur_var->GetVarID());
+        const std::string count = std::to_string(cur_var->GetElements().size());
+        const std::string end = std::to_string(cur_var->GetVarID() + cur_var->GetElements().size());
+        tableEntry * addr_var = table.GetTempVar(Type::VALUE);
+        tableEntry * entry_var = table.GetTempVar(Type::VALUE);
+        std::string start_label = table.NextLabelID("print_array_start_");
+        std::string end_label = table.NextLabelID("print_array_end_");
+
+        ica.Add("val_copy", first, addr_var, "", "Init loop address for printing array.");
+        ica.AddLabel(start_label);
+        ica.Add("test_gte", addr_var, end, entry_var, "Test if we are finished yet...");
+        ica.Add("jump_if_n0", entry_var, end_label, "", " ...and jump to end if so.");
+        ica.Add("load", addr_var, entry_var, first).AddArg(count);
+        ica.Add("out_val", entry_var, "", "", "Print this entry!");
+        ica.Add("add", addr_var, "1", addr_var, "Increment to the next element.");
+        ica.Add("jump", start_label);
+        ica.AddLabel(end_label);
+
+        table.FreeTempVar(addr_var);
+        table.FreeTempVar(entry_var);
+      }
+      break;
     default:
       std::cerr << "Internal Compiler ERROR: Unknown Type in Write::CompilerTubeIC" << std::endl;
       exit(1);
@@ -895,7 +1641,8 @@ tableEntry * ASTNode_Print::CompileTubeIC(symbolTable & table, IC_Array & ica)
 
     if (cur_var->GetTemp() == true) table.RemoveEntry( cur_var );
   }
-  ica.Add("out_char", "'\\n'", "", "", "End print statements with a newline.");
+  text += '\n';    // End print statements with a newline.
+  flush_text();
   
   return NULL;
 }
@@ -917,6 +1664,12 @@ ASTNode_Random::ASTNode_Random(ASTNode * in_child)
   children.push_back(in_child);
 }
 
+void ASTNode_Random::CollectEffects(FunctionEffects & effects)
+{
+  effects.uses_random = true;
+  ASTNode::CollectEffects(effects);
+}
+
 tableEntry * ASTNode_Random::CompileTubeIC(symbolTable & table, IC_Array & ica)
 {
   tableEntry * in_var = children[0]->CompileTubeIC(table, ica);
@@ -979,6 +1732,14 @@ tableEntry * ASTNode_Return::CompileTubeIC(symbolTable & table, IC_Array & ica)
   return NULL;
 }
 
+bool ASTNode_Return::Evaluate(EvalState & state, double & value)
+{
+  if (!Type::IsScalar(children[0]->GetType())) return false;
+  if (!UseFuel(state) || !children[0]->Evaluate(state, state.result)) return false;
+  state.flow = EvalState::RETURN;
+  return true;
+}
+
 
 //////////////////////
 //  ASTNode_Ternary
@@ -990,6 +1751,10 @@ ASTNode_Ternary::ASTNode_Ternary(ASTNode * child_test, ASTNode * child_true, AST
     yyerror("condition for ternary operators must evaluate to type val");
     exit(1);
   }
+  if (Type::IsFixedArray(child_true->GetType())) {
+    yyerror("ternary operator cannot choose between fixed-size arrays");
+    exit(1);
+  }
   if (child_true->GetType() != child_false->GetType()) {
     std::string err_message = "ternary operator must have matching types; '";
     err_message += Type::AsString(child_true->GetType());
@@ -1037,3 +1802,9 @@ tableEntry * ASTNode_Ternary::CompileTubeIC(symbolTable & table, IC_Array & ica)
 
   return out_var;
 }
+
+bool ASTNode_Ternary::Evaluate(EvalState & state, double & value)
+{
+  if (!Type::IsScalar(type) || !UseFuel(state) || !children[0]->Evaluate(state, value)) return false;
+  return children[(value != 0.0) ? 1 : 2]->Evaluate(state, value);
+}
@@ -1,6 +1,7 @@
 #ifndef AST_H
 #define AST_H
 
+#include <map>
 #include <string>
 #include <vector>
 #include <fstream>
@@ -17,21 +18,34 @@
 // ASTNode_Root : Blocks of statements, including the overall program.
 // ASTNode_Variable : Leaf node containing a variable.
 // ASTNode_Literal : Leaf node contiaing a literal value.
+// ASTNode_ArrayLiteral : A list of elements that make up a new array, as in [1, 2, 3]
 // ASTNode_Assign : Assignements
 // ASTNode_Math1 : One-input math operations (unary '-' and '!')
 // ASTNode_Math2 : Two-input math operations ('+', '-', '*', '/', and comparisons)
 // ASTNode_Bool2 : Two-input bool operations ('&&' and '||')
-// ASTNode_ArrayAccess : Index into an array
+// ASTNode_ArrayAccess : Index into an array (on the heap, or a fixed-size one)
 // ASTNode_FunctionCall : Calls to user-defined functions
 // ASTNode_Return : Return from within a function definition.
 // ASTNode_MethodCall : Currently, array methods .size() and .resize()
 // ASTNode_If    : If-conditional node.
 // ASTNode_While : While-loop node.
 // ASTNode_For   : For-loop node.
+// ASTNode_Switch : Switch node (picks one case body by value)
 // ASTNode_Break : Break node
 // ASTNode_Continue : Continue node
 // ASTNode_Print : Print command
 
+// Working state for running code at compile time; see ASTNode::Evaluate().
+struct EvalState {
+  enum Flow { NEXT, BREAK, CONTINUE, RETURN };
+
+  std::map<int, double> vars;           // Values of the scalars in the current call, by var_id
+  int fuel = 10000;                     // Nodes that may still be evaluated before giving up
+  int depth = 0;                        // Calls currently in progress
+  Flow flow = NEXT;                     // How control leaves the statement just evaluated
+  double result = 0.0;                  // Value given by the last return
+};
+
 class ASTNode {
 protected:
   int type;                        // Type this node will pass up the AST
@@ -57,11 +71,20 @@ public:
 
   void AddChild(ASTNode * in_child) { children.push_back(in_child); }
   void TransferChildren(ASTNode * in_node);
+  int CountNodes();   // Size of this subtree (used to limit copying of function bodies).
 
   // Convert a single node to TubeIC and return information about the
   // variable where the results are saved.  Call children recursively.
   virtual tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica) = 0;
 
+  // Note anything this subtree does besides calculating a value (by default, whatever
+  // its children do).  Used to find pure functions.
+  virtual void CollectEffects(FunctionEffects & effects);
+
+  // Try to calculate this subtree's value without generating any code.  Returns false if
+  // it needs anything that isn't known at compile time (or runs out of fuel).
+  virtual bool Evaluate(EvalState & state, double & value) { return false; }
+
   // Return the name of the node being called.  This function is useful for debbing the AST.
   virtual std::string GetName() { return "ASTNode (base class)"; }
 };
@@ -84,6 +107,7 @@ class ASTNode_Root : public ASTNode {
 public:
   ASTNode_Root() : ASTNode(Type::VOID) { ; }
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
 
   virtual std::string GetName() { return "ASTNode_Root (container class)"; }
 };
@@ -98,6 +122,8 @@ public:
 
   tableEntry * GetVarEntry() { return var_entry; }
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
+  void CollectEffects(FunctionEffects & effects);
 
   virtual std::string GetName() {
     std::string out_string = "ASTNode_Variable (";
@@ -113,6 +139,8 @@ private:
 public:
   ASTNode_Literal(int in_type, std::string in_lex);
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
+  bool GetString(std::string & out);   // The characters of a string literal (false if not one)
 
   virtual std::string GetName() {
     std::string out_string = "ASTNode_Literal (";
@@ -122,6 +150,15 @@ public:
   }
 };
 
+class ASTNode_ArrayLiteral : public ASTNode {
+public:
+  ASTNode_ArrayLiteral(ASTNode * in_list);   // Takes over the elements of an argument list
+  virtual ~ASTNode_ArrayLiteral() { ; }
+
+  tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  virtual std::string GetName() { return "ASTNode_ArrayLiteral"; }
+};
+
 // Math...
 
 class ASTNode_Assign : public ASTNode {
@@ -130,6 +167,8 @@ public:
   ~ASTNode_Assign() { ; }
 
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
+  void CollectEffects(FunctionEffects & effects);
   virtual std::string GetName() { return "ASTNode_Assign (operator=)"; }
 };
 
@@ -142,6 +181,7 @@ public:
   virtual ~ASTNode_Math1() { ; }
 
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
   virtual std::string GetName() {
     std::string out_string = "ASTNode_Math1 (operator";
     out_string += (char) math_op;
@@ -158,7 +198,10 @@ public:
   ASTNode_Math2(ASTNode * in1, ASTNode * in2, int op);
   virtual ~ASTNode_Math2() { ; }
 
+  int GetOp() const { return math_op; }
+
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
   virtual std::string GetName() {
     std::string out_string = "ASTNode_Math2 (operator";
     out_string += (char) math_op;
@@ -176,6 +219,7 @@ public:
   virtual ~ASTNode_Bool2() { ; }
 
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
   virtual std::string GetName() {
     std::string out_string = "ASTNode_Bool2 (operator";
     out_string += (char) bool_op;
@@ -190,6 +234,13 @@ public:
   ASTNode_ArrayAccess(ASTNode * in1, ASTNode * in2);
   virtual ~ASTNode_ArrayAccess() { ; }
 
+  // For an element of a fixed-size array found at run time: its address, code that
+  // goes to bad_label if that is out of range, and the error to print there.
+  tableEntry * CompileFixedAddress(symbolTable & table, IC_Array & ica);
+  void CompileRangeCheck(symbolTable & table, IC_Array & ica, tableEntry * addr_var,
+                         const std::string & bad_label);
+  void CompileRangeError(IC_Array & ica);
+
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
   virtual std::string GetName() {
     std::string out_string = "ASTNode_ArrayAccess";
@@ -201,12 +252,15 @@ public:
 class ASTNode_FunctionCall : public ASTNode {
 protected:
   tableFunction * fun_entry;
+  tableFunction * caller;                 // Function this call is made from (NULL for main code)
   std::vector<tableEntry *> backup_vars;
 public:
   ASTNode_FunctionCall(tableFunction * in_fun, symbolTable & table);
   virtual ~ASTNode_FunctionCall() { ; }
 
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
+  void CollectEffects(FunctionEffects & effects);
   virtual std::string GetName() {
     std::string out_string = "ASTNode_FunctionCall";
     return out_string;
@@ -223,6 +277,8 @@ public:
   virtual ~ASTNode_MethodCall() { ; }
 
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
+  void CollectEffects(FunctionEffects & effects);
   virtual std::string GetName() {
     std::string out_string = "ASTNode_MethodCall";
     return out_string;
@@ -238,6 +294,7 @@ public:
   virtual ~ASTNode_If() { ; }
 
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
   virtual std::string GetName() {
     std::string out_string = "ASTNode_If";
     return out_string;
@@ -251,6 +308,7 @@ public:
   virtual ~ASTNode_While() { ; }
 
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
   virtual std::string GetName() {
     std::string out_string = "ASTNode_While";
     return out_string;
@@ -264,12 +322,40 @@ public:
   virtual ~ASTNode_For() { ; }
 
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
   virtual std::string GetName() {
     std::string out_string = "ASTNode_For";
     return out_string;
   }
 };
 
+// Children are the selector, then one body per case (any of them may be NULL).
+class ASTNode_Switch : public ASTNode {
+protected:
+  std::vector<double> case_values;   // Value that picks each child's body (unused for the default)
+  int default_id;                    // Child holding the default body (-1 if none)
+
+  // Write the code that jumps to the label for the selector's value among cases
+  // [begin, end) of a sorted list, or to default_label if none match.
+  void CompileDispatch(symbolTable & table, IC_Array & ica, tableEntry * selector,
+                       const std::vector<std::pair<double, std::string> > & cases,
+                       int begin, int end, const std::string & default_label);
+public:
+  ASTNode_Switch(ASTNode * selector);
+  virtual ~ASTNode_Switch() { ; }
+
+  // The cases arrive as (value, body) children after the selector, with a NULL value
+  // for the default; check them and keep just the bodies.
+  void CheckCases();
+
+  tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
+  virtual std::string GetName() {
+    std::string out_string = "ASTNode_Switch";
+    return out_string;
+  }
+};
+
 class ASTNode_Break : public ASTNode {
 protected:
 public:
@@ -277,6 +363,7 @@ public:
   virtual ~ASTNode_Break() { ; }
 
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
   virtual std::string GetName() {
     std::string out_string = "ASTNode_Break";
     return out_string;
@@ -290,6 +377,7 @@ public:
   virtual ~ASTNode_Continue() { ; }
 
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
   virtual std::string GetName() {
     std::string out_string = "ASTNode_Continue";
     return out_string;
@@ -302,6 +390,7 @@ public:
   virtual ~ASTNode_Print() {;}
 
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  void CollectEffects(FunctionEffects & effects);
   virtual std::string GetName() { return "ASTNode_Print"; }
 };
 
@@ -311,6 +400,7 @@ public:
   virtual ~ASTNode_Random() { ; }
 
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  void CollectEffects(FunctionEffects & effects);
   virtual std::string GetName() { return "ASTNode_Random"; }
 };
 
@@ -322,6 +412,7 @@ public:
   virtual ~ASTNode_Return() { ; }
 
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
   std::string GetName() {
     std::string out_string = "ASTNode_Return";
     return out_string;
@@ -334,6 +425,7 @@ public:
   virtual ~ASTNode_Ternary() { ; }
 
   tableEntry * CompileTubeIC(symbolTable & table, IC_Array & ica);
+  bool Evaluate(EvalState & state, double & value);
   std::string GetName() { return "ASTNode_Ternary"; }
 };
 
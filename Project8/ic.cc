@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <cmath>
+
 #include "ic.h"
+#include "tube_cost.h"
 
 IC_Entry::IC_Entry(std::string in_inst, std::string in_label, std::string in_cmt)
   : label(in_label), inst(in_inst), comment(in_cmt)
@@ -6,6 +10,12 @@ IC_Entry::IC_Entry(std::string in_inst, std::string in_label, std::string in_cmt
   , store1(false), store2(false), store3(false)
 {
   block = -1;
+  is_call = false;
+  after_call = false;
+  reg_return = -1;
+  array_owned = false;
+  resize_kind = RESIZE_ANY;
+  cycles = 0;
   local_arr = std::vector<bool>(3,false);
 
   if (inst == "") { ; }
@@ -14,6 +24,7 @@ IC_Entry::IC_Entry(std::string in_inst, std::string in_label, std::string in_cmt
   else if (inst == "sub")        { load1 = true; load2 = true; store3 = true; }
   else if (inst == "mult")       { load1 = true; load2 = true; store3 = true; }
   else if (inst == "div")        { load1 = true; load2 = true; store3 = true; }
+  else if (inst == "mod")        { load1 = true; load2 = true; store3 = true; }
   else if (inst == "test_less")  { load1 = true; load2 = true; store3 = true; }
   else if (inst == "test_gtr")   { load1 = true; load2 = true; store3 = true; }
   else if (inst == "test_equ")   { load1 = true; load2 = true; store3 = true; }
@@ -23,6 +34,7 @@ IC_Entry::IC_Entry(std::string in_inst, std::string in_label, std::string in_cmt
   else if (inst == "jump")       { load1 = true; }
   else if (inst == "jump_if_0")  { load1 = true; load2 = true; }
   else if (inst == "jump_if_n0") { load1 = true; load2 = true; }
+  else if (inst == "jump_table") { load1 = true; }
   else if (inst == "nop")        { ; }
   else if (inst == "random")     { load1 = true; store2 = true; }
   else if (inst == "out_val")    { load1 = true; }
@@ -31,6 +43,9 @@ IC_Entry::IC_Entry(std::string in_inst, std::string in_label, std::string in_cmt
   else if (inst == "push")       { load1 = true; }
   else if (inst == "pop")        { store1 = true; }
   
+  else if (inst == "load")       { load1 = true; store2 = true; }
+  else if (inst == "store")      { load1 = true; load2 = true; }
+  
   else if (inst == "ar_get_idx") { load1 = true; load2 = true;  store3 = true; }
   else if (inst == "ar_set_idx") { load1 = true; load2 = true;  load3 = true; }
   else if (inst == "ar_get_siz") { load1 = true; store2 = true; }
@@ -38,6 +53,7 @@ IC_Entry::IC_Entry(std::string in_inst, std::string in_label, std::string in_cmt
   else if (inst == "ar_push")    { load1 = true; }
   else if (inst == "ar_pop")     { store1 = true; }
   else if (inst == "ar_copy")    { load1 = true; store2 = true; }
+  else if (inst == "ar_free")    { load1 = true; }
   else {
     std::cerr << "Internal Compiler Error! Unknown instruction '"
          << inst
@@ -46,6 +62,40 @@ IC_Entry::IC_Entry(std::string in_inst, std::string in_label, std::string in_cmt
 }
 
 
+std::string CharConst(char c)
+{
+  switch (c) {
+  case '\\': return "'\\\\'";
+  case '\t': return "'\\t'";
+  case '\n': return "'\\n'";
+  case '\'': return "'\\''";
+  };
+  return std::string("'") + c + "'";
+}
+
+bool ModValue(double a, double b, double & out)
+{
+  const double limit = 2147483647.0;
+  if (!(std::fabs(a) <= limit && std::fabs(b) <= limit)) return false;
+  const int divisor = (int) b;
+  if (divisor == 0) return false;
+  out = (int) a % divisor;
+  return true;
+}
+
+
+void IC_Entry::Clear()
+{
+  inst = "";
+  args.clear();
+  load1 = load2 = load3 = false;
+  store1 = store2 = store3 = false;
+  is_call = false;
+  array_owned = false;
+  resize_kind = RESIZE_ANY;
+}
+
+
 // Add a tableEntry (i.e. variable) as an argument to this entry.
 void IC_Entry::AddArg(tableEntry * arg)
 {
@@ -108,6 +158,14 @@ void IC_Entry::AddArg(const std::string & arg)
 //   ofs << out_line.str() << std::endl;
 // }
 
+namespace {
+  // Could this argument be a zero divisor?  Only constants can be ruled out.
+  bool MayBeZero(const IC_Argument & arg)
+  {
+    return !arg.IsConst() || arg.str_value.find_first_not_of("-0.") == std::string::npos;
+  }
+}
+
 void IC_Entry::PrintIC(std::ostream & ofs)
 {
   std::stringstream out_line;
@@ -116,6 +174,14 @@ void IC_Entry::PrintIC(std::ostream & ofs)
   if (label != "") { out_line << label << ": "; }
   else { out_line << "  "; }
 
+  // A zero divisor leaves the result alone, so it must start at 0 (as in PrintTubeCode).
+  if (inst == "mod" && MayBeZero(args[1]) && args[2].str_value != args[0].str_value &&
+      args[2].str_value != args[1].str_value) {
+    ofs << out_line.str() << "val_copy 0 " << args[2].str_value << std::endl;
+    out_line.str("");
+    out_line << "  ";
+  }
+
   // If there is an instruction, print it and all its arguments.
   if (inst != "") {
     out_line << inst << " ";
@@ -138,163 +204,953 @@ void IC_Entry::PrintIC(std::ostream & ofs)
 }
 
 
-void IC_Entry::PrintTubeCode(std::ostream & ofs, std::vector<TC_Reg> & registers)
+// Helpers for tracking which variables are cached in which TubeCode registers.
+namespace {
+  int reg_clock = 0;  // Ticks each time a register is touched; used to find the least recent.
+
+  // Arrays live on a heap with a free list for each size class just below it.  An
+  // array is laid out as [size class][capacity][size][elements...] and referred to by
+  // the address of its size cell; its capacity is (min_capacity << size class).
+  const int free_lists = 20000;
+  const int num_size_classes = 32;
+  const int min_capacity = 4;
+
+  // With -gc, the collector keeps its state in the cells after the free lists, and
+  // arrays saved across calls go on their own stack (growing down from the free lists)
+  // so that every array pointer in memory is known to be one.
+  const int gc_limit = free_lists + num_size_classes;   // Collect before the heap grows past this.
+  const int gc_collected = gc_limit + 1;                // Set when the heap was just collected
+  const int gc_saved_size = gc_limit + 2;
+  const int gc_saved_return = gc_limit + 3;
+  const int array_stack_ptr = gc_limit + 4;
+  const int num_gc_cells = 5;
+  const int gc_min_heap = 4096;                         // Smallest heap growth between collections
+
+  int HeapStart() { return free_lists + num_size_classes + (use_gc ? num_gc_cells : 0); }
+
+  // Return the index of the register currently holding var_id, or -1 if it is not cached.
+  int FindReg(const std::vector<TC_Reg> & registers, int var_id)
+  {
+    for (int i = 0; i < (int) registers.size(); i++) {
+      if (registers[i].var_id == var_id) return i;
+    }
+    return -1;
+  }
+
+  bool IsLocked(const std::vector<int> & locked, int reg_id)
+  {
+    for (int i = 0; i < (int) locked.size(); i++) if (locked[i] == reg_id) return true;
+    return false;
+  }
+
+  // Write a register back to its variable's memory cell if it holds a newer value.
+  void SpillReg(std::ostream & ofs, TC_Reg & reg)
+  {
+    if (reg.var_id >= 0 && reg.dirty) {
+      ofs << "  store " << reg.name << " " << reg.var_id << std::endl;
+    }
+    reg.dirty = false;
+  }
+
+  // Save the cached registers; dedicated (pinned) ones only when leaving their code.
+  void FlushRegs(std::ostream & ofs, std::vector<TC_Reg> & registers, bool with_pinned=false)
+  {
+    for (int i = 0; i < (int) registers.size(); i++) {
+      if (with_pinned || !registers[i].pinned) SpillReg(ofs, registers[i]);
+    }
+  }
+
+  void ClearRegs(std::vector<TC_Reg> & registers)
+  {
+    for (int i = 0; i < (int) registers.size(); i++) {
+      if (registers[i].pinned) continue;
+      registers[i].var_id = -1;
+      registers[i].dirty = false;
+    }
+  }
+
+  // After the registers have been overwritten, restore the pinned variables still needed.
+  void ReloadPinned(std::ostream & ofs, std::vector<TC_Reg> & registers,
+                    const std::set<int> & live, int skip_var=-1)
+  {
+    for (int i = 0; i < (int) registers.size(); i++) {
+      TC_Reg & reg = registers[i];
+      if (!reg.pinned || reg.var_id == skip_var) continue;
+      if (live.count(reg.var_id)) ofs << "  load " << reg.var_id << " " << reg.name << std::endl;
+      reg.dirty = false;
+    }
+  }
+
+  // Forget about a variable that is no longer needed (no store required).  A pinned
+  // register keeps its variable, and any unsaved change to it, so that the next
+  // call or return still stores it (it may be a global the caller reads).
+  void ReleaseVar(std::vector<TC_Reg> & registers, int var_id)
+  {
+    int reg_id = FindReg(registers, var_id);
+    if (reg_id == -1 || registers[reg_id].pinned) return;
+    registers[reg_id].var_id = -1;
+    registers[reg_id].dirty = false;
+  }
+
+  // Cycles needed to empty a register (a store, if it holds an unsaved value).
+  int EvictCost(const TC_Reg & reg)
+  {
+    return reg.dirty ? cost_table.TubeCode("store") : 0;
+  }
+
+  // Pick a register to reuse, preferring empty ones, then the cheapest to evict,
+  // then whichever was used least recently.  Any value evicted is saved first.
+  int PickReg(std::ostream & ofs, std::vector<TC_Reg> & registers, const std::vector<int> & locked)
+  {
+    int best = -1;
+    for (int i = 0; i < (int) registers.size(); i++) {
+      if (IsLocked(locked, i) || registers[i].pinned) continue;
+      const TC_Reg & reg = registers[i];
+      if (reg.var_id == -1) { best = i; break; }
+      if (best == -1) { best = i; continue; }
+      const TC_Reg & best_reg = registers[best];
+      if (EvictCost(reg) != EvictCost(best_reg)) { if (EvictCost(reg) < EvictCost(best_reg)) best = i; }
+      else if (reg.last_use < best_reg.last_use) best = i;
+    }
+    SpillReg(ofs, registers[best]);
+    registers[best].var_id = -1;
+    registers[best].last_use = ++reg_clock;
+    return best;
+  }
+
+  // Make sure an argument is available to read: constants are used directly and
+  // variables are loaded only if they are not already sitting in a register.
+  std::string FetchArg(const IC_Argument & arg, std::ostream & ofs,
+                       std::vector<TC_Reg> & registers, std::vector<int> & locked)
+  {
+    if (arg.IsConst()) return arg.str_value;
+    int reg_id = FindReg(registers, arg.var_id);
+    if (reg_id == -1) {
+      reg_id = PickReg(ofs, registers, locked);
+      ofs << "  load " << arg.var_id << " " << registers[reg_id].name << std::endl;
+      registers[reg_id].var_id = arg.var_id;
+    }
+    registers[reg_id].last_use = ++reg_clock;
+    locked.push_back(reg_id);
+    return registers[reg_id].name;
+  }
+
+  // Choose the register an instruction will write a variable into.  The store to
+  // memory is deferred until the register is needed or the block ends.
+  int ClaimArg(const IC_Argument & arg, std::ostream & ofs,
+               std::vector<TC_Reg> & registers, std::vector<int> & locked)
+  {
+    int reg_id = FindReg(registers, arg.var_id);
+    if (reg_id == -1) {
+      reg_id = PickReg(ofs, registers, locked);
+      registers[reg_id].var_id = arg.var_id;
+    }
+    registers[reg_id].dirty = true;
+    registers[reg_id].last_use = ++reg_clock;
+    locked.push_back(reg_id);
+    return reg_id;
+  }
+
+  // Move values being passed in registers into place: vars[k] goes into register k.
+  // Everything else has already been saved, so any other register may be overwritten.
+  void PassInRegisters(std::ostream & ofs, const std::vector<TC_Reg> & registers,
+                       const std::vector<int> & vars)
+  {
+    const int num_vars = (int) vars.size();
+    std::vector<int> from(num_vars);
+    for (int k = 0; k < num_vars; k++) from[k] = FindReg(registers, vars[k]);
+    std::vector<bool> done(num_vars, false);
+    int remaining = num_vars;
+    while (remaining > 0) {
+      bool progress = false;
+      for (int k = 0; k < num_vars; k++) {
+        if (done[k]) continue;
+        bool blocked = false;   // Is register k still holding a value that has to move?
+        for (int j = 0; j < num_vars; j++) if (!done[j] && j != k && from[j] == k) blocked = true;
+        if (blocked) continue;
+        if (from[k] == -1) ofs << "  load " << vars[k] << " " << registers[k].name << std::endl;
+        else if (from[k] != k) {
+          ofs << "  val_copy " << registers[from[k]].name << " " << registers[k].name << std::endl;
+        }
+        done[k] = true;
+        remaining--;
+        progress = true;
+      }
+      if (progress) continue;
+
+      // The values need to rotate; move one into a spare register to break the cycle.
+      int k = 0;
+      while (done[k]) k++;
+      int spare = num_vars;
+      while (std::find(from.begin(), from.end(), spare) != from.end()) spare++;
+      ofs << "  val_copy " << registers[from[k]].name << " " << registers[spare].name << std::endl;
+      from[k] = spare;
+    }
+  }
+
+  // Is this entry a calculation whose results are never used?
+  bool IsDeadCode(const IC_Entry & entry)
+  {
+    static const std::set<std::string> pure_insts = {
+      "val_copy", "add", "sub", "mult", "test_less", "test_gtr", "test_equ", "test_nequ",
+      "test_gte", "test_lte", "load", "ar_get_idx", "ar_get_siz"
+    };
+    if (pure_insts.count(entry.inst) == 0) return false;
+    for (int i = 0; i < (int) entry.args.size(); i++) {
+      if (entry.IsStore(i) && !entry.args[i].final_use) return false;
+    }
+    return true;
+  }
+
+  // The mark-compact collector, run by the allocator when the heap reaches gc_limit.
+  // Roots are the array variables and the array stack; a live block's class cell is
+  // marked with -1 and then replaced by the (negated) address it will move to, and its
+  // class is worked out again from the capacity once it has moved.  Memory freed at
+  // the top of the heap is zeroed, and the free lists are emptied since the blocks on
+  // them are either gone or still in use.
+  void PrintCollector(std::ostream & ofs, const std::set<int> & roots)
+  {
+    const int heap_start = HeapStart();
+    ofs << "tube_gc:" << std::endl
+        << "  store regE " << gc_saved_size << std::endl
+        << "  store regG " << gc_saved_return << std::endl;
+
+    // Mark the blocks that can be reached.
+    for (int var_id : roots) {
+      ofs << "  load " << var_id << " regA" << std::endl
+          << "  jump_if_0 regA tube_gc_mark_" << var_id << std::endl
+          << "  sub regA 2 regA" << std::endl
+          << "  store -1 regA" << std::endl
+          << "tube_gc_mark_" << var_id << ":" << std::endl;
+    }
+    ofs << "  load " << array_stack_ptr << " regB" << std::endl
+        << "tube_gc_mark_stack:" << std::endl
+        << "  test_gte regB " << free_lists << " regC" << std::endl
+        << "  jump_if_n0 regC tube_gc_plan_start" << std::endl
+        << "  load regB regA" << std::endl
+        << "  add regB 1 regB" << std::endl
+        << "  jump_if_0 regA tube_gc_mark_stack" << std::endl
+        << "  sub regA 2 regA" << std::endl
+        << "  store -1 regA" << std::endl
+        << "  jump tube_gc_mark_stack" << std::endl;
+
+    // Work out where each marked block will slide down to.
+    ofs << "tube_gc_plan_start:" << std::endl
+        << "  val_copy " << heap_start << " regA                   # regA = block being considered" << std::endl
+        << "  val_copy " << heap_start << " regB                   # regB = where the next kept block goes" << std::endl
+        << "  load 0 regC" << std::endl
+        << "tube_gc_plan:" << std::endl
+        << "  test_gte regA regC regD" << std::endl
+        << "  jump_if_n0 regD tube_gc_update" << std::endl
+        << "  add regA 1 regD" << std::endl
+        << "  load regD regD                        # Capacity" << std::endl
+        << "  load regA regE" << std::endl
+        << "  test_less regE 0 regE" << std::endl
+        << "  jump_if_0 regE tube_gc_plan_next" << std::endl
+        << "  sub 0 regB regE" << std::endl
+        << "  sub regE 2 regE" << std::endl
+        << "  store regE regA                       # Forwarding address" << std::endl
+        << "  add regB regD regB" << std::endl
+        << "  add regB 3 regB" << std::endl
+        << "tube_gc_plan_next:" << std::endl
+        << "  add regA regD regA" << std::endl
+        << "  add regA 3 regA" << std::endl
+        << "  jump tube_gc_plan" << std::endl;
+
+    // Point the roots at the new locations.
+    ofs << "tube_gc_update:" << std::endl;
+    for (int var_id : roots) {
+      ofs << "  load " << var_id << " regA" << std::endl
+          << "  jump_if_0 regA tube_gc_update_" << var_id << std::endl
+          << "  sub regA 2 regB" << std::endl
+          << "  load regB regB" << std::endl
+          << "  sub 0 regB regB" << std::endl
+          << "  store regB " << var_id << std::endl
+          << "tube_gc_update_" << var_id << ":" << std::endl;
+    }
+    ofs << "  load " << array_stack_ptr << " regC" << std::endl
+        << "tube_gc_update_stack:" << std::endl
+        << "  test_gte regC " << free_lists << " regD" << std::endl
+        << "  jump_if_n0 regD tube_gc_move_start" << std::endl
+        << "  load regC regA" << std::endl
+        << "  jump_if_0 regA tube_gc_update_next" << std::endl
+        << "  sub regA 2 regB" << std::endl
+        << "  load regB regB" << std::endl
+        << "  sub 0 regB regB" << std::endl
+        << "  store regB regC" << std::endl
+        << "tube_gc_update_next:" << std::endl
+        << "  add regC 1 regC" << std::endl
+        << "  jump tube_gc_update_stack" << std::endl;
+
+    // Slide the marked blocks down, copying just the elements in use.
+    ofs << "tube_gc_move_start:" << std::endl
+        << "  val_copy " << heap_start << " regA" << std::endl
+        << "  val_copy " << heap_start << " regB" << std::endl
+        << "  load 0 regC" << std::endl
+        << "tube_gc_move:" << std::endl
+        << "  test_gte regA regC regD" << std::endl
+        << "  jump_if_n0 regD tube_gc_moved" << std::endl
+        << "  add regA 1 regD" << std::endl
+        << "  load regD regD                        # Capacity" << std::endl
+        << "  load regA regE" << std::endl
+        << "  test_less regE 0 regF" << std::endl
+        << "  jump_if_0 regF tube_gc_move_next" << std::endl
+        << "  add regA 2 regF" << std::endl
+        << "  load regF regF                        # Size (a list link if the block was freed)" << std::endl
+        << "  test_gtr regF regD regG" << std::endl
+        << "  jump_if_0 regG tube_gc_copy_start" << std::endl
+        << "  val_copy regD regF" << std::endl
+        << "tube_gc_copy_start:" << std::endl
+        << "  add regA 2 regE" << std::endl
+        << "  add regB 2 regG" << std::endl
+        << "  add regF 1 regF" << std::endl
+        << "tube_gc_copy:" << std::endl
+        << "  jump_if_0 regF tube_gc_class_start" << std::endl
+        << "  mem_copy regE regG" << std::endl
+        << "  add regE 1 regE" << std::endl
+        << "  add regG 1 regG" << std::endl
+        << "  sub regF 1 regF" << std::endl
+        << "  jump tube_gc_copy" << std::endl
+        << "tube_gc_class_start:" << std::endl
+        << "  val_copy 0 regE" << std::endl
+        << "  val_copy " << min_capacity << " regF" << std::endl
+        << "tube_gc_class:" << std::endl
+        << "  test_gte regF regD regG" << std::endl
+        << "  jump_if_n0 regG tube_gc_class_found" << std::endl
+        << "  add regF regF regF" << std::endl
+        << "  add regE 1 regE" << std::endl
+        << "  jump tube_gc_class" << std::endl
+        << "tube_gc_class_found:" << std::endl
+        << "  store regE regB" << std::endl
+        << "  add regB 1 regB" << std::endl
+        << "  store regD regB" << std::endl
+        << "  add regB regD regB" << std::endl
+        << "  add regB 2 regB" << std::endl
+        << "tube_gc_move_next:" << std::endl
+        << "  add regA regD regA" << std::endl
+        << "  add regA 3 regA" << std::endl
+        << "  jump tube_gc_move" << std::endl;
+
+    // Clean up after the move and set the next limit to leave room for as much again.
+    ofs << "tube_gc_moved:" << std::endl
+        << "  store regB 0" << std::endl
+        << "tube_gc_zero:" << std::endl
+        << "  test_gte regB regC regD" << std::endl
+        << "  jump_if_n0 regD tube_gc_zeroed" << std::endl
+        << "  store 0 regB" << std::endl
+        << "  add regB 1 regB" << std::endl
+        << "  jump tube_gc_zero" << std::endl
+        << "tube_gc_zeroed:" << std::endl
+        << "  val_copy " << free_lists << " regA" << std::endl
+        << "tube_gc_lists:" << std::endl
+        << "  test_gte regA " << free_lists + num_size_classes << " regD" << std::endl
+        << "  jump_if_n0 regD tube_gc_limit" << std::endl
+        << "  store 0 regA" << std::endl
+        << "  add regA 1 regA" << std::endl
+        << "  jump tube_gc_lists" << std::endl
+        << "tube_gc_limit:" << std::endl
+        << "  load 0 regB" << std::endl
+        << "  sub regB " << heap_start << " regC" << std::endl
+        << "  test_less regC " << gc_min_heap << " regD" << std::endl
+        << "  jump_if_0 regD tube_gc_done" << std::endl
+        << "  val_copy " << gc_min_heap << " regC" << std::endl
+        << "tube_gc_done:" << std::endl
+        << "  add regB regC regC" << std::endl
+        << "  store regC " << gc_limit << std::endl
+        << "  store 1 " << gc_collected << std::endl
+        << "  load " << gc_saved_size << " regE" << std::endl
+        << "  load " << gc_saved_return << " regG" << std::endl
+        << "  jump tube_alloc                       # Try again now that there is room." << std::endl;
+  }
+
+  // The allocator subroutine: finds a block with room for regE elements and leaves
+  // its address in regD, using the free list for that size class when it has one.
+  // regF is left as 0 if the block is fresh memory (so it is already all zeros).
+  // Changes regC, regD and regF (and with -gc, regA and regB, since a collection
+  // moves arrays); returns to the address in regG.
+  void PrintAllocator(std::ostream & ofs, const std::set<int> & roots)
+  {
+    ofs << "  jump tube_alloc_end                   # Skip over the memory allocator." << std::endl
+        << "tube_alloc:" << std::endl
+        << "  val_copy " << min_capacity << " regD                       # regD = capacity of the size class" << std::endl
+        << "  val_copy " << free_lists << " regF                   # regF = free list for the size class" << std::endl
+        << "tube_alloc_class:" << std::endl
+        << "  test_gte regD regE regC" << std::endl
+        << "  jump_if_n0 regC tube_alloc_found" << std::endl
+        << "  add regD regD regD" << std::endl
+        << "  add regF 1 regF" << std::endl
+        << "  jump tube_alloc_class" << std::endl
+        << "tube_alloc_found:" << std::endl
+        << "  load regF regC                        # Reuse a free block if there is one." << std::endl
+        << "  jump_if_0 regC tube_alloc_new" << std::endl
+        << "  load regC regD" << std::endl
+        << "  store regD regF" << std::endl
+        << "  val_copy regC regD" << std::endl
+        << "  jump regG" << std::endl
+        << "tube_alloc_new:" << std::endl;
+    if (use_gc) {
+      ofs << "  load 0 regC" << std::endl
+          << "  add regC regD regB" << std::endl
+          << "  add regB 3 regB" << std::endl
+          << "  load " << gc_limit << " regA" << std::endl
+          << "  test_gtr regB regA regB               # Would the heap grow past the limit?" << std::endl
+          << "  jump_if_0 regB tube_alloc_take" << std::endl
+          << "  load " << gc_collected << " regB" << std::endl
+          << "  jump_if_0 regB tube_gc" << std::endl
+          << "  store 0 " << gc_collected << "                       # Still no room; grow the heap anyway." << std::endl
+          << "tube_alloc_take:" << std::endl;
+    }
+    ofs << "  load 0 regC                           # Otherwise take it from the free memory." << std::endl
+        << "  sub regF " << free_lists << " regF" << std::endl
+        << "  store regF regC                       # Record the size class..." << std::endl
+        << "  add regC 1 regC" << std::endl
+        << "  store regD regC                       # ...and the capacity." << std::endl
+        << "  add regC 1 regC" << std::endl
+        << "  add regC regD regF" << std::endl
+        << "  add regF 1 regF" << std::endl
+        << "  store regF 0                          # Store new free memory at pos. zero" << std::endl
+        << "  val_copy regC regD" << std::endl
+        << "  val_copy 0 regF" << std::endl
+        << "  jump regG" << std::endl;
+    if (use_gc) PrintCollector(ofs, roots);
+    ofs << "tube_alloc_end:" << std::endl;
+  }
+
+  // Put the (non-zero) array in array_reg onto the free list for its size class; the
+  // list is linked through the size cells of the free arrays.
+  void PrintFree(std::ostream & ofs, const std::string & array_reg,
+                 const std::string & list_reg, const std::string & next_reg)
+  {
+    ofs << "  sub " << array_reg << " 2 " << list_reg << std::endl;
+    ofs << "  load " << list_reg << " " << list_reg << "                        # Size class" << std::endl;
+    ofs << "  add " << list_reg << " " << free_lists << " " << list_reg << std::endl;
+    ofs << "  load " << list_reg << " " << next_reg << std::endl;
+    ofs << "  store " << next_reg << " " << array_reg << "                        # Link in front of the others." << std::endl;
+    ofs << "  store " << array_reg << " " << list_reg << std::endl;
+  }
+
+  // Try to read an argument as an integer constant (for folding array offsets).
+  bool ConstIndex(const IC_Argument & arg, int & value)
+  {
+    if (!arg.IsConst() || arg.str_value.size() == 0) return false;
+    for (int i = 0; i < (int) arg.str_value.size(); i++) {
+      if (arg.str_value[i] < '0' || arg.str_value[i] > '9') return false;
+    }
+    value = std::stoi(arg.str_value);
+    return true;
+  }
+}
+
+
+bool IC_Entry::IsLoad(int arg_id) const
 {
-  // If this entry has a label, print it!
-  if (label != "") ofs << label << ":" << std::endl;
+  if (arg_id == 0) return load1;
+  if (arg_id == 1) return load2;
+  if (arg_id == 2) return load3;
+  return false;
+}
+
+bool IC_Entry::IsStore(int arg_id) const
+{
+  if (arg_id == 0) return store1;
+  if (arg_id == 1) return store2;
+  if (arg_id == 2) return store3;
+  return false;
+}
 
-  // If we have an instruction, load any values it needs into registers.
-  if (inst != "") {
-    ofs << "### Converting: " << inst;
-    for (int i = 0; i < (int) args.size(); i++) ofs << " " << args[i].str_value;
-    ofs << std::endl;
 
-    // Setup Loads
-    if (load1  && !args[0].IsConst()) {
-      ofs << "  load " << args[0].var_id << " regA" << std::endl;
+void IC_Entry::PrintTubeCode(std::ostream & ofs, std::vector<TC_Reg> & registers)
+{
+  // A label can be reached from other blocks, so cached values must be in memory first.
+  if (label != "") {
+    FlushRegs(ofs, registers);
+    ClearRegs(registers);
+    ofs << label << ":" << std::endl;
+
+    // Another path in may have changed a pinned variable without saving it.
+    for (TC_Reg & reg : registers) if (reg.pinned) reg.dirty = true;
+
+    // Arguments passed in registers arrive in regA, regB, ...
+    for (int k = 0; k < (int) reg_vars.size(); k++) {
+      if (live_after.count(reg_vars[k]) == 0) continue;
+      registers[k].var_id = reg_vars[k];
+      registers[k].dirty = true;
+      registers[k].last_use = ++reg_clock;
     }
-    if (load2  && !args[1].IsConst()) {
-      ofs << "  load " << args[1].var_id << " regB" << std::endl;
+
+    // A returned value arrives in regA; shift it if regA belongs to another pinned variable.
+    if (reg_return >= 0 && live_after.count(reg_return)) {
+      int reg_id = FindReg(registers, reg_return);
+      if (reg_id == -1) {
+        reg_id = 0;
+        if (registers[0].pinned) {
+          std::vector<int> locked;
+          reg_id = PickReg(ofs, registers, locked);
+        }
+        registers[reg_id].var_id = reg_return;
+      }
+      if (reg_id != 0) ofs << "  val_copy regA " << registers[reg_id].name << std::endl;
+      registers[reg_id].dirty = true;
+      registers[reg_id].last_use = ++reg_clock;
     }
-    if (load3  && !args[2].IsConst()) {
-      ofs << "  load " << args[2].var_id << " regC" << std::endl;
+
+    // The callee used the registers.
+    if (after_call) ReloadPinned(ofs, registers, live_after, reg_return);
+  }
+
+  // Move variables that get their own register for a stretch of code into place.
+  for (const TC_Pin & pin : pin_start) {
+    TC_Reg & reg = registers[pin.reg_id];
+    int cur_id = FindReg(registers, pin.var_id);
+    if (cur_id != pin.reg_id) {
+      // A value still needed here moves to a free register rather than out to memory.
+      bool needed = reg.var_id >= 0 && reg.var_id != pin.var_id && live_after.count(reg.var_id);
+      for (const IC_Argument & arg : args) if (reg.var_id >= 0 && arg.var_id == reg.var_id) needed = true;
+      for (int k = 0; needed && k < (int) registers.size(); k++) {
+        bool target = false;
+        for (const TC_Pin & other : pin_start) if (other.reg_id == k) target = true;
+        if (registers[k].var_id != -1 || registers[k].pinned || target) continue;
+        ofs << "  val_copy " << reg.name << " " << registers[k].name << std::endl;
+        registers[k].var_id = reg.var_id;
+        registers[k].dirty = reg.dirty;
+        registers[k].last_use = reg.last_use;
+        reg.var_id = -1;
+        reg.dirty = false;
+        needed = false;
+      }
+      SpillReg(ofs, reg);
+      reg.dirty = false;
+      if (cur_id != -1) {
+        ofs << "  val_copy " << registers[cur_id].name << " " << reg.name << std::endl;
+        reg.dirty = registers[cur_id].dirty;
+        registers[cur_id].var_id = -1;
+        registers[cur_id].dirty = false;
+      }
+      else if (pin.load) ofs << "  load " << pin.var_id << " " << reg.name << std::endl;
     }
+    reg.var_id = pin.var_id;
+    reg.pinned = true;
   }
 
-  // If there is an instruction, print it and all its arguments.
+  // Skip calculations whose results are never used.
+  const bool dead = IsDeadCode(*this);
+
+  if (inst != "" && !dead) {
+    ofs << "### Converting: " << inst << " ";
+    for (int i = 0; i < (int) args.size(); i++) ofs << args[i].str_value << " ";
+    ofs << std::endl;
+  }
+
+  // Registers used by the current instruction cannot be evicted until it is done.
+  std::vector<int> locked;
   std::stringstream out_line;
-  if (inst == "ar_get_idx") {            // *******************************************************
-    ofs << "  add regA 1 regD" << std::endl;
-    if (args[1].IsConst()) ofs << "  add regD " << args[1].str_value << " regD" << std::endl;
-    else ofs << "  add regD regB regD" << std::endl;
-    ofs << "  load regD regC";
+
+  if (dead) {
+    ;
+  } else if (inst == "ar_get_idx") {            // *******************************************************
+    std::string array_reg = FetchArg(args[0], ofs, registers, locked);
+    std::string index_str = FetchArg(args[1], ofs, registers, locked);
+    TC_Reg & out_reg = registers[ ClaimArg(args[2], ofs, registers, locked) ];
+    int index = 0;
+    if (ConstIndex(args[1], index)) {
+      ofs << "  add " << array_reg << " " << (index + 1) << " " << out_reg.name << std::endl;
+      ofs << "  load " << out_reg.name << " " << out_reg.name;
+    } else {
+      // The output register can hold the address unless it is also the index.
+      std::string addr_reg = out_reg.name;
+      if (addr_reg == index_str) addr_reg = registers[ PickReg(ofs, registers, locked) ].name;
+      ofs << "  add " << array_reg << " 1 " << addr_reg << std::endl;
+      ofs << "  add " << addr_reg << " " << index_str << " " << addr_reg << std::endl;
+      ofs << "  load " << addr_reg << " " << out_reg.name;
+    }
 
   } else if (inst == "ar_set_idx") {     // *******************************************************
-    ofs << "  add regA 1 regD" << std::endl;
-    if (args[1].IsConst()) ofs << "  add regD " << args[1].str_value << " regD" << std::endl;
-    else ofs << "  add regD regB regD" << std::endl;
-    if (args[2].IsConst()) ofs << "  store " << args[2].str_value << " regD";
-    else ofs << "  store regC regD";
+    std::string array_reg = FetchArg(args[0], ofs, registers, locked);
+    std::string index_str = FetchArg(args[1], ofs, registers, locked);
+    std::string value_str = FetchArg(args[2], ofs, registers, locked);
+    std::string addr_reg = registers[ PickReg(ofs, registers, locked) ].name;
+    int index = 0;
+    if (ConstIndex(args[1], index)) {
+      ofs << "  add " << array_reg << " " << (index + 1) << " " << addr_reg << std::endl;
+    } else {
+      ofs << "  add " << array_reg << " 1 " << addr_reg << std::endl;
+      ofs << "  add " << addr_reg << " " << index_str << " " << addr_reg << std::endl;
+    }
+    ofs << "  store " << value_str << " " << addr_reg;
+
+  } else if (inst == "load" || inst == "store") {   // *******************************************
+    // Reach a fixed-size array element (one of the args[3] cells from args[2]) through
+    // its address.  Copies of the array's cells sitting in registers must be written
+    // back first, and after a store they may be out of date.
+    int first = 0, count = 0;
+    ConstIndex(args[2], first);
+    ConstIndex(args[3], count);
+    auto in_array = [first, count](const TC_Reg & reg) {
+      return reg.var_id >= first && reg.var_id < first + count;
+    };
+    for (TC_Reg & reg : registers) if (in_array(reg)) SpillReg(ofs, reg);
+    if (inst == "load") {
+      std::string addr_str = FetchArg(args[0], ofs, registers, locked);
+      TC_Reg & out_reg = registers[ ClaimArg(args[1], ofs, registers, locked) ];
+      ofs << "  load " << addr_str << " " << out_reg.name;
+    } else {
+      std::string value_str = FetchArg(args[0], ofs, registers, locked);
+      std::string addr_str = FetchArg(args[1], ofs, registers, locked);
+      ofs << "  store " << value_str << " " << addr_str;
+      for (TC_Reg & reg : registers) if (in_array(reg)) reg.var_id = -1;
+    }
+
   } else if (inst == "ar_get_siz") {     // *******************************************************
-    ofs << "  load regA regB";
+    // An array that was never set up has a zero pointer (and a size of zero).
+    static int label_id = 0;
+    std::string array_reg = FetchArg(args[0], ofs, registers, locked);
+    TC_Reg & out_reg = registers[ ClaimArg(args[1], ofs, registers, locked) ];
+    if (resize_kind == RESIZE_INIT) {
+      ofs << "  load " << array_reg << " " << out_reg.name;
+    } else {
+      const std::string end_label = "ar_get_siz_end_" + std::to_string(label_id++);
+      ofs << "  val_copy 0 " << out_reg.name << std::endl;
+      ofs << "  jump_if_0 " << array_reg << " " << end_label << std::endl;
+      ofs << "  load " << array_reg << " " << out_reg.name << std::endl;
+      ofs << end_label << ":";
+    }
+
+  } else if (inst == "ar_set_siz" && resize_kind == RESIZE_SHRINK) {
+    // A smaller size always fits; positions past it are zeroed if it grows again.
+    std::string array_reg = FetchArg(args[0], ofs, registers, locked);
+    std::string size_str = FetchArg(args[1], ofs, registers, locked);
+    ofs << "  store " << size_str << " " << array_reg << "                       # Record the new (smaller) size.";
 
   } else if (inst == "ar_set_siz") {     // *******************************************************
     static int label_id = 0;
-    std::stringstream do_copy_label, start_label, end_label;
-    do_copy_label << "ar_resize_do_copy_" << label_id++;
-    start_label << "ar_resize_start_" << label_id++;
-    end_label << "ar_resize_end_" << label_id++;
-
-    std::string size_in("regB");
-    if (args[1].IsConst()) size_in = args[1].str_value;
-
-    // Start by calculating old_array_size in "regC"
-    ofs << "  val_copy 0 regC                       # Default old array size to 0 if uninitialized." << std::endl;
-    ofs << "  jump_if_0 regA " << do_copy_label.str() << "    # Leave 0 size (nothing to copy) for uninitialized arrays." << std::endl;  // Jump if original array is uninitialized
-    ofs << "  load regA regC                        # Load old array size into regC" << std::endl;
-
-    // Test if old_array_size ("regC") >= new_array_size (size_in)
-    ofs << "  test_gtr " << size_in << " regC regD               # regD = new_size > old_size?" << std::endl;
-    ofs << "  jump_if_n0 regD " << do_copy_label.str() << "   # Jump to array copy if new size is bigger than old size." << std::endl;  // If not, proceed to move...
-    ofs << "  store " << size_in << " regA                       # Otherwise, replace old size w/ new size.  Done." << std::endl;
-    ofs << "  jump " << end_label.str() << "                  # Skip copying contents." << std::endl;
-
-    // If we made it here, we need to copy the array and have original size in "regC" and new size in size_in
-    ofs << do_copy_label.str() << ":" << std::endl;
-
-    // Set up memory for the new array.
-    ofs << "  load 0 regD                           # Set regD = free mem position" << std::endl;
-    ofs << "  store regD " << args[0].var_id << "                          # Set indirect pointer to new mem pos." << std::endl;
-    ofs << "  store " << size_in << " regD                       # Store new size at new array start" << std::endl;
-    ofs << "  add regD 1 regE                       # Set regE = first pos. in new array" << std::endl;
-    ofs << "  add regE " << size_in << " regE                    # Set regE = new free mem position" << std::endl;
-    ofs << "  store regE 0                          # Store new free memory at pos. zero" << std::endl;
-
-    // Figure out where to stop copying in E
-    ofs << "  add regA regC regE                    # Set regE = the last index to be copied" << std::endl;
+    const std::string id = std::to_string(label_id++);
+    const std::string array_var = std::to_string(args[0].var_id);
+    const bool empty = resize_kind == RESIZE_EMPTY;
+
+    // Usually the new size fits in the space the array already has, so the size is
+    // simply updated (zeroing any new positions) without disturbing the registers.
+    std::string array_reg = FetchArg(args[0], ofs, registers, locked);
+    std::string size_str = FetchArg(args[1], ofs, registers, locked);
+    const int old_id = PickReg(ofs, registers, locked);
+    locked.push_back(old_id);
+    const int temp_id = PickReg(ofs, registers, locked);
+    locked.push_back(temp_id);
+    const int end_id = PickReg(ofs, registers, locked);
+    locked.push_back(end_id);
+    const std::string & old_reg = registers[old_id].name;
+    const std::string & temp_reg = registers[temp_id].name;
+    const std::string & end_reg = registers[end_id].name;
+    if (!empty) {
+      if (resize_kind != RESIZE_INIT) ofs << "  jump_if_0 " << array_reg << " ar_resize_move_" << id << std::endl;
+      ofs << "  sub " << array_reg << " 1 " << temp_reg << std::endl;
+      ofs << "  load " << temp_reg << " " << temp_reg << "                        # Capacity" << std::endl;
+      ofs << "  test_gtr " << size_str << " " << temp_reg << " " << temp_reg << std::endl;
+      ofs << "  jump_if_n0 " << temp_reg << " ar_resize_grow_" << id << std::endl;
+      ofs << "  load " << array_reg << " " << old_reg << "                        # Old size" << std::endl;
+      ofs << "  store " << size_str << " " << array_reg << "                       # Record the new size." << std::endl;
+      ofs << "ar_resize_zero_" << id << ":" << std::endl;
+      ofs << "  test_gte " << old_reg << " " << size_str << " " << temp_reg << std::endl;
+      ofs << "  jump_if_n0 " << temp_reg << " ar_resize_end_" << id << std::endl;
+      ofs << "  add " << array_reg << " " << old_reg << " " << temp_reg << std::endl;
+      ofs << "  add " << temp_reg << " 1 " << temp_reg << std::endl;
+      ofs << "  store 0 " << temp_reg << "                          # New positions start out as zero." << std::endl;
+      ofs << "  add " << old_reg << " 1 " << old_reg << std::endl;
+      ofs << "  jump ar_resize_zero_" << id << std::endl;
+
+      // If the array is the last block on the heap, it can grow into the free memory
+      // after it; only the positions it used before need to be zeroed.
+      ofs << "ar_resize_grow_" << id << ":" << std::endl;
+      ofs << "  sub " << array_reg << " 1 " << temp_reg << std::endl;
+      ofs << "  load " << temp_reg << " " << temp_reg << "                        # Capacity" << std::endl;
+      ofs << "  load 0 " << end_reg << "                          # Does the block end at the free pointer?" << std::endl;
+      ofs << "  sub " << end_reg << " " << array_reg << " " << old_reg << std::endl;
+      ofs << "  sub " << old_reg << " 1 " << old_reg << std::endl;
+      ofs << "  test_equ " << old_reg << " " << temp_reg << " " << old_reg << std::endl;
+      ofs << "  jump_if_0 " << old_reg << " ar_resize_move_" << id << std::endl;
+      ofs << "  load " << array_reg << " " << old_reg << "                        # Old size" << std::endl;
+      ofs << "  add " << array_reg << " " << old_reg << " " << old_reg << std::endl;
+      ofs << "ar_resize_clear_old_" << id << ":" << std::endl;
+      ofs << "  add " << old_reg << " 1 " << old_reg << std::endl;
+      ofs << "  test_gte " << old_reg << " " << end_reg << " " << temp_reg << std::endl;
+      ofs << "  jump_if_n0 " << temp_reg << " ar_resize_extend_" << id << std::endl;
+      ofs << "  store 0 " << old_reg << std::endl;
+      ofs << "  jump ar_resize_clear_old_" << id << std::endl;
+      ofs << "ar_resize_extend_" << id << ":" << std::endl;
+      ofs << "  sub " << array_reg << " 2 " << temp_reg << std::endl;
+      ofs << "  load " << temp_reg << " " << old_reg << "                        # Size class" << std::endl;
+      ofs << "  sub " << end_reg << " " << array_reg << " " << end_reg << std::endl;
+      ofs << "  sub " << end_reg << " 1 " << end_reg << std::endl;
+      ofs << "ar_resize_class_" << id << ":" << std::endl;
+      ofs << "  add " << end_reg << " " << end_reg << " " << end_reg << "                # Double the capacity until it fits." << std::endl;
+      ofs << "  add " << old_reg << " 1 " << old_reg << std::endl;
+      ofs << "  test_gtr " << size_str << " " << end_reg << " " << temp_reg << std::endl;
+      ofs << "  jump_if_n0 " << temp_reg << " ar_resize_class_" << id << std::endl;
+      ofs << "  sub " << array_reg << " 2 " << temp_reg << std::endl;
+      ofs << "  store " << old_reg << " " << temp_reg << std::endl;
+      ofs << "  add " << temp_reg << " 1 " << temp_reg << std::endl;
+      ofs << "  store " << end_reg << " " << temp_reg << std::endl;
+      ofs << "  add " << array_reg << " " << end_reg << " " << temp_reg << std::endl;
+      ofs << "  add " << temp_reg << " 1 " << temp_reg << std::endl;
+      ofs << "  store " << temp_reg << " 0                          # Move the free pointer past it." << std::endl;
+      ofs << "  store " << size_str << " " << array_reg << "                       # Record the new size." << std::endl;
+      ofs << "  jump ar_resize_end_" << id << std::endl;
+    }
 
-    // Copy the array over from A to D.
-    ofs << start_label.str() << ":" << std::endl;
-    ofs << "  add regA 1 regA                       # Increment pointer for FROM array" << std::endl;
-    ofs << "  add regD 1 regD                       # Increment pointer for TO array" << std::endl;
-    ofs << "  test_gtr regA regE regF               # If we are done copying, jump to end of loop" << std::endl;
-    ofs << "  jump_if_n0 regF " << end_label.str() << std::endl;
-    ofs << "  mem_copy regA regD                    # Copy the current index." << std::endl;
-    ofs << "  jump " << start_label.str() << std::endl;
-    ofs << end_label.str() << ":" << std::endl;
+    // Otherwise move it to a bigger block.  That needs every register, so write the
+    // variables they hold back to memory (where the collector can also see them) and
+    // reload them afterward.
+    std::vector<const TC_Reg *> saved;
+    for (const TC_Reg & reg : registers) {
+      if (reg.var_id != -1 && reg.name != array_reg) saved.push_back(&reg);
+    }
+    ofs << "ar_resize_move_" << id << ":" << std::endl;
+    for (const TC_Reg * reg : saved) {
+      ofs << "  store " << reg->name << " " << reg->var_id << std::endl;
+    }
+    ofs << "  store " << array_reg << " " << array_var << std::endl;
+    if (size_str != "regE") ofs << "  val_copy " << size_str << " regE" << std::endl;
+    ofs << "  val_copy ar_resize_new_" << id << " regG" << std::endl;
+    ofs << "  jump tube_alloc                       # regD = new block with room for regE" << std::endl;
+    ofs << "ar_resize_new_" << id << ":" << std::endl;
+    if (!empty) {
+      ofs << "  load " << array_var << " regA" << std::endl;
+      ofs << "  val_copy 0 regB                       # Old size is 0 if the array is uninitialized." << std::endl;
+      ofs << "  jump_if_0 regA ar_resize_old_" << id << std::endl;
+      ofs << "  load regA regB" << std::endl;
+      ofs << "ar_resize_old_" << id << ":" << std::endl;
+    }
+    ofs << "  store regD " << array_var << "                          # Set indirect pointer to new mem pos." << std::endl;
+    ofs << "  store regE regD                       # Record the new size." << std::endl;
+    ofs << "  val_copy regF regC                    # regC = 0 if the new block is fresh memory" << std::endl;
+    ofs << "  jump_if_0 regC ar_resize_fresh_" << id << std::endl;
+    ofs << "  add regD 1 regC                       # Zero the reused block past the old contents." << std::endl;
+    if (!empty) ofs << "  add regC regB regC" << std::endl;
+    ofs << "  add regD regE regF" << std::endl;
+    ofs << "ar_resize_clear_" << id << ":" << std::endl;
+    ofs << "  test_gtr regC regF regG" << std::endl;
+    ofs << "  jump_if_n0 regG ar_resize_fresh_" << id << std::endl;
+    ofs << "  store 0 regC" << std::endl;
+    ofs << "  add regC 1 regC" << std::endl;
+    ofs << "  jump ar_resize_clear_" << id << std::endl;
+    ofs << "ar_resize_fresh_" << id << ":" << std::endl;
+    if (!empty) {
+      ofs << "  val_copy regA regG" << std::endl;
+      ofs << "  add regA regB regC                    # Set regC = the last index to be copied" << std::endl;
+      ofs << "ar_resize_copy_" << id << ":" << std::endl;
+      ofs << "  add regA 1 regA                       # Increment pointer for FROM array" << std::endl;
+      ofs << "  add regD 1 regD                       # Increment pointer for TO array" << std::endl;
+      ofs << "  test_gtr regA regC regF               # If we are done copying, jump to end of loop" << std::endl;
+      ofs << "  jump_if_n0 regF ar_resize_copied_" << id << std::endl;
+      ofs << "  mem_copy regA regD                    # Copy the current index." << std::endl;
+      ofs << "  jump ar_resize_copy_" << id << std::endl;
+      ofs << "ar_resize_copied_" << id << ":" << std::endl;
+    }
+    if (array_owned && !empty) {
+      ofs << "  jump_if_0 regG ar_resize_restore_" << id << "       # Give the old block back." << std::endl;
+      PrintFree(ofs, "regG", "regC", "regF");
+    }
+    ofs << "ar_resize_restore_" << id << ":" << std::endl;
+    for (const TC_Reg * reg : saved) ofs << "  load " << reg->var_id << " " << reg->name << std::endl;
+    ofs << "  load " << array_var << " " << array_reg << std::endl;
+    ofs << "ar_resize_end_" << id << ":" << std::endl;
 
   } else if (inst == "ar_copy") {     // *******************************************************
     static int label_id = 0;
-    std::stringstream do_copy_label, start_label, end_label;
-    do_copy_label << "ar_do_copy_" << label_id++;
-    start_label << "ar_copy_start_" << label_id++;
-    end_label << "ar_copy_end_" << label_id++;
+    const std::string id = std::to_string(label_id++);
+
+    // The copy loop uses every scratch register, so save everything first.
+    FlushRegs(ofs, registers, true);
+    ClearRegs(registers);
+    ofs << "  load " << args[0].var_id << " regA" << std::endl;
 
     // "regA" holds the pointer the array to copy from.  If it's zero, set array2 to zero and stop.
-    ofs << "  jump_if_n0 regA " << do_copy_label.str() << "          # Jump if we actually have something to copy." << std::endl;
+    ofs << "  jump_if_n0 regA ar_do_copy_" << id << "          # Jump if we actually have something to copy." << std::endl;
     ofs << "  val_copy 0 regB                             # Set indirect pointer to new mem pos." << std::endl;
-    ofs << "  jump " << end_label.str() << std::endl;
+    ofs << "  jump ar_copy_end_" << id << std::endl;
 
     // If we made it here, we need to copy the array.
-    ofs << do_copy_label.str() << ":" << std::endl;
-
-    // Set up memory for the new array.
-    ofs << "  load 0 regD                           # Set regD = free mem position" << std::endl;
-    ofs << "  val_copy regD regB                    # Set indirect pointer to new mem pos." << std::endl;
+    ofs << "ar_do_copy_" << id << ":" << std::endl;
     ofs << "  load regA regE                        # Set regE = Array size." << std::endl;
-    ofs << "  add regD 1 regF                       # Set regF = first pos. in new array" << std::endl;
-    ofs << "  add regF regE regF                    # Set regF = new free mem position" << std::endl;
-    ofs << "  store regF 0                          # Store new free memory at pos. zero" << std::endl;
-
-    // Copy the array over from A to B; increment until B==D
-    ofs << start_label.str() << ":" << std::endl;
-    ofs << "  test_equ regD regF regG               # If we are done copying, jump to end of loop" << std::endl;
-    ofs << "  jump_if_n0 regG " << end_label.str() << std::endl;
-    ofs << "  mem_copy regA regD                    # Copy the current index." << std::endl;
+    ofs << "  val_copy ar_copy_alloc_" << id << " regG" << std::endl;
+    ofs << "  jump tube_alloc                       # regD = new block with room for regE" << std::endl;
+    ofs << "ar_copy_alloc_" << id << ":" << std::endl;
+    if (use_gc) ofs << "  load " << args[0].var_id << " regA                        # The collector may have moved it." << std::endl;
+    ofs << "  val_copy regD regB                    # Set indirect pointer to new mem pos." << std::endl;
+    ofs << "  store regE regD                       # Store the size in the new array." << std::endl;
+    ofs << "  add regA regE regC                    # Set regC = the last index to be copied" << std::endl;
+
+    // Copy the array over from A to D.
+    ofs << "ar_copy_start_" << id << ":" << std::endl;
     ofs << "  add regA 1 regA                       # Increment pointer for FROM array" << std::endl;
     ofs << "  add regD 1 regD                       # Increment pointer for TO array" << std::endl;
-    ofs << "  jump " << start_label.str() << std::endl;
-    ofs << end_label.str() << ":" << std::endl;
+    ofs << "  test_gtr regA regC regF               # If we are done copying, jump to end of loop" << std::endl;
+    ofs << "  jump_if_n0 regF ar_copy_end_" << id << std::endl;
+    ofs << "  mem_copy regA regD                    # Copy the current index." << std::endl;
+    ofs << "  jump ar_copy_start_" << id << std::endl;
+    ofs << "ar_copy_end_" << id << ":" << std::endl;
+
+    // The new array pointer is left in regB; hold onto it instead of storing right away.
+    ClearRegs(registers);
+    int dest_id = FindReg(registers, args[1].var_id);
+    if (dest_id != -1) {
+      if (dest_id != 1) ofs << "  val_copy regB " << registers[dest_id].name << std::endl;
+      registers[dest_id].dirty = true;
+    } else if (registers[1].pinned) {
+      ofs << "  store regB " << args[1].var_id << std::endl;
+    } else {
+      registers[1].var_id = args[1].var_id;
+      registers[1].dirty = true;
+      registers[1].last_use = ++reg_clock;
+    }
+    ReloadPinned(ofs, registers, live_after, args[1].var_id);
 
-  } else if (inst == "push") {        // *******************************************************
-    // Assume that regH points to the top of the stack.
-    if (args[0].IsConst()) ofs << "  store " << args[0].str_value << " regH";
-    else ofs << "  store regA regH";
-    ofs << "                       # Save loaded value onto the stack." << std::endl;
-    ofs << "  add regH 1 regH                       # Increment stack to next mem position" << std::endl;
+  } else if (inst == "ar_free") {     // *******************************************************
+    static int label_id = 0;
+    const std::string end_label = "ar_free_end_" + std::to_string(label_id++);
+    std::string array_reg = FetchArg(args[0], ofs, registers, locked);
+    const int list_id = PickReg(ofs, registers, locked);
+    locked.push_back(list_id);
+    const int next_id = PickReg(ofs, registers, locked);
+    locked.push_back(next_id);
+    const std::string & list_reg = registers[list_id].name;
+    const std::string & next_reg = registers[next_id].name;
+    ofs << "  jump_if_0 " << array_reg << " " << end_label << "            # Nothing to free if uninitialized." << std::endl;
+    PrintFree(ofs, array_reg, list_reg, next_reg);
+    ofs << end_label << ":" << std::endl;
+
+    // Clear the variable, so nothing (such as the collector) can follow it to the block.
+    ofs << "  store 0 " << args[0].var_id << std::endl;
+    const int reg_id = FindReg(registers, args[0].var_id);
+    if (reg_id != -1) {
+      if (live_after.count(args[0].var_id)) ofs << "  val_copy 0 " << registers[reg_id].name << std::endl;
+      registers[reg_id].dirty = false;
+    }
 
-  } else if (inst == "pop") {         // *******************************************************
-    // Assume that regH points to the top of the stack.
-    ofs << "  sub regH 1 regH                       # Decrement stack to prev mem position" << std::endl;
-    ofs << "  load regH regA                        # Load stored value from the stack." << std::endl;
-  } else if (inst == "ar_push") {        // *******************************************************
+  } else if (inst == "jump_table") {   // *********************************************
+    // Jump to the label in args[2 + index], or to args[1] if the index is negative;
+    // the index must be a whole number smaller in size than the number of labels.
+    static int label_id = 0;
+    const std::string table_label = "jump_table_" + std::to_string(label_id++);
+    std::string index_str = FetchArg(args[0], ofs, registers, locked);
+    const std::string & addr_reg = registers[ PickReg(ofs, registers, locked) ].name;
+    ofs << "  add " << table_label << " " << index_str << " " << addr_reg << std::endl;
+    if (args[0].final_use) ReleaseVar(registers, args[0].var_id);
+    FlushRegs(ofs, registers);
+    ofs << "  jump " << addr_reg << "                          # Jump through the table." << std::endl;
+    for (int i = 3; i < (int) args.size(); i++) ofs << "  jump " << args[1].str_value << std::endl;
+    ofs << table_label << ":" << std::endl;
+    for (int i = 2; i < (int) args.size(); i++) ofs << "  jump " << args[i].str_value << std::endl;
+    ClearRegs(registers);
+
+  } else if (inst == "ar_push" && use_gc) {
+    // Saved arrays go on the array stack, where the collector can find them.
+    std::string value_str = FetchArg(args[0], ofs, registers, locked);
+    const std::string & temp_reg = registers[ PickReg(ofs, registers, locked) ].name;
+    ofs << "  load " << array_stack_ptr << " " << temp_reg << std::endl;
+    ofs << "  sub " << temp_reg << " 1 " << temp_reg << std::endl;
+    ofs << "  store " << value_str << " " << temp_reg << "                       # Save array onto the array stack." << std::endl;
+    ofs << "  store " << temp_reg << " " << array_stack_ptr << std::endl;
+
+  } else if (inst == "ar_pop" && use_gc) {
+    const int out_id = ClaimArg(args[0], ofs, registers, locked);
+    locked.push_back(out_id);
+    const std::string & temp_reg = registers[ PickReg(ofs, registers, locked) ].name;
+    ofs << "  load " << array_stack_ptr << " " << temp_reg << std::endl;
+    ofs << "  load " << temp_reg << " " << registers[out_id].name << "                        # Load saved array from the array stack." << std::endl;
+    ofs << "  add " << temp_reg << " 1 " << temp_reg << std::endl;
+    ofs << "  store " << temp_reg << " " << array_stack_ptr << std::endl;
+
+  } else if (inst == "push" || inst == "ar_push") {   // ***************************************
     // Assume that regH points to the top of the stack.
-    if (args[0].IsConst()) ofs << "  store " << args[0].str_value << " regH";
-    else ofs << "  store regA regH";
+    std::string value_str = FetchArg(args[0], ofs, registers, locked);
+    ofs << "  store " << value_str << " regH";
     ofs << "                       # Save loaded value onto the stack." << std::endl;
     ofs << "  add regH 1 regH                       # Increment stack to next mem position" << std::endl;
 
-  } else if (inst == "ar_pop") {         // *******************************************************
+  } else if (inst == "val_copy" && !args[0].IsConst() && args[0].final_use
+             && FindReg(registers, args[1].var_id) == -1
+             && FindReg(registers, args[0].var_id) != -1
+             && !registers[ FindReg(registers, args[0].var_id) ].pinned) {
+    // The source is not needed again, so its register can simply take on the copy.
+    TC_Reg & reg = registers[ FindReg(registers, args[0].var_id) ];
+    reg.var_id = args[1].var_id;
+    reg.dirty = true;
+    reg.last_use = ++reg_clock;
+
+  } else if (inst == "pop" || inst == "ar_pop") {     // ***************************************
     // Assume that regH points to the top of the stack.
+    TC_Reg & out_reg = registers[ ClaimArg(args[0], ofs, registers, locked) ];
     ofs << "  sub regH 1 regH                       # Decrement stack to prev mem position" << std::endl;
-    ofs << "  load regH regA                        # Load stored value from the stack." << std::endl;
+    ofs << "  load regH " << out_reg.name << "                        # Load stored value from the stack." << std::endl;
   }
 
   // All other instructions are converted in the same way.
   else if (inst != "") {
-    out_line << "  " << inst << " ";
-    if (args.size() >= 1) {
-      if (args[0].IsConst()) out_line << args[0].str_value << " ";
-      else out_line << "regA ";
+    std::vector<std::string> arg_strs(args.size());
+    for (int i = 0; i < (int) args.size(); i++) {
+      if (args[i].IsConst() || IsLoad(i)) arg_strs[i] = FetchArg(args[i], ofs, registers, locked);
+    }
+    for (int i = 0; i < (int) args.size(); i++) {
+      if (!args[i].IsConst() && IsStore(i)) {
+        arg_strs[i] = registers[ ClaimArg(args[i], ofs, registers, locked) ].name;
+      }
+    }
+
+    // Anything dying here doesn't need to be saved before leaving the block.  Calls
+    // and returns leave this code entirely, so pinned registers must be saved too.
+    if (IsJump()) {
+      for (int i = 0; i < (int) args.size(); i++) {
+        if (args[i].final_use) ReleaseVar(registers, args[i].var_id);
+      }
+
+      // Values passed in registers never need their memory cells.
+      std::vector<int> passed(reg_vars);
+      if (reg_return >= 0 && !is_call) passed.push_back(reg_return);
+      for (int var_id : passed) {
+        int reg_id = FindReg(registers, var_id);
+        if (reg_id != -1) registers[reg_id].dirty = false;
+      }
+      FlushRegs(ofs, registers, is_call || (inst == "jump" && !args[0].IsConst()));
+
+      if (reg_return >= 0 && !is_call) {
+        // Returning: keep the return address out of regA, which carries the result.
+        if (arg_strs[0] == "regA") {
+          int spare = 1;
+          while (spare == FindReg(registers, reg_return)) spare++;
+          ofs << "  val_copy regA " << registers[spare].name << std::endl;
+          arg_strs[0] = registers[spare].name;
+        }
+        PassInRegisters(ofs, registers, std::vector<int>(1, reg_return));
+      }
+      else if (is_call) PassInRegisters(ofs, registers, reg_vars);
     }
-    if (args.size() >= 2) {
-      if (args[1].IsConst()) out_line << args[1].str_value << " ";
-      else out_line << "regB ";
+
+    // Doubling can be done with an add if that is cheaper on this VM.
+    std::string tc_inst = inst;
+    if (inst == "mult" && cost_table.TubeCode("add") < cost_table.TubeCode("mult")) {
+      if (args[1].IsConst() && args[1].str_value == "2") { tc_inst = "add"; arg_strs[1] = arg_strs[0]; }
+      else if (args[0].IsConst() && args[0].str_value == "2") { tc_inst = "add"; arg_strs[0] = arg_strs[1]; }
     }
-    if (args.size() >= 3) {
-      if (args[2].IsConst()) out_line << args[2].str_value << " ";
-      else out_line << "regC ";
+
+    // The VM leaves the result untouched on a zero divisor, so a remainder that may
+    // divide by zero starts its result at 0 (unless the result is the divisor itself).
+    if (inst == "mod" && MayBeZero(args[1]) && arg_strs[2] != arg_strs[1]) {
+      if (arg_strs[2] == arg_strs[0]) {
+        const std::string out_name = arg_strs[2];
+        arg_strs[2] = registers[ PickReg(ofs, registers, locked) ].name;
+        ofs << "  val_copy 0 " << arg_strs[2] << std::endl;
+        ofs << "  mod " << arg_strs[0] << " " << arg_strs[1] << " " << arg_strs[2] << std::endl;
+        tc_inst = "val_copy";
+        arg_strs = { arg_strs[2], out_name };
+      }
+      else ofs << "  val_copy 0 " << arg_strs[2] << std::endl;
     }
+
+    out_line << "  " << tc_inst << " ";
+    for (int i = 0; i < (int) arg_strs.size(); i++) out_line << arg_strs[i] << " ";
+
+    // Nothing is known about registers at the target of an unconditional jump.
+    if (inst == "jump") ClearRegs(registers);
   }
 
   // If there is a comment, print it!
@@ -304,27 +1160,20 @@ void IC_Entry::PrintTubeCode(std::ostream & ofs, std::vector<TC_Reg> & registers
   }
 
   // Print out the main instrution information if there is any...
-  if (inst != "" || comment != "") ofs << out_line.str() << std::endl;
-
-  // if (store1) {
-  //   if (registers[0].val == "") { registers[0].val = args[0].var_id; }
-  //   else { ofs << "  store regA " << args[0].var_id << std::endl; }
-    
-  // }
-  // if (store2) {
-  //   if (registers[1].val == "") { registers[1].val = args[1].var_id; }
-  //   else { ofs << "  store regB " << args[1].var_id << std::endl; }
-  // }
-  // if (store3) { 
-  //   if (registers[2].val == "") { registers[2].val = args[2].var_id; }
-  //   else { ofs << "  store regC " << args[2].var_id << std::endl; }
-  // }
-
-  if (store1) { ofs << "  store regA " << args[0].var_id << std::endl; }
-  if (store2) { ofs << "  store regB " << args[1].var_id << std::endl; }
-  if (store3) { ofs << "  store regC " << args[2].var_id << std::endl; }
-}
+  if ((inst != "" && !dead) || comment != "") ofs << out_line.str() << std::endl;
 
+  // Variables used for the last time no longer need their registers (or a store).
+  for (int i = 0; i < (int) args.size(); i++) {
+    if (args[i].final_use) ReleaseVar(registers, args[i].var_id);
+  }
+  for (int var_id : pin_end) {
+    TC_Reg & reg = registers[ FindReg(registers, var_id) ];
+    if (live_after.count(var_id) && !IsJump()) SpillReg(ofs, reg);   // Still needed from memory
+    reg.var_id = -1;
+    reg.pinned = false;
+    reg.dirty = false;
+  }
+}
 
 
 //////////////
@@ -338,42 +1187,200 @@ IC_Entry & IC_Array::AddLabel(std::string label_id, std::string cmt)
 }
 
 
+void IC_Array::AddFunction(tableFunction * fun)
+{
+  AddFunction(fun, fun->GetCallLabel(), std::vector<std::string>(fun->GetArgs().size()));
+}
+
+void IC_Array::AddFunction(tableFunction * fun, const std::string & label,
+                           const std::vector<std::string> & const_args)
+{
+  IC_Entry signature;   // Use AddArg() to describe each variable.
+  for (int i = 0; i < (int) fun->GetArgs().size(); i++) {
+    if (const_args[i] == "") signature.AddArg(fun->GetArgs()[i]);
+  }
+  signature.AddArg(fun);
+
+  IC_Function & info = functions[label];
+  info.ret = signature.args.back();
+  signature.args.pop_back();
+  info.params = signature.args;
+  info.pure = fun->GetEffects().IsPure();
+}
+
+
+void IC_Array::AddLiteral(tableEntry * var, const std::vector<std::string> & values)
+{
+  literals[var->GetVarID()] = values;
+}
+
+void IC_Array::AddLiteralPool()
+{
+  // Add the code at the end, then rotate it around to the front.
+  const int old_size = (int) ic_array.size();
+  for (auto & literal : literals) {
+    const IC_Argument pool_var(std::string("a") + std::to_string(literal.first), literal.first, IC_Argument::ARG_ARRAY);
+    const std::vector<std::string> & values = literal.second;
+    IC_Entry resize("ar_set_siz", "", "Fill in a pooled array literal.");
+    resize.args.push_back(pool_var);
+    resize.AddArg(std::to_string(values.size()));
+    ic_array.push_back(resize);
+    for (int i = 0; i < (int) values.size(); i++) {
+      IC_Entry set("ar_set_idx");
+      set.args.push_back(pool_var);
+      set.AddArg(std::to_string(i));
+      set.AddArg(values[i]);
+      ic_array.push_back(set);
+    }
+  }
+  std::rotate(ic_array.begin(), ic_array.begin() + old_size, ic_array.end());
+}
+
+
 void IC_Array::PrintIC(std::ostream & ofs)
 {
   ofs << "# Ouput from Dr. Charles Ofria's reference code." << std::endl;
+
+  // TubeIC has no jump tables, and cannot load or store through an address, so these
+  // are written out as chains of tests whose results go in a spare variable, numbered
+  // past all of those in use (including every element of a fixed-size array).
+  int spare_id = 0;
+  for (const IC_Entry & entry : ic_array) {
+    for (const IC_Argument & arg : entry.args) spare_id = std::max(spare_id, arg.var_id + 1);
+    if ((entry.inst == "load" || entry.inst == "store") && entry.args.size() == 4) {
+      spare_id = std::max(spare_id, std::stoi(entry.args[2].str_value) + std::stoi(entry.args[3].str_value));
+    }
+  }
+  const IC_Argument spare(std::string("s") + std::to_string(spare_id), spare_id, IC_Argument::ARG_SCALAR);
+  auto const_arg = [](int value) { return IC_Argument(std::to_string(value), -1, IC_Argument::ARG_CONST); };
+
   for (int i = 0; i < (int) ic_array.size(); i++) {
-    ic_array[i].PrintIC(ofs);
+    const std::string inst = ic_array[i].inst;
+    if (inst != "jump_table" && inst != "load" && inst != "store") {
+      ic_array[i].PrintIC(ofs);
+      continue;
+    }
+    IC_Entry line(ic_array[i]);   // Keeps the label (for the first line) and block info
+    const std::vector<IC_Argument> args = ic_array[i].args;
+    auto print = [&line, &ofs](const std::string & inst, const std::vector<IC_Argument> & args) {
+      line.inst = inst;
+      line.args = args;
+      line.PrintIC(ofs);
+      line.label = line.comment = "";
+    };
+
+    if (inst == "jump_table") {
+      for (int index = 0; index + 2 < (int) args.size(); index++) {
+        if (args[index + 2].str_value == args[1].str_value) continue;
+        print("test_equ", { args[0], const_arg(index), spare });
+        print("jump_if_n0", { spare, args[index + 2] });
+      }
+      print("jump", { args[1] });
+      continue;
+    }
+
+    // The address is already known to be in the array, so the element is the first
+    // one whose cell comes after it.
+    const int first = std::stoi(args[2].str_value);
+    const int count = std::stoi(args[3].str_value);
+    const std::string end_label = "fixed_access_" + std::to_string(i);
+    for (int k = 0; k < count; k++) {
+      const std::string next_label = end_label + "_" + std::to_string(k + 1);
+      const int var_id = first + k;
+      const IC_Argument element(std::string("s") + std::to_string(var_id), var_id, IC_Argument::ARG_SCALAR);
+      if (k + 1 < count) {
+        print("test_less", { args[inst == "load" ? 0 : 1], const_arg(var_id + 1), spare });
+        print("jump_if_0", { spare, IC_Argument(next_label, -1, IC_Argument::ARG_CONST) });
+      }
+      if (inst == "load") print("val_copy", { element, args[1] });
+      else print("val_copy", { args[0], element });
+      if (k + 1 < count) {
+        print("jump", { IC_Argument(end_label, -1, IC_Argument::ARG_CONST) });
+        line.label = next_label;
+      }
+    }
+    if (count > 1) {
+      line.label = end_label;
+      print("", {});
+    }
   }
 }
 
 void IC_Array::PrintTubeCode(std::ostream & ofs)
 {
   const int stack_start = 10000;
-  const int stack_size = 10000;
-  const int free_start = stack_start + stack_size;
-
-  std::vector<TC_Reg> registers;
-  TC_Reg reg0;
-  reg0.name ="regA";
-  TC_Reg reg1;
-  reg1.name ="regB";
-  TC_Reg reg2;
-  reg2.name ="regC";
-  TC_Reg reg3;
-  reg3.name ="regD";
-
-  registers.push_back(reg0);
-  registers.push_back(reg1);
-  registers.push_back(reg2);
-  registers.push_back(reg3);
+  const int heap_start = HeapStart();
+
+  // regA through regG can cache variables; regH is reserved as the stack pointer.
+  std::vector<TC_Reg> registers(7);
+  for (int i = 0; i < (int) registers.size(); i++) {
+    registers[i].name = std::string("reg") + (char) ('A' + i);
+  }
+
+  // Clean up calls to pure functions (dropping any specialized copies no longer
+  // called), then work out what is live where and give the busiest variables their
+  // own registers.
+  ShareLiterals();
+  std::vector<IC_Block> blocks = BuildCFG();
+  PropagateConstants(blocks);
+  RemoveDeadBlocks(BuildCFG());
+  ScalarizeArrays();
+  OptimizePureCalls();
+  RemoveDeadBlocks(BuildCFG());
+  blocks = BuildCFG();
+  AssignCallingConventions(blocks);
+  ComputeLiveness(blocks);
+  PropagateConstants(blocks);
+  ForwardArrayValues(blocks);
+  ComputeLiveness(blocks);
+  ShareArrays(blocks);
+  blocks = BuildCFG();
+  ComputeLiveness(blocks);
+  FreeDeadArrays(blocks);
+  blocks = BuildCFG();
+  ComputeLiveness(blocks);
+  AnalyzeArraySizes(blocks);
+  ComputeLiveness(blocks);
+  MarkFinalUses();
+  AllocateRegisters(blocks, (int) registers.size());
 
   ofs << "#=-=-= Ouput from Dr. Charles Ofria's sample compiler." << std::endl
       << "  val_copy " << stack_start << " regH                      # Setup regH to point to start of stack." << std::endl
-      << "  store " << free_start << " 0                            # Store next free memory at 0" << std::endl;
+      << "  store " << heap_start << " 0                            # Store next free memory at 0" << std::endl;
+  if (use_gc) {
+    ofs << "  store " << free_lists << " " << array_stack_ptr << "                     # The array stack starts out empty." << std::endl
+        << "  store " << heap_start + gc_min_heap << " " << gc_limit << std::endl;
+  }
+
+  // Include the memory allocator if the program builds any arrays; every array
+  // variable is a root for the collector.
+  bool uses_arrays = false;
+  std::set<int> roots;
+  for (const IC_Entry & entry : ic_array) {
+    if (entry.inst == "ar_set_siz" || entry.inst == "ar_copy") uses_arrays = true;
+    for (const IC_Argument & arg : entry.args) if (arg.IsArray()) roots.insert(arg.var_id);
+  }
+  if (uses_arrays) PrintAllocator(ofs, roots);
 
-  // Convert each line of intermediate code, one at a time.
+  // Convert each line of intermediate code, one at a time, noting what it will cost.
   for (int i = 0; i < (int) ic_array.size(); i++) {
-    ic_array[i].PrintTubeCode(ofs, registers);
+    std::stringstream entry_code;
+    ic_array[i].PrintTubeCode(entry_code, registers);
+    ic_array[i].cycles = 0;
+    std::string line;
+    while (std::getline(entry_code, line)) {
+      std::stringstream line_ss(line);
+      std::string tc_inst;
+      line_ss >> tc_inst;
+      if (tc_inst == "" || tc_inst[0] == '#' || tc_inst.back() == ':') continue;
+      ic_array[i].cycles += cost_table.TubeCode(tc_inst);
+      // Only one row of a jump table runs after the jump into it.
+      if (ic_array[i].inst == "jump_table" && tc_inst == "jump") {
+        ic_array[i].cycles += cost_table.TubeCode("jump");
+        break;
+      }
+    }
+    ofs << entry_code.str();
   }
 }
 
@@ -396,10 +1403,25 @@ bool IC_Entry::Find(std::string str_val) {
 
 
 void IC_Array::AddBlock() {
+  // A basic block ends after any jump and a new one begins at any label.
   int cnt = 1;
+  bool block_empty = true;
   for (int i = 0; i < (int) ic_array.size(); i++) {
+    if (ic_array[i].label != "" && !block_empty) { cnt++; }
     ic_array[i].block = cnt;
-    if (ic_array[i].inst == "jump") { cnt++; }
+    block_empty = false;
+    if (ic_array[i].IsJump()) { cnt++; block_empty = true; }
+  }
+}
+
+
+// Flag each argument whose variable is no longer needed after its entry, so its
+// register can be released without storing it.  Requires ComputeLiveness().
+void IC_Array::MarkFinalUses() {
+  for (IC_Entry & entry : ic_array) {
+    for (IC_Argument & arg : entry.args) {
+      arg.final_use = !arg.IsConst() && entry.live_after.count(arg.var_id) == 0;
+    }
   }
 }
 
@@ -412,6 +1434,7 @@ void IC_Array::AddLocal() {
   for (int i = ic_array.size()-1; i >= 0; i--) {
     int block1 = ic_array[i].block;
     std::vector<IC_Argument> args1 = ic_array[i].args;
+    if (ic_array[i].local_arr.size() < args1.size()) ic_array[i].local_arr.resize(args1.size(), false);
 
     for(int n = 0; n < (int) args1.size(); n++) {
       std::string str_val2 = args1[n].str_value;
@@ -459,135 +1482,129 @@ void IC_Array::AddLocal() {
 // }
 
 
+namespace {
+  // Turn an entry into "val_copy from to", keeping its label and comment.
+  void MakeCopy(IC_Entry & entry, IC_Argument from, IC_Argument to)
+  {
+    IC_Entry copy("val_copy", entry.label, entry.comment);
+    copy.args.push_back(from);
+    copy.args.push_back(to);
+    entry = copy;
+  }
+
+  bool IsMath(const std::string & inst)
+  {
+    return inst == "add" || inst == "sub" || inst == "mult" || inst == "div" || inst == "mod" ||
+      inst == "test_less" || inst == "test_gtr" || inst == "test_equ" ||
+      inst == "test_nequ" || inst == "test_gte" || inst == "test_lte";
+  }
+
+  bool IsConstArg(const IC_Argument & arg, const std::string & value)
+  {
+    return arg.IsConst() && arg.str_value == value;
+  }
+}
+
+// Peephole clean-ups.  Each rewrite only fires when the temporary it removes is
+// dead afterward (per ComputeLiveness), so user variables and values needed later
+// on are never lost.
 void IC_Array::AlgebraicOpt() {
+  // Index of the next non-empty entry after i that control must flow straight into.
+  auto next_entry = [this](int i) {
+    for (int j = i + 1; j < (int) ic_array.size(); j++) {
+      if (ic_array[j].label != "") return -1;
+      if (ic_array[j].inst != "") return j;
+    }
+    return -1;
+  };
+  auto is_dead_after = [this](int var_id, int i) {
+    return ic_array[i].live_after.count(var_id) == 0;
+  };
+
   // according to test file #1
-  for (int i = 0; i <= (int) ic_array.size() -1; i++) {
-    // eliminating mathematical calculation
-    if (ic_array[i].inst == "val_copy" && (ic_array[i].args[0].str_value[0]!='s') &&
-         (ic_array[i+1].inst == "add" ||
-          ic_array[i+1].inst == "div" ||
-          ic_array[i+1].inst == "sub" ||
-          ic_array[i+1].inst == "mult" ||
-          ic_array[i+1].inst == "test_less" ||
-          ic_array[i+1].inst == "test_gtr" ||
-          ic_array[i+1].inst == "test_equ" ||
-          ic_array[i+1].inst == "test_nequ" ||
-          ic_array[i+1].inst == "test_gte" ||
-          ic_array[i+1].inst == "test_lte")) {
-      ic_array[i+1].args[1].str_value = ic_array[i].args[0].str_value;
-      // std::cout << ic_array[i].args[0].str_value[0] << std::endl;
-      ic_array[i+1].args[1].arg_type = ic_array[i].args[0].arg_type;
-      ic_array[i].inst = "";
-      ic_array[i].store2 = false;
-      ic_array[i].args.clear();
-    }
-
-    // elmination random calculation
-    if (ic_array[i].inst == "val_copy" && (ic_array[i].args[0].str_value[0]!='s') &&
-         (ic_array[i+1].inst == "random")) {
-
-      ic_array[i+1].args[0].str_value = ic_array[i].args[0].str_value;
-      // std::cout << ic_array[i].args[0].str_value[0] << std::endl;
-      ic_array[i+1].args[0].arg_type = ic_array[i].args[0].arg_type;
-      ic_array[i].inst = "";
-      // ic_array[i].load1 = false;
-      ic_array[i].store2 = false;
-      ic_array[i].args.clear();
-    }
-
-    // elmination
-    // val_copy 10 s4
-    // ar_set_siz a1 s4
-    if (ic_array[i].inst == "val_copy" && (ic_array[i].args[0].str_value[0]!='s') && (ic_array[i+1].inst == "ar_set_siz")) {
-      ic_array[i+1].args[1] = ic_array[i].args[0];
-      ic_array[i].inst = "";
-      ic_array[i].args.clear();
-      ic_array[i].load1 = false;
-      ic_array[i].store2 = false;
-    }
-  }
-
-  // according to test file #4 
+  // val_copy 10 s4
+  // add s4 s5 s6     =>     add 10 s5 s6
+  std::vector<IC_Block> blocks = BuildCFG();
+  ComputeLiveness(blocks);
   for (int i = 0; i < (int) ic_array.size(); i++) {
-    // change add 0 to val_copy
-    if (ic_array[i].inst == "add" && ic_array[i].args[1].str_value == "0") {
-      ic_array[i].inst = "val_copy";
-      ic_array[i].load2 = false;
-      ic_array[i].store3 = false;
-      ic_array[i].store2 = true;
-
-      ic_array[i].args[1] = ic_array[i].args[2];
-      ic_array[i].args.pop_back();
+    const IC_Entry & copy = ic_array[i];
+    if (copy.inst != "val_copy" || !copy.args[0].IsConst()) continue;
+    const int j = next_entry(i);
+    if (j == -1) continue;
+    IC_Entry & next = ic_array[j];
+    if (!IsMath(next.inst) && next.inst != "random" && next.inst != "ar_set_siz") continue;
+
+    const int var_id = copy.args[1].var_id;
+    bool redefined = false;
+    for (int k = 0; k < (int) next.args.size(); k++) {
+      if (next.IsStore(k) && next.args[k].var_id == var_id) redefined = true;
     }
-    // change mult 1 to valcopy
-    if (ic_array[i].inst == "mult" && ic_array[i].args[1].str_value == "1") {
-      ic_array[i].inst = "val_copy";
-      ic_array[i].load2 = false;
-      ic_array[i].store3 = false;
-      ic_array[i].store2 = true;
-
-      ic_array[i].args[1] = ic_array[i].args[2];
-      ic_array[i].args.pop_back();
+    if (!redefined && !is_dead_after(var_id, j)) continue;
+    for (int k = 0; k < (int) next.args.size(); k++) {
+      if (next.IsLoad(k) && !next.args[k].IsConst() && next.args[k].var_id == var_id) {
+        next.args[k] = copy.args[0];
+      }
     }
+    ic_array[i].Clear();
+  }
 
-    if (ic_array[i].inst == "mult" && ic_array[i].args[1].str_value == "0") {
-      ic_array[i].inst = "val_copy";
-      ic_array[i].load2 = false;
-      ic_array[i].store3 = false;
-      ic_array[i].store2 = true;
-
-      ic_array[i].args[0] = ic_array[i].args[1];
-      ic_array[i].args[1] = ic_array[i].args[2];
-      ic_array[i].args.pop_back();
+  // according to test file #4
+  for (int i = 0; i < (int) ic_array.size(); i++) {
+    IC_Entry & entry = ic_array[i];
+    if (entry.args.size() != 3) continue;
+    // change add 0 and mult 1 to val_copy
+    if ((entry.inst == "add" && IsConstArg(entry.args[1], "0")) ||
+        (entry.inst == "mult" && IsConstArg(entry.args[1], "1"))) {
+      MakeCopy(entry, entry.args[0], entry.args[2]);
+    }
+    else if ((entry.inst == "add" && IsConstArg(entry.args[0], "0")) ||
+             (entry.inst == "mult" && IsConstArg(entry.args[0], "1"))) {
+      MakeCopy(entry, entry.args[1], entry.args[2]);
+    }
+    // change mult 0 to val_copy
+    else if (entry.inst == "mult" && IsConstArg(entry.args[1], "0")) {
+      MakeCopy(entry, entry.args[1], entry.args[2]);
+    }
+    // change mod 1 (or -1) to val_copy 0
+    else if (entry.inst == "mod" && (IsConstArg(entry.args[1], "1") || IsConstArg(entry.args[1], "-1"))) {
+      MakeCopy(entry, IC_Argument("0", -1, IC_Argument::ARG_CONST), entry.args[2]);
     }
   }
+
   // eliminating useless val_copy
+  // val_copy s1 s2
+  // val_copy s2 s3   =>   val_copy s1 s3
+  blocks = BuildCFG();
+  ComputeLiveness(blocks);
   for (int i = 0; i < (int) ic_array.size(); i++) {
-
-    if (ic_array[i].inst == "val_copy") {
-
-      for (int j = i+1; j < (int) ic_array.size(); j++) {
-        if (ic_array[j].inst == "") { continue; }
-
-        else if (ic_array[j].inst != "val_copy") { break; }
-
-        else if (ic_array[j].inst == "val_copy" && (ic_array[j].args[0].str_value == ic_array[i].args[1].str_value)) {
-
-          ic_array[j].args[0] = ic_array[i].args[0];
-          ic_array[j].store2 = true;
-          ic_array[i].inst = "";
-          ic_array[i].store2 = false;
-          ic_array[i].args.clear();
-        }
-      }
-    }
+    const IC_Entry & first = ic_array[i];
+    if (first.inst != "val_copy") continue;
+    const int j = next_entry(i);
+    if (j == -1 || ic_array[j].inst != "val_copy") continue;
+    IC_Entry & second = ic_array[j];
+    const int var_id = first.args[1].var_id;
+    if (second.args[0].IsConst() || second.args[0].var_id != var_id) continue;
+    if (second.args[1].var_id != var_id && !is_dead_after(var_id, j)) continue;
+    second.args[0] = first.args[0];
+    ic_array[i].Clear();
   }
 
-  // for (int i = 0; i < (int) ic_array.size() -1; i++) {
-  //   if (ic_array[i].inst == "val_copy" && (ic_array[i+1].inst == "out_char")) {
-  //     ic_array[i+1].args[0] = ic_array[i].args[0];
-  //     ic_array[i].inst = "";
-  //     ic_array[i].store2 = false;
-  //     ic_array[i].args.clear();
-  //   }
-  // }
-
   // eliminating
   //  add s1 1 s16
-  //  val_copy s16 s1
-  for (int i = 0; i < (int) ic_array.size()-1; i++) {
-    if ((ic_array[i].inst == "add" ||
-         ic_array[i+1].inst == "div" ||
-         ic_array[i+1].inst == "sub" ||
-         ic_array[i+1].inst == "mult") &&
-      (ic_array[i].args[1].str_value[0] != 's') && (ic_array[i+1].inst == "val_copy")) {
-      ic_array[i].args[2] = ic_array[i+1].args[1];
-      ic_array[i+1].inst = "";
-      ic_array[i+1].args.clear();
-      ic_array[i+1].load1 = false;
-      ic_array[i+1].store2 = false;
-
-    }
+  //  val_copy s16 s1   =>   add s1 1 s1
+  blocks = BuildCFG();
+  ComputeLiveness(blocks);
+  for (int i = 0; i < (int) ic_array.size(); i++) {
+    IC_Entry & op = ic_array[i];
+    if (op.inst != "add" && op.inst != "sub" && op.inst != "mult" && op.inst != "div" && op.inst != "mod") continue;
+    const int j = next_entry(i);
+    if (j == -1 || ic_array[j].inst != "val_copy") continue;
+    const IC_Entry & copy = ic_array[j];
+    const int var_id = op.args[2].var_id;
+    if (copy.args[0].IsConst() || copy.args[0].var_id != var_id) continue;
+    if (copy.args[1].var_id != var_id && !is_dead_after(var_id, j)) continue;
+    op.args[2] = copy.args[1];
+    ic_array[j].Clear();
   }
 }
 
@@ -16,30 +16,56 @@
 //
 
 #include <iostream>
+#include <map>
+#include <set>
 #include <string>
 #include <sstream>
 #include <vector>
 
 #include "symbol_table.h"
 
+extern bool use_gc;   // Emit a garbage collector for the array heap (-gc)?
+
+// A TubeCode register and the IC variable (if any) whose value it currently caches.
 struct TC_Reg {
   std::string name = "";
-  std::string val = "";
+  int var_id = -1;        // Variable held in this register (-1 if none)
+  bool dirty = false;     // Has the value changed since it was last stored to memory?
+  int last_use = 0;       // When was this register last touched (for picking what to evict)?
+  bool pinned = false;    // Is this register dedicated to var_id by the global allocator?
+};
+
+// A variable that the global register allocator moves into a dedicated register.
+struct TC_Pin {
+  int var_id;             // Variable being kept in the register
+  int reg_id;             // Index of the register it gets
+  bool load;              // Does its current value need to be loaded from memory first?
+};
+
+// A basic block of intermediate code along with its control-flow information.
+struct IC_Block {
+  int first = 0;                // Index of the first entry in this block
+  int last = -1;                // Index of the last entry in this block
+  int region = -1;              // Which code region (main or a function body) this is in; -1 if unreachable
+  int loop_depth = 0;           // How many loops is this block nested inside of?
+  std::vector<int> succ;        // Blocks that control can move to next
+  std::vector<int> pred;        // Blocks that control can arrive from
+  std::set<int> live_in;        // Variables whose current value may be needed on entry
+  std::set<int> live_out;       // Variables whose current value may be needed on exit
+  std::map<int, std::string> const_in;  // Variables known to hold a constant on entry
 };
 
 struct IC_Argument {
   std::string str_value;   // The output representation for this argument.
   int var_id;              // The ID for this argument if it is a variable.
+  bool final_use;          // Is the variable dead once this instruction finishes?
 
-  // NOTE: This would also be a go place to have extra data about this argument.
-  //       For example, is it the final use of a variable?
-  
   enum Type { ARG_NONE, ARG_CONST, ARG_SCALAR, ARG_ARRAY };
   Type arg_type;
 
-  IC_Argument() : str_value(""), var_id(-1), arg_type(ARG_NONE) { ; }
+  IC_Argument() : str_value(""), var_id(-1), final_use(false), arg_type(ARG_NONE) { ; }
   IC_Argument(const std::string & in_str, int in_id, Type in_type)
-    : str_value(in_str), var_id(in_id), arg_type(in_type) { ; }
+    : str_value(in_str), var_id(in_id), final_use(false), arg_type(in_type) { ; }
   IC_Argument(const IC_Argument &) = default;
   
   bool IsConst() const { return arg_type == ARG_CONST; }
@@ -47,6 +73,13 @@ struct IC_Argument {
   bool IsArray() const { return arg_type == ARG_ARRAY; }
 };
 
+// A character written as a TubeCode constant, such as 'a' or '\n'.
+std::string CharConst(char c);
+
+// What the VM's "mod" gives for a and b: both are cut down to whole numbers and the
+// result takes the sign of a.  False if it would fail (or overflow) at run time.
+bool ModValue(double a, double b, double & out);
+
 struct IC_Entry {
   std::string label;             // Label on this line, if any.
   std::string inst;              // Instruction name on this line, if any.
@@ -55,6 +88,22 @@ struct IC_Entry {
   int block;
   std::vector<bool> local_arr;
 
+  // Information filled in by the flow analysis for the TubeCode back end.
+  bool is_call;                  // Does this jump start a function call?
+  bool after_call;               // Is this the label a function call returns to?
+  std::set<int> live_after;      // Variables that are still needed after this entry
+  std::vector<TC_Pin> pin_start; // Variables that move into a dedicated register here
+  std::vector<int> pin_end;      // Variables whose dedicated register is released after this entry
+  std::vector<int> reg_vars;     // Scalars passed in regA, regB, ... at this call or function entry
+  int reg_return;                // Scalar passed back in regA at this call, return point, or return (-1 if none)
+  int cycles;                    // Estimated cycles for the TubeCode generated from this entry
+  bool array_owned;              // Can ar_set_siz free the old block when it moves the array?
+
+  // What ar_set_siz (or ar_get_siz) knows beforehand: nothing, that the array is initialized,
+  // that it is still uninitialized, or that it is initialized and the new size is no larger.
+  enum ResizeKind { RESIZE_ANY, RESIZE_INIT, RESIZE_EMPTY, RESIZE_SHRINK };
+  ResizeKind resize_kind;
+
   // Do we need to load and/or store each of the arguments for this instruction?
   bool load1;   bool load2;   bool load3;
   bool store1;  bool store2;  bool store3;
@@ -77,10 +126,29 @@ struct IC_Entry {
   std::string LocalString();
   bool Find(std::string str_val);
 
-  // NOTE: Given that optimizations involve changing entries into simpler ones
-  //       (and sometimes removing them all togehter), you probably want a Clear()
-  //       method that is careful to remove all former information so that you
-  //       can easily reset it how you want it.
+  void Clear();   // Turn this entry into an empty line (its label, comment and what's
+                  // known about the label, such as register arguments, are kept).
+
+  bool IsJump() const {
+    return inst == "jump" || inst == "jump_if_0" || inst == "jump_if_n0" || inst == "jump_table";
+  }
+  bool IsLoad(int arg_id) const;    // Does this instruction read argument arg_id?
+  bool IsStore(int arg_id) const;   // Does this instruction write argument arg_id?
+};
+
+// The variables a function uses to receive its arguments and return its result.
+struct IC_Function {
+  std::vector<IC_Argument> params;  // Parameters, in order
+  IC_Argument ret;                  // Return value
+  bool pure = false;                // Does the result depend only on the arguments, with no side effects?
+
+  // Filled in by IC_Array::SummarizeFunctions(); each includes the functions it calls.
+  int region = -1;                  // Code region of the body (-1 if never reached)
+  std::set<int> mod;                // Variables it may change
+  std::set<int> ref;                // Variables it may read
+  std::set<int> array_mod;          // Arrays whose elements or size it may change
+  std::vector<bool> param_mutated;  // Might each array parameter be changed inside?
+  std::vector<bool> param_escapes;  // Might each array parameter be copied somewhere else?
 };
 
 ///////////////
@@ -89,12 +157,26 @@ struct IC_Entry {
 class IC_Array {
 private:
   std::vector<IC_Entry> ic_array;
+  std::map<std::string, IC_Function> functions;   // Function signatures, by call label
+  std::map<int, std::vector<std::string>> literals;  // Pooled array literals' elements, by var_id
+  std::set<int> literal_arrays;                   // Arrays that may share a pooled literal's block
+
+  // Summary for the function this entry calls (NULL if not a call or not summarized).
+  const IC_Function * FindCallee(const IC_Entry & entry) const;
 
 public:
   IC_Array() { ; }
   ~IC_Array() { ; }
 
   IC_Entry & AddLabel(std::string label_id, std::string cmt="");
+  // Record the signature of a function being compiled; a specialized copy gets its own
+  // label and takes no parameters for the constant arguments ("" for the others).
+  void AddFunction(tableFunction * fun);
+  void AddFunction(tableFunction * fun, const std::string & label, const std::vector<std::string> & const_args);
+  // Record the elements (as constants) of a pooled array literal, then (once all code is
+  // in) write the code that fills in the pool at the start of the program.
+  void AddLiteral(tableEntry * var, const std::vector<std::string> & values);
+  void AddLiteralPool();
 
   // Add() adds an instruction to the array; the following parameters are possible:
   //
@@ -134,6 +216,24 @@ public:
 
   void AddBlock();
   void AddLocal();
+  void MarkFinalUses();
+
+  // Flow analysis and register allocation (ic_flow.cc)
+  std::vector<IC_Block> BuildCFG();
+  void SummarizeFunctions(const std::vector<IC_Block> & blocks);
+  void ComputeLiveness(std::vector<IC_Block> & blocks);
+  void PropagateConstants(std::vector<IC_Block> & blocks);
+  void AssignCallingConventions(const std::vector<IC_Block> & blocks);
+  void ShareLiterals();
+  void ScalarizeArrays();
+  void ForwardArrayValues(const std::vector<IC_Block> & blocks);
+  void AnalyzeArraySizes(const std::vector<IC_Block> & blocks);
+  void ShareArrays(const std::vector<IC_Block> & blocks);
+  void FreeDeadArrays(const std::vector<IC_Block> & blocks);
+  void RemoveDeadBlocks(const std::vector<IC_Block> & blocks);
+  void OptimizePureCalls();
+  void AllocateRegisters(const std::vector<IC_Block> & blocks, int num_regs);
+  void PrintCostReport(std::ostream & ofs);   // Requires PrintTubeCode() to have been run.
 
   bool IsConstantOpt();
   bool IsAlgebraicOpt();
@@ -0,0 +1,2314 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+
+#include "ic.h"
+#include "tube_cost.h"
+
+// Flow analysis over the intermediate code, used by the TubeCode back end to keep
+// variables in registers across basic blocks.
+//
+// The program is split into basic blocks (see IC_Array::AddBlock) linked into a
+// control-flow graph.  A function call is treated as a single step that falls
+// through to its return label; the body of each function forms its own region.
+
+namespace {
+  // The variables a "load" or "store" through an address might reach: the count cells of
+  // a fixed-size array starting at first (its last two arguments).
+  bool StaticBlock(const IC_Entry & entry, int & first, int & count)
+  {
+    if ((entry.inst != "load" && entry.inst != "store") || entry.args.size() != 4) return false;
+    first = std::atoi(entry.args[2].str_value.c_str());
+    count = std::atoi(entry.args[3].str_value.c_str());
+    return true;
+  }
+
+  // One more than the largest variable ID an entry refers to.
+  int VarLimit(const IC_Entry & entry)
+  {
+    int limit = 0;
+    for (const IC_Argument & arg : entry.args) limit = std::max(limit, arg.var_id + 1);
+    int first, count;
+    if (StaticBlock(entry, first, count)) limit = std::max(limit, first + count);
+    return limit;
+  }
+
+  // Collect the variables an entry reads (uses) and writes (defs).
+  void EntryUseDef(const IC_Entry & entry, std::vector<int> & uses, std::vector<int> & defs)
+  {
+    for (int i = 0; i < (int) entry.args.size(); i++) {
+      const IC_Argument & arg = entry.args[i];
+      if (arg.IsConst() || arg.var_id < 0) continue;
+      if (entry.IsLoad(i)) uses.push_back(arg.var_id);
+      if (entry.IsStore(i)) defs.push_back(arg.var_id);
+    }
+    // Any element of a fixed-size array may be read through an address, and a store
+    // changes one of them while leaving the rest as they were.
+    int first, count;
+    if (StaticBlock(entry, first, count)) {
+      for (int v = first; v < first + count; v++) {
+        uses.push_back(v);
+        if (entry.inst == "store") defs.push_back(v);
+      }
+    }
+    // Resizing may move an array, which changes the pointer held in its variable.
+    if (entry.inst == "ar_set_siz" && entry.args.size() > 0) defs.push_back(entry.args[0].var_id);
+
+    // Values passed in registers are read by calls and returns, and set on arrival.
+    if (entry.inst == "") {
+      defs.insert(defs.end(), entry.reg_vars.begin(), entry.reg_vars.end());
+      if (entry.reg_return >= 0) defs.push_back(entry.reg_return);
+    } else if (entry.is_call) {
+      uses.insert(uses.end(), entry.reg_vars.begin(), entry.reg_vars.end());
+    } else if (entry.reg_return >= 0) {
+      uses.push_back(entry.reg_return);
+    }
+  }
+
+  // Does this entry read or write the given variable?
+  bool RefersTo(const IC_Entry & entry, int var_id)
+  {
+    std::vector<int> uses, defs;
+    EntryUseDef(entry, uses, defs);
+    return std::find(uses.begin(), uses.end(), var_id) != uses.end()
+      || std::find(defs.begin(), defs.end(), var_id) != defs.end();
+  }
+
+  // Does this instruction wipe out all of the registers (or leave the current code)?
+  bool IsClobber(const IC_Entry & entry)
+  {
+    return entry.is_call || entry.inst == "ar_copy";
+  }
+
+  // How many free registers does the block-local cache need to convert this entry?
+  int RegDemand(const IC_Entry & entry)
+  {
+    if (IsClobber(entry)) return 0;
+    std::set<int> vars;
+    for (const IC_Argument & arg : entry.args) if (!arg.IsConst()) vars.insert(arg.var_id);
+    int demand = (int) vars.size();
+    if (entry.inst == "ar_get_idx" || entry.inst == "ar_set_idx") demand++;  // Address scratch
+    if (entry.inst == "ar_free") demand += 2;
+    if (entry.inst == "ar_set_siz") demand += 3;
+    if (use_gc && (entry.inst == "ar_push" || entry.inst == "ar_pop")) demand++;
+    return demand;
+  }
+
+  int FindRoot(std::vector<int> & parent, int id)
+  {
+    while (parent[id] != id) id = parent[id] = parent[parent[id]];
+    return id;
+  }
+}
+
+
+// Split the code into basic blocks and link them together.
+std::vector<IC_Block> IC_Array::BuildCFG()
+{
+  AddBlock();
+
+  int num_blocks = 0;
+  for (const IC_Entry & entry : ic_array) num_blocks = std::max(num_blocks, entry.block);
+  std::vector<IC_Block> blocks(num_blocks);
+  for (int i = (int) ic_array.size() - 1; i >= 0; i--) blocks[ic_array[i].block - 1].first = i;
+  for (int i = 0; i < (int) ic_array.size(); i++) blocks[ic_array[i].block - 1].last = i;
+
+  // Find where each label is and which labels are return points for calls.
+  std::map<std::string, int> label_block;
+  std::set<std::string> return_labels;
+  for (IC_Entry & entry : ic_array) {
+    entry.is_call = false;
+    entry.after_call = false;
+    if (entry.label != "") label_block[entry.label] = entry.block - 1;
+    if (entry.inst == "push" && entry.args.size() && entry.args[0].IsConst()) {
+      return_labels.insert(entry.args[0].str_value);
+    }
+  }
+
+  // Link each block to the blocks that can follow it.
+  std::vector<int> entry_blocks(1, 0);
+  for (int b = 0; b < num_blocks; b++) {
+    IC_Entry & term = ic_array[blocks[b].last];
+    const bool has_next = b + 1 < num_blocks;
+    if (term.inst == "jump") {
+      const IC_Argument & target = term.args[0];
+      if (has_next && return_labels.count(ic_array[blocks[b+1].first].label)) {
+        // A function call; execution picks up at the return label afterward.
+        term.is_call = true;
+        ic_array[blocks[b+1].first].after_call = true;
+        blocks[b].succ.push_back(b+1);
+        if (label_block.count(target.str_value)) entry_blocks.push_back(label_block[target.str_value]);
+      }
+      else if (target.IsConst() && label_block.count(target.str_value)) {
+        blocks[b].succ.push_back(label_block[target.str_value]);
+      }
+      // Otherwise this is a return through a variable; it leaves the region.
+    }
+    else if (term.inst == "jump_table") {
+      for (int i = 1; i < (int) term.args.size(); i++) {
+        auto it = label_block.find(term.args[i].str_value);
+        if (it == label_block.end()) continue;
+        if (std::find(blocks[b].succ.begin(), blocks[b].succ.end(), it->second) == blocks[b].succ.end()) {
+          blocks[b].succ.push_back(it->second);
+        }
+      }
+    }
+    else if (term.inst == "jump_if_0" || term.inst == "jump_if_n0") {
+      if (label_block.count(term.args[1].str_value)) {
+        blocks[b].succ.push_back(label_block[term.args[1].str_value]);
+      }
+      if (has_next) blocks[b].succ.push_back(b+1);
+    }
+    else if (has_next) blocks[b].succ.push_back(b+1);
+  }
+  for (int b = 0; b < num_blocks; b++) {
+    for (int s : blocks[b].succ) blocks[s].pred.push_back(b);
+  }
+
+  // Mark the blocks reachable from the start of the program or a function entry.
+  std::vector<bool> reached(num_blocks, false);
+  std::vector<int> to_visit(entry_blocks);
+  while (to_visit.size()) {
+    int b = to_visit.back();
+    to_visit.pop_back();
+    if (reached[b]) continue;
+    reached[b] = true;
+    for (int s : blocks[b].succ) to_visit.push_back(s);
+  }
+
+  // Blocks linked by control flow (other than calls) belong to the same region.
+  std::vector<int> parent(num_blocks);
+  for (int b = 0; b < num_blocks; b++) parent[b] = b;
+  for (int b = 0; b < num_blocks; b++) {
+    if (!reached[b]) continue;
+    for (int s : blocks[b].succ) parent[FindRoot(parent, b)] = FindRoot(parent, s);
+  }
+  std::map<int, int> region_ids;
+  for (int b = 0; b < num_blocks; b++) {
+    if (!reached[b]) continue;
+    int root = FindRoot(parent, b);
+    if (region_ids.count(root) == 0) {
+      int next_id = (int) region_ids.size();
+      region_ids[root] = next_id;
+    }
+    blocks[b].region = region_ids[root];
+  }
+
+  // Any edge that goes backward closes a loop around the blocks it spans.
+  for (int b = 0; b < num_blocks; b++) {
+    if (!reached[b]) continue;
+    for (int s : blocks[b].succ) {
+      if (s > b) continue;
+      for (int k = s; k <= b; k++) blocks[k].loop_depth++;
+    }
+  }
+
+  return blocks;
+}
+
+
+// Record what each function may read and write (mod/ref), following calls so that
+// each summary covers everything that can run before the function returns.  Callers
+// then only need to assume a call touches those variables.
+void IC_Array::SummarizeFunctions(const std::vector<IC_Block> & blocks)
+{
+  std::map<int, IC_Function *> region_fun;
+  std::map<int, int> region_start;   // Block where each function's body begins
+  for (auto & fun : functions) {
+    IC_Function & info = fun.second;
+    info.region = -1;
+    info.mod.clear();
+    info.ref.clear();
+    info.array_mod.clear();
+    info.param_mutated.assign(info.params.size(), false);
+    info.param_escapes.assign(info.params.size(), false);
+  }
+  for (int b = 0; b < (int) blocks.size(); b++) {
+    auto fun = functions.find(ic_array[blocks[b].first].label);
+    if (blocks[b].region < 0 || fun == functions.end()) continue;
+    fun->second.region = blocks[b].region;
+    region_fun[blocks[b].region] = &fun->second;
+    region_start[blocks[b].region] = b;
+  }
+
+  // Direct effects of each function's own code, and which functions it calls.
+  std::map<int, std::set<int>> region_calls;
+  std::map<int, std::set<int>> region_copied;   // Arrays copied (or saved) in each region
+  for (const IC_Block & block : blocks) {
+    auto fun = region_fun.find(block.region);
+    if (fun == region_fun.end()) continue;
+    IC_Function & info = *fun->second;
+    for (int i = block.first; i <= block.last; i++) {
+      const IC_Entry & entry = ic_array[i];
+      std::vector<int> uses, defs;
+      EntryUseDef(entry, uses, defs);
+      info.mod.insert(defs.begin(), defs.end());
+      if ((entry.inst == "ar_set_idx" || entry.inst == "ar_set_siz") && !entry.args[0].IsConst()) {
+        info.array_mod.insert(entry.args[0].var_id);
+      }
+      if ((entry.inst == "ar_copy" || entry.inst == "ar_push" || entry.inst == "val_copy")
+          && entry.args[0].IsArray()) {
+        region_copied[block.region].insert(entry.args[0].var_id);
+      }
+      if (entry.is_call && functions.count(entry.args[0].str_value)) {
+        const int callee = functions[entry.args[0].str_value].region;
+        if (callee >= 0) region_calls[block.region].insert(callee);
+      }
+    }
+  }
+  for (auto & fun : region_fun) {
+    IC_Function & info = *fun.second;
+    for (int k = 0; k < (int) info.params.size(); k++) {
+      const int param = info.params[k].var_id;
+      if (!info.params[k].IsArray()) continue;
+      info.param_mutated[k] = info.array_mod.count(param) || info.mod.count(param);
+      info.param_escapes[k] = region_copied[fun.first].count(param);
+    }
+  }
+
+  // Fold in the effects of the functions called, until nothing more changes.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto & fun : region_fun) {
+      IC_Function & info = *fun.second;
+      const size_t old_size = info.mod.size() + info.array_mod.size();
+      for (int callee : region_calls[fun.first]) {
+        if (!region_fun.count(callee)) continue;
+        const IC_Function & sub = *region_fun[callee];
+        info.mod.insert(sub.mod.begin(), sub.mod.end());
+        info.array_mod.insert(sub.array_mod.begin(), sub.array_mod.end());
+      }
+      if (info.mod.size() + info.array_mod.size() != old_size) changed = true;
+    }
+  }
+
+  // A function reads the variables that are live where its body begins; a call
+  // inside it reads whatever that function reads.  Repeat until nothing changes.
+  std::vector<std::set<int>> live_in(blocks.size());
+  changed = true;
+  while (changed) {
+    changed = false;
+    for (int b = (int) blocks.size() - 1; b >= 0; b--) {
+      const IC_Block & block = blocks[b];
+      if (!region_fun.count(block.region)) continue;
+      std::set<int> live;
+      for (int s : block.succ) live.insert(live_in[s].begin(), live_in[s].end());
+      for (int i = block.last; i >= block.first; i--) {
+        std::vector<int> uses, defs;
+        EntryUseDef(ic_array[i], uses, defs);
+        for (int v : defs) live.erase(v);
+        live.insert(uses.begin(), uses.end());
+        if (const IC_Function * callee = FindCallee(ic_array[i])) {
+          live.erase(callee->ret.var_id);
+          live.insert(callee->ref.begin(), callee->ref.end());
+        }
+      }
+      if (live != live_in[b]) { live_in[b] = live; changed = true; }
+    }
+    for (auto & start : region_start) {
+      IC_Function & info = *region_fun[start.first];
+      if (info.ref != live_in[start.second]) { info.ref = live_in[start.second]; changed = true; }
+    }
+  }
+}
+
+const IC_Function * IC_Array::FindCallee(const IC_Entry & entry) const
+{
+  if (!entry.is_call) return NULL;
+  auto fun = functions.find(entry.args[0].str_value);
+  if (fun == functions.end() || fun->second.region < 0) return NULL;
+  return &fun->second;
+}
+
+
+// Let leaf functions (those that make no calls themselves) take their first few
+// scalar arguments in registers and hand back a scalar result in regA, instead of
+// passing them through memory.  A leaf cannot disturb variables it never refers
+// to, so callers also skip saving those on the stack around the call.
+void IC_Array::AssignCallingConventions(const std::vector<IC_Block> & blocks)
+{
+  const int max_reg_params = 3;
+
+  for (IC_Entry & entry : ic_array) { entry.reg_vars.clear(); entry.reg_return = -1; }
+
+  std::map<std::string, int> label_block;
+  for (int b = 0; b < (int) blocks.size(); b++) {
+    const std::string & label = ic_array[blocks[b].first].label;
+    if (label != "") label_block[label] = b;
+  }
+
+  // Note which regions make calls and which variables each one refers to.
+  std::set<int> calling_regions;
+  std::map<int, std::set<int>> region_vars;
+  for (const IC_Block & block : blocks) {
+    if (block.region < 0) continue;
+    for (int i = block.first; i <= block.last; i++) {
+      if (ic_array[i].is_call) calling_regions.insert(block.region);
+      for (const IC_Argument & arg : ic_array[i].args) {
+        if (!arg.IsConst()) region_vars[block.region].insert(arg.var_id);
+      }
+    }
+  }
+
+  for (const std::pair<const std::string, IC_Function> & fun : functions) {
+    auto found = label_block.find(fun.first);
+    if (found == label_block.end()) continue;
+    const IC_Block & entry_block = blocks[found->second];
+    const int region = entry_block.region;
+    if (region < 0 || region == blocks[0].region || calling_regions.count(region)) continue;
+    bool fall_in = false;   // Could the code before the function run into it?
+    for (int p : entry_block.pred) if (blocks[p].region >= 0) fall_in = true;
+    if (fall_in) continue;
+
+    std::vector<int> params;
+    std::set<int> all_params;
+    for (const IC_Argument & param : fun.second.params) {
+      all_params.insert(param.var_id);
+      if (param.IsScalar() && (int) params.size() < max_reg_params) params.push_back(param.var_id);
+    }
+    const int ret_id = fun.second.ret.IsScalar() ? fun.second.ret.var_id : -1;
+
+    ic_array[entry_block.first].reg_vars = params;
+    for (const IC_Block & block : blocks) {
+      IC_Entry & term = ic_array[block.last];
+      if (block.region == region && term.inst == "jump" && !term.args[0].IsConst()) {
+        term.reg_return = ret_id;
+      }
+    }
+
+    for (int i = 0; i + 1 < (int) ic_array.size(); i++) {
+      if (!ic_array[i].is_call || ic_array[i].args[0].str_value != fun.first) continue;
+      ic_array[i].reg_vars = params;
+      ic_array[i].reg_return = ret_id;
+      ic_array[i+1].reg_return = ret_id;
+
+      // Step back past the return address and arguments to find the saved variables...
+      auto is_blank = [](const IC_Entry & entry) { return entry.inst == "" && entry.label == ""; };
+      int pos = i - 1;
+      while (pos >= 0 && ic_array[pos].label == "") {
+        const IC_Entry & entry = ic_array[pos];
+        const bool is_arg = (entry.inst == "val_copy" || entry.inst == "ar_copy")
+          && all_params.count(entry.args[1].var_id);
+        if (!is_blank(entry) && !is_arg && !(entry.inst == "push" && entry.args[0].IsConst())) break;
+        pos--;
+      }
+      std::vector<int> saves;
+      while (pos >= 0 && ic_array[pos].label == "") {
+        const IC_Entry & entry = ic_array[pos];
+        if ((entry.inst == "push" || entry.inst == "ar_push") && !entry.args[0].IsConst()) saves.push_back(pos);
+        else if (!is_blank(entry)) break;
+        pos--;
+      }
+
+      // ...and forward past the return value to find where they are restored.
+      pos = i + 2;
+      std::vector<int> restores;
+      while (pos < (int) ic_array.size() && ic_array[pos].label == "") {
+        const IC_Entry & entry = ic_array[pos];
+        const bool is_result = (entry.inst == "val_copy" || entry.inst == "ar_copy")
+          && !entry.args[0].IsConst() && entry.args[0].var_id == fun.second.ret.var_id;
+        if (entry.inst == "pop" || entry.inst == "ar_pop") restores.push_back(pos);
+        else if (!is_blank(entry) && !(is_result && restores.empty())) break;
+        pos++;
+      }
+
+      // Saves and restores pair up from the inside out.
+      for (int k = 0; k < (int) saves.size() && k < (int) restores.size(); k++) {
+        IC_Entry & save = ic_array[saves[k]];
+        IC_Entry & restore = ic_array[restores[k]];
+        const int var_id = save.args[0].var_id;
+        if (restore.args[0].var_id != var_id) break;
+        if (region_vars[region].count(var_id)) continue;
+        save.Clear();
+        restore.Clear();
+      }
+    }
+  }
+}
+
+
+namespace {
+  // Read a constant argument (a number or a character) as a value.
+  bool ConstValue(const std::string & str, double & value)
+  {
+    if (str.size() >= 3 && str[0] == '\'') {
+      value = str[1];
+      if (str[1] == '\\') value = (str[2] == 'n') ? '\n' : (str[2] == 't') ? '\t' : str[2];
+      return true;
+    }
+    char * end = NULL;
+    value = std::strtod(str.c_str(), &end);
+    return str.size() && *end == '\0';
+  }
+  bool ConstValue(const IC_Argument & arg, double & value)
+  {
+    return arg.IsConst() && ConstValue(arg.str_value, value);
+  }
+
+  // Work out "inst in1 in2" on two constants; false if it can't be written exactly.
+  bool FoldMath(const std::string & inst, const std::string & in1, const std::string & in2,
+                std::string & result)
+  {
+    double a, b, out;
+    if (!ConstValue(in1, a) || !ConstValue(in2, b)) return false;
+    if (inst == "add") out = a + b;
+    else if (inst == "sub") out = a - b;
+    else if (inst == "mult") out = a * b;
+    else if (inst == "div") { if (b == 0.0) return false; out = a / b; }
+    else if (inst == "mod") { if (!ModValue(a, b, out)) return false; }
+    else if (inst == "test_less") out = (a < b);
+    else if (inst == "test_gtr") out = (a > b);
+    else if (inst == "test_equ") out = (a == b);
+    else if (inst == "test_nequ") out = (a != b);
+    else if (inst == "test_gte") out = (a >= b);
+    else if (inst == "test_lte") out = (a <= b);
+    else return false;
+
+    std::stringstream ss;
+    ss.precision(17);
+    ss << out;
+    result = ss.str();
+    return result.find_first_of("einf") == std::string::npos && std::strtod(result.c_str(), NULL) == out;
+  }
+}
+
+
+namespace {
+  // A call to a pure function, along with the entries that set it up and collect its result.
+  struct PureCall {
+    int call = -1;                   // The jump into the function
+    int first = -1;                  // First entry of the call sequence
+    int last = -1;                   // Last entry of the call sequence
+    int result = -1;                 // Entry copying out the return value (-1 if none)
+    std::vector<IC_Argument> args;   // Value passed for each parameter
+    std::string key;                 // Calls with the same key give the same result ("" if not comparable)
+    std::set<int> key_vars;          // Variables the key depends on
+  };
+
+  bool IsBlank(const IC_Entry & entry) { return entry.inst == "" && entry.label == ""; }
+
+  bool IsCopy(const IC_Entry & entry)
+  {
+    return (entry.inst == "val_copy" || entry.inst == "ar_copy") && entry.args.size() == 2;
+  }
+
+  // Remove an entry from the program completely.
+  void Erase(IC_Entry & entry)
+  {
+    entry.Clear();
+    entry.label = "";
+    entry.comment = "";
+  }
+}
+
+
+// Remove the code in blocks that can never run (such as branches ruled out by
+// PropagateConstants() or functions that are never called).
+void IC_Array::RemoveDeadBlocks(const std::vector<IC_Block> & blocks)
+{
+  for (const IC_Block & block : blocks) {
+    if (block.region >= 0) continue;
+    for (int i = block.first; i <= block.last; i++) {
+      ic_array[i].Clear();
+      ic_array[i].label = "";
+    }
+  }
+}
+
+
+// Treat calls to pure functions (see FunctionEffects) like any other calculation:
+// drop calls whose results are unused, hoist calls with loop-invariant arguments out
+// of loops, and reuse the result of an earlier call with the same arguments.  Since
+// a pure function cannot touch the caller's variables, nothing needs to be saved on
+// the stack around these calls either.
+void IC_Array::OptimizePureCalls()
+{
+  // Locate each call to a pure function and the code surrounding it.
+  auto find_calls = [this]() {
+    std::vector<PureCall> calls;
+    for (int i = 0; i + 1 < (int) ic_array.size(); i++) {
+      if (!ic_array[i].is_call) continue;
+      auto fun = functions.find(ic_array[i].args[0].str_value);
+      if (fun == functions.end() || !fun->second.pure) continue;
+      const IC_Function & sig = fun->second;
+
+      PureCall cur;
+      cur.call = i;
+      cur.args.resize(sig.params.size());
+      std::vector<bool> have_arg(sig.params.size(), false);
+      bool have_return = false;
+      std::vector<int> saves, restores;
+
+      // Step back over the return address, the arguments, and then any saved variables.
+      int pos = i - 1;
+      for (; pos >= 0 && ic_array[pos].label == ""; pos--) {
+        const IC_Entry & entry = ic_array[pos];
+        if (IsBlank(entry)) continue;
+        int param_id = -1;
+        for (int k = 0; k < (int) sig.params.size(); k++) {
+          if (IsCopy(entry) && entry.args[1].var_id == sig.params[k].var_id) param_id = k;
+        }
+        if (saves.size() == 0 && !have_return && entry.inst == "push" && entry.args[0].IsConst()
+            && entry.args[0].str_value == ic_array[i+1].label) {
+          have_return = true;
+        } else if (saves.size() == 0 && param_id != -1 && !have_arg[param_id]) {
+          cur.args[param_id] = entry.args[0];
+          have_arg[param_id] = true;
+        } else if ((entry.inst == "push" || entry.inst == "ar_push") && !entry.args[0].IsConst()) {
+          saves.push_back(pos);
+        } else break;
+      }
+      cur.first = pos + 1;
+
+      // Step forward over the return value and the restored variables.
+      cur.last = i + 1;
+      for (pos = i + 2; pos < (int) ic_array.size() && ic_array[pos].label == ""; pos++) {
+        const IC_Entry & entry = ic_array[pos];
+        if (IsBlank(entry)) continue;
+        if (cur.result == -1 && restores.size() == 0 && IsCopy(entry)
+            && !entry.args[0].IsConst() && entry.args[0].var_id == sig.ret.var_id) {
+          cur.result = pos;
+        } else if ((entry.inst == "pop" || entry.inst == "ar_pop") && restores.size() < saves.size()) {
+          restores.push_back(pos);
+        } else break;
+        cur.last = pos;
+      }
+
+      if (!have_return || std::find(have_arg.begin(), have_arg.end(), false) != have_arg.end()) continue;
+      if (saves.size() != restores.size()) continue;
+      bool matched = true;
+      for (int k = 0; k < (int) saves.size(); k++) {
+        if (ic_array[saves[k]].args[0].var_id != ic_array[restores[k]].args[0].var_id) matched = false;
+      }
+      if (!matched) continue;
+
+      // The callee can't reach the caller's variables, so don't bother saving them.
+      for (int k = 0; k < (int) saves.size(); k++) { Erase(ic_array[saves[k]]); Erase(ic_array[restores[k]]); }
+
+      // Calls are comparable if they only pass and return scalars.
+      bool comparable = sig.ret.IsScalar() && cur.result != -1 && ic_array[cur.result].args[1].IsScalar();
+      std::stringstream key;
+      key << ic_array[i].args[0].str_value << "(";
+      for (const IC_Argument & arg : cur.args) {
+        if (arg.IsArray()) comparable = false;
+        key << arg.str_value << " ";
+        if (!arg.IsConst()) cur.key_vars.insert(arg.var_id);
+      }
+      key << ")";
+      if (comparable) cur.key = key.str();
+      calls.push_back(cur);
+    }
+    return calls;
+  };
+
+  auto result_var = [this](const PureCall & call) { return ic_array[call.result].args[1].var_id; };
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    std::vector<IC_Block> blocks = BuildCFG();
+    ComputeLiveness(blocks);
+    std::vector<PureCall> calls = find_calls();
+
+    // Count the places each variable is set, so single-assignment results can be found.
+    std::map<int, int> def_count;
+    for (const IC_Entry & entry : ic_array) {
+      std::vector<int> uses, defs;
+      EntryUseDef(entry, uses, defs);
+      for (int v : defs) def_count[v]++;
+    }
+
+    // Dead-code elimination: calls whose results are never used can go.
+    for (const PureCall & call : calls) {
+      if (call.result != -1 && ic_array[call.result].live_after.count(result_var(call))) continue;
+      for (int i = call.first; i <= call.last; i++) Erase(ic_array[i]);
+      changed = true;
+    }
+    if (changed) continue;
+
+    // Loop-invariant code motion: a call at the top of a loop whose arguments don't
+    // change inside it can be made once, just before the loop.
+    for (int h = 1; h < (int) blocks.size() && !changed; h++) {
+      const IC_Block & header = blocks[h];
+      int loop_end = -1;
+      for (int p : header.pred) if (p >= h) loop_end = std::max(loop_end, p);
+      if (loop_end == -1 || header.region < 0) continue;
+      if (blocks[h-1].succ.size() != 1 || blocks[h-1].succ[0] != h) continue;
+      if (ic_array[blocks[h-1].last].IsJump()) continue;
+      bool single_entry = true;
+      for (int p : header.pred) if (p != h-1 && (p < h || p > loop_end)) single_entry = false;
+      if (!single_entry) continue;
+
+      std::set<int> loop_defs;
+      bool unknown_call = false;
+      for (int i = header.first; i <= blocks[loop_end].last; i++) {
+        std::vector<int> uses, defs;
+        EntryUseDef(ic_array[i], uses, defs);
+        loop_defs.insert(defs.begin(), defs.end());
+        if (const IC_Function * callee = FindCallee(ic_array[i])) {
+          loop_defs.insert(callee->mod.begin(), callee->mod.end());
+        } else if (ic_array[i].is_call) unknown_call = true;
+      }
+
+      for (const PureCall & call : calls) {
+        if (call.key == "" || call.first <= header.first || call.call > blocks[loop_end].last) continue;
+        if (def_count[result_var(call)] != 1 || header.live_in.count(result_var(call))) continue;
+
+        // The call must be reached on every pass through the loop, before any exit.
+        bool always_run = true;
+        for (int b = h; b < ic_array[call.call].block - 1; b++) {
+          if (blocks[b].succ.size() != 1 || blocks[b].succ[0] != b + 1) always_run = false;
+        }
+        bool invariant = true;
+        for (int v : call.key_vars) if (loop_defs.count(v) || unknown_call) invariant = false;
+        if (!always_run || !invariant) continue;
+
+        std::vector<IC_Entry> moved;
+        for (int i = call.first; i <= call.last; i++) {
+          if (!IsBlank(ic_array[i])) moved.push_back(ic_array[i]);
+        }
+        std::vector<IC_Entry> new_array;
+        for (int i = 0; i < (int) ic_array.size(); i++) {
+          if (i == header.first) new_array.insert(new_array.end(), moved.begin(), moved.end());
+          if (i < call.first || i > call.last) new_array.push_back(ic_array[i]);
+        }
+        ic_array.swap(new_array);
+        changed = true;
+        break;
+      }
+    }
+    if (changed) continue;
+
+    // Common subexpression elimination: find calls whose result is already available
+    // from an earlier call with the same arguments on every path.
+    std::map<int, int> result_key;                 // Result entry -> index into calls
+    std::set<std::string> all_keys;
+    for (int c = 0; c < (int) calls.size(); c++) {
+      if (calls[c].key == "") continue;
+      result_key[calls[c].result] = c;
+      all_keys.insert(calls[c].key);
+    }
+    if (all_keys.size() == 0) break;
+
+    auto step = [&](int i, std::set<std::string> & avail) {
+      const IC_Entry & entry = ic_array[i];
+      std::vector<int> uses, defs;
+      EntryUseDef(entry, uses, defs);
+      const IC_Function * callee = FindCallee(entry);
+      const bool unknown_call = entry.is_call && callee == NULL;
+      for (const PureCall & call : calls) {
+        if (call.key == "" || avail.count(call.key) == 0) continue;
+        bool killed = unknown_call && call.key_vars.size();
+        for (int v : defs) if (call.key_vars.count(v)) killed = true;
+        if (callee) for (int v : call.key_vars) if (callee->mod.count(v)) killed = true;
+        if (killed) avail.erase(call.key);
+      }
+      auto found = result_key.find(i);
+      if (found != result_key.end()) avail.insert(calls[found->second].key);
+    };
+
+    std::set<std::string> call_targets;
+    for (const IC_Entry & entry : ic_array) if (entry.is_call) call_targets.insert(entry.args[0].str_value);
+    const int num_blocks = (int) blocks.size();
+    std::vector<std::set<std::string>> avail_in(num_blocks), avail_out(num_blocks, all_keys);
+    bool updated = true;
+    while (updated) {
+      updated = false;
+      for (int b = 0; b < num_blocks; b++) {
+        if (blocks[b].region < 0) continue;
+        std::set<std::string> avail;
+        const bool region_start = (b == 0) || call_targets.count(ic_array[blocks[b].first].label);
+        if (!region_start) {
+          bool first = true;
+          for (int p : blocks[b].pred) {
+            if (blocks[p].region < 0) continue;
+            if (first) { avail = avail_out[p]; first = false; continue; }
+            std::set<std::string> both;
+            for (const std::string & key : avail) if (avail_out[p].count(key)) both.insert(key);
+            avail.swap(both);
+          }
+        }
+        avail_in[b] = avail;
+        for (int i = blocks[b].first; i <= blocks[b].last; i++) step(i, avail);
+        if (avail != avail_out[b]) { avail_out[b] = avail; updated = true; }
+      }
+    }
+
+    // Each key with a repeated call gets its own variable to hold the result.
+    std::vector<bool> repeated(calls.size(), false);
+    std::map<std::string, int> memo_ids;
+    for (int c = 0; c < (int) calls.size(); c++) {
+      if (calls[c].key == "") continue;
+      const int b = ic_array[calls[c].call].block - 1;
+      std::set<std::string> avail = avail_in[b];
+      for (int i = blocks[b].first; i < calls[c].call; i++) step(i, avail);
+      if (avail.count(calls[c].key) == 0) continue;
+      repeated[c] = true;
+      memo_ids[calls[c].key] = -1;
+    }
+    if (memo_ids.size() == 0) break;
+
+    int next_id = 0;
+    for (const IC_Entry & entry : ic_array) next_id = std::max(next_id, VarLimit(entry));
+    for (auto & fun : functions) {
+      for (const IC_Argument & param : fun.second.params) next_id = std::max(next_id, param.var_id + 1);
+      next_id = std::max(next_id, fun.second.ret.var_id + 1);
+    }
+    for (auto & memo : memo_ids) memo.second = next_id++;
+
+    // Repeated calls just copy the saved result; the others save their result for later.
+    std::map<int, IC_Entry> save_after;
+    for (int c = 0; c < (int) calls.size(); c++) {
+      const PureCall & call = calls[c];
+      auto memo = memo_ids.find(call.key);
+      if (memo == memo_ids.end()) continue;
+      const IC_Argument memo_arg("s" + std::to_string(memo->second), memo->second, IC_Argument::ARG_SCALAR);
+      IC_Entry & result = ic_array[call.result];
+      if (repeated[c]) {
+        for (int i = call.first; i <= call.last; i++) if (i != call.result) Erase(ic_array[i]);
+        result.args[0] = memo_arg;
+        result.comment = "Reuse result of identical call.";
+      } else {
+        IC_Entry save("val_copy");
+        save.args.push_back(result.args[1]);
+        result.args[1] = memo_arg;
+        save_after[call.result] = save;
+      }
+    }
+    std::vector<IC_Entry> new_array;
+    for (int i = 0; i < (int) ic_array.size(); i++) {
+      new_array.push_back(ic_array[i]);
+      auto save = save_after.find(i);
+      if (save == save_after.end()) continue;
+      IC_Entry copy = save->second;
+      copy.args.insert(copy.args.begin(), ic_array[i].args[1]);
+      new_array.push_back(copy);
+    }
+    ic_array.swap(new_array);
+    changed = true;
+  }
+}
+
+
+// Determine which variables may still be needed at each point in the code.  At a
+// call, anything visible to the callee counts as used; likewise at a return.
+void IC_Array::ComputeLiveness(std::vector<IC_Block> & blocks)
+{
+  const int num_blocks = (int) blocks.size();
+  SummarizeFunctions(blocks);
+
+  // Variables visible outside of their own region must be current in memory
+  // whenever control leaves that region.
+  std::vector<std::set<int>> region_vars;
+  std::map<int, std::set<int>> var_regions;
+  for (const IC_Block & block : blocks) {
+    if (block.region < 0) continue;
+    if (block.region >= (int) region_vars.size()) region_vars.resize(block.region + 1);
+    for (int i = block.first; i <= block.last; i++) {
+      std::vector<int> uses, defs;
+      EntryUseDef(ic_array[i], uses, defs);
+      for (int v : uses) { region_vars[block.region].insert(v); var_regions[v].insert(block.region); }
+      for (int v : defs) { region_vars[block.region].insert(v); var_regions[v].insert(block.region); }
+    }
+  }
+  // (Values passed in registers are handed over directly instead.)
+  std::set<int> reg_passed;
+  for (const IC_Entry & entry : ic_array) {
+    reg_passed.insert(entry.reg_vars.begin(), entry.reg_vars.end());
+    if (entry.reg_return >= 0) reg_passed.insert(entry.reg_return);
+  }
+  std::set<int> shared_vars;
+  for (auto & var : var_regions) {
+    if (var.second.size() > 1 && reg_passed.count(var.first) == 0) shared_vars.insert(var.first);
+  }
+
+  std::map<std::string, int> label_region;
+  for (const IC_Block & block : blocks) {
+    const std::string & label = ic_array[block.first].label;
+    if (label != "" && block.region >= 0) label_region[label] = block.region;
+  }
+
+  // A function's parameters are only read inside it, so they are dead once it returns.
+  std::map<int, std::set<int>> region_params;
+  for (auto & fun : functions) {
+    if (fun.second.region < 0) continue;
+    for (const IC_Argument & param : fun.second.params) region_params[fun.second.region].insert(param.var_id);
+  }
+
+  // A return also has to keep whatever its callers need afterward that the function,
+  // or anything it calls, refers to (such as a local array it will resize when called
+  // again).
+  std::map<int, std::vector<int>> region_returns;   // Blocks that calls into each region return to
+  std::map<int, std::set<int>> region_reach;        // Variables each region can get to
+  for (int b = 0; b + 1 < num_blocks; b++) {
+    const IC_Entry & term = ic_array[blocks[b].last];
+    if (!term.is_call || blocks[b].region < 0) continue;
+    auto it = label_region.find(term.args[0].str_value);
+    if (it != label_region.end()) region_returns[it->second].push_back(b + 1);
+  }
+  for (int r = 0; r < (int) region_vars.size(); r++) region_reach[r] = region_vars[r];
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto & region : region_returns) {
+      for (int b : region.second) {
+        std::set<int> & reach = region_reach[blocks[b - 1].region];
+        const size_t old_size = reach.size();
+        reach.insert(region_reach[region.first].begin(), region_reach[region.first].end());
+        if (reach.size() != old_size) changed = true;
+      }
+    }
+  }
+  std::map<int, std::set<int>> return_live;
+  auto find_return_live = [&]() {
+    for (auto & region : region_returns) {
+      std::set<int> & live = return_live[region.first];
+      for (int b : region.second) {
+        for (int v : blocks[b].live_in) if (region_reach[region.first].count(v)) live.insert(v);
+      }
+    }
+  };
+
+  // Find any extra variables that are needed when leaving a region at this entry.
+  auto exit_uses = [&](const IC_Entry & entry, int region, std::set<int> & uses) {
+    if (entry.inst != "jump") return;
+    if (entry.is_call) {
+      // A call only needs the values that the function (or anything it calls) reads;
+      // every way back from the function sets its return value.
+      if (const IC_Function * callee = FindCallee(entry)) {
+        uses.erase(callee->ret.var_id);
+        for (int v : callee->ref) if (v != entry.reg_return) uses.insert(v);
+        return;
+      }
+      uses.insert(shared_vars.begin(), shared_vars.end());
+      auto it = label_region.find(entry.args[0].str_value);
+      if (it != label_region.end()) {
+        for (int v : region_vars[it->second]) if (v != entry.reg_return) uses.insert(v);
+      }
+    }
+    else if (!entry.args[0].IsConst()) {
+      const std::set<int> & params = region_params[region];
+      for (int v : shared_vars) if (!params.count(v)) uses.insert(v);
+      uses.insert(return_live[region].begin(), return_live[region].end());
+    }
+  };
+
+  // Step backward through an entry, turning the set of variables live after it
+  // into those live before it.
+  auto step_back = [&](const IC_Entry & entry, int region, std::set<int> & live) {
+    std::vector<int> uses, defs;
+    EntryUseDef(entry, uses, defs);
+    for (int v : defs) live.erase(v);
+    live.insert(uses.begin(), uses.end());
+    exit_uses(entry, region, live);
+  };
+
+  for (IC_Block & block : blocks) { block.live_in.clear(); block.live_out.clear(); }
+
+  changed = true;
+  while (changed) {
+    changed = false;
+    find_return_live();
+    for (int b = num_blocks - 1; b >= 0; b--) {
+      IC_Block & block = blocks[b];
+      if (block.region < 0) continue;
+      std::set<int> live;
+      for (int s : block.succ) live.insert(blocks[s].live_in.begin(), blocks[s].live_in.end());
+      block.live_out = live;
+      for (int i = block.last; i >= block.first; i--) step_back(ic_array[i], block.region, live);
+      if (live != block.live_in) { block.live_in = live; changed = true; }
+    }
+  }
+
+  // Record what is live after each individual entry.
+  for (IC_Block & block : blocks) {
+    std::set<int> live = block.live_out;
+    for (int i = block.last; i >= block.first; i--) {
+      ic_array[i].live_after = live;
+      if (block.region >= 0) step_back(ic_array[i], block.region, live);
+    }
+  }
+}
+
+
+// An array literal (including a string) is built once, in the pool at the start of
+// the program, and each use copies it.  When nothing the pooled array could ever
+// end up in is changed in place (by element or by resizing), the uses just share
+// the pooled array instead.  Variables that might be sharing it are noted so their
+// arrays are never freed.
+void IC_Array::ShareLiterals()
+{
+  // Which arrays can be passed on to which others, and which are changed in place?
+  std::map<int, std::set<int>> flows_to;
+  std::set<int> changed;
+  for (const IC_Entry & entry : ic_array) {
+    if (entry.args.empty() || !entry.args[0].IsArray()) continue;
+    if ((entry.inst == "val_copy" || entry.inst == "ar_copy") && entry.args[1].IsArray()) {
+      flows_to[entry.args[0].var_id].insert(entry.args[1].var_id);
+    }
+    if (entry.inst == "ar_set_idx" || entry.inst == "ar_set_siz") changed.insert(entry.args[0].var_id);
+  }
+
+  for (auto & literal : literals) {
+    std::set<int> reached;
+    std::vector<int> pending(1, literal.first);
+    while (pending.size()) {
+      const int var_id = pending.back();
+      pending.pop_back();
+      if (!reached.insert(var_id).second) continue;
+      for (int next : flows_to[var_id]) pending.push_back(next);
+    }
+
+    // The pool itself is only ever set up once.
+    bool shareable = true;
+    for (int var_id : reached) {
+      if (var_id != literal.first && changed.count(var_id)) shareable = false;
+    }
+    if (!shareable) continue;
+    literal_arrays.insert(reached.begin(), reached.end());
+    for (IC_Entry & entry : ic_array) {
+      if (entry.inst != "ar_copy" || !entry.args[0].IsArray() || entry.args[0].var_id != literal.first) continue;
+      entry.inst = "val_copy";
+      entry.comment = "Share string literal from the pool.";
+    }
+  }
+}
+
+// Turn small arrays that are only ever given one constant size and indexed with
+// constants into a separate scalar variable per element, so the elements can be
+// kept in registers and propagated like any other variable.  Resizing such an array
+// to the same size again doesn't change its elements, so those resizes just record
+// the size in one more scalar (which stays zero until the array is first resized).
+void IC_Array::ScalarizeArrays()
+{
+  const int max_size = 16;
+
+  // Collect each array's size and make sure every use works on a constant element.
+  std::map<int, int> sizes;       // Array var_id -> its one size (-1 if unsuitable)
+  int next_id = 0;
+  auto reject = [&sizes](const IC_Argument & arg) { if (arg.IsArray()) sizes[arg.var_id] = -1; };
+  auto const_int = [](const IC_Argument & arg, int & out) {
+    double value;
+    if (!ConstValue(arg, value) || value != (int) value) return false;
+    out = (int) value;
+    return true;
+  };
+  for (auto & fun : functions) {
+    for (const IC_Argument & param : fun.second.params) reject(param);
+    reject(fun.second.ret);
+  }
+  for (const IC_Entry & entry : ic_array) {
+    next_id = std::max(next_id, VarLimit(entry));
+    if (entry.args.empty() || !entry.args[0].IsArray()) {
+      for (const IC_Argument & arg : entry.args) reject(arg);
+      continue;
+    }
+    const int var_id = entry.args[0].var_id;
+    int value = -1;
+    if (entry.inst == "ar_set_siz") {
+      if (!const_int(entry.args[1], value) || value < 1 || value > max_size) value = -1;
+      if (sizes.count(var_id) && sizes[var_id] != value) value = -1;
+      if (sizes.count(var_id) == 0 || sizes[var_id] != -1) sizes[var_id] = value;
+    } else if (entry.inst == "ar_get_idx" || entry.inst == "ar_set_idx") {
+      if (!const_int(entry.args[1], value) || value < 0) reject(entry.args[0]);
+      if (entry.args.size() > 2) reject(entry.args[2]);
+    } else if (entry.inst != "ar_get_siz" && entry.inst != "ar_push" && entry.inst != "ar_pop") {
+      for (const IC_Argument & arg : entry.args) reject(arg);
+    }
+  }
+  for (const IC_Entry & entry : ic_array) {
+    int index;
+    if ((entry.inst == "ar_get_idx" || entry.inst == "ar_set_idx") && entry.args[0].IsArray()
+        && sizes.count(entry.args[0].var_id) && const_int(entry.args[1], index)
+        && index >= sizes[entry.args[0].var_id]) {
+      reject(entry.args[0]);
+    }
+  }
+
+  // Give each element of the chosen arrays its own variable.
+  std::map<int, std::vector<IC_Argument>> elements;
+  std::map<int, IC_Argument> size_vars;
+  for (auto & array : sizes) {
+    for (int i = 0; i <= array.second; i++) {
+      IC_Argument var(std::string("s") + std::to_string(next_id), next_id, IC_Argument::ARG_SCALAR);
+      next_id++;
+      if (i < array.second) elements[array.first].push_back(var);
+      else size_vars[array.first] = var;
+    }
+  }
+  if (elements.empty()) return;
+
+  auto make_copy = [](IC_Entry & entry, const IC_Argument & from, const IC_Argument & to) {
+    IC_Entry copy("val_copy", entry.label, entry.comment);
+    copy.args.push_back(from);
+    copy.args.push_back(to);
+    entry = copy;
+  };
+  for (IC_Entry & entry : ic_array) {
+    if (entry.args.empty() || elements.count(entry.args[0].var_id) == 0 || !entry.args[0].IsArray()) continue;
+    const std::vector<IC_Argument> & vars = elements[entry.args[0].var_id];
+    int index = 0;
+    if (entry.inst == "ar_get_idx") {
+      const_int(entry.args[1], index);
+      make_copy(entry, vars[index], entry.args[2]);
+    } else if (entry.inst == "ar_set_idx") {
+      const_int(entry.args[1], index);
+      make_copy(entry, entry.args[2], vars[index]);
+    } else if (entry.inst == "ar_set_siz") {
+      make_copy(entry, IC_Argument(std::to_string(vars.size()), -1, IC_Argument::ARG_CONST), size_vars[entry.args[0].var_id]);
+    } else if (entry.inst == "ar_get_siz") {
+      make_copy(entry, size_vars[entry.args[0].var_id], entry.args[1]);
+    } else {
+      entry.Clear();   // Saving the array around a call does nothing now.
+    }
+  }
+}
+
+
+// Forward values stored into array elements (or already loaded from them) to later
+// loads of the same element, and drop stores that are overwritten before anything
+// could read them.  An index is tracked as a variable plus a constant offset, so
+// "x[i+1] = v; ... x[i+1]" matches even when i+1 is worked out twice.  Distinct
+// array variables never share elements, so only writes to the same array, or a
+// change to a variable the index or value depends on, can spoil what is known.
+void IC_Array::ForwardArrayValues(const std::vector<IC_Block> & blocks)
+{
+  typedef std::pair<int, double> Affine;            // Base var_id (-1 for none) + offset
+  typedef std::pair<int, Affine> Element;           // Array var_id, index
+  struct Facts {
+    std::map<int, Affine> forms;                    // Scalar var_id -> value as base + offset
+    std::map<Element, IC_Argument> values;          // Element -> argument holding its value
+  };
+  auto same_arg = [](const IC_Argument & a, const IC_Argument & b) {
+    return a.var_id == b.var_id && a.str_value == b.str_value;
+  };
+  auto same_facts = [&same_arg](const Facts & a, const Facts & b) {
+    if (a.forms != b.forms || a.values.size() != b.values.size()) return false;
+    for (auto it = a.values.begin(), jt = b.values.begin(); it != a.values.end(); ++it, ++jt) {
+      if (it->first != jt->first || !same_arg(it->second, jt->second)) return false;
+    }
+    return true;
+  };
+  const int num_blocks = (int) blocks.size();
+
+  auto form_of = [](const IC_Argument & arg, const Facts & facts, Affine & out) {
+    if (arg.IsConst()) { out = Affine(-1, 0.0); return ConstValue(arg, out.second); }
+    if (!arg.IsScalar()) return false;
+    auto it = facts.forms.find(arg.var_id);
+    out = (it == facts.forms.end()) ? Affine(arg.var_id, 0.0) : it->second;
+    return true;
+  };
+  // Could two indices (into the same array) pick out the same element?
+  auto may_alias = [](const Affine & a, const Affine & b) {
+    return a.first != b.first || a.second == b.second;
+  };
+  // A variable changed, so forget anything that depended on its old value.
+  auto kill = [](int var_id, Facts & facts) {
+    facts.forms.erase(var_id);
+    for (auto it = facts.forms.begin(); it != facts.forms.end(); ) {
+      if (it->second.first == var_id) it = facts.forms.erase(it);
+      else ++it;
+    }
+    for (auto it = facts.values.begin(); it != facts.values.end(); ) {
+      if (it->first.first == var_id || it->first.second.first == var_id ||
+          (!it->second.IsConst() && it->second.var_id == var_id)) it = facts.values.erase(it);
+      else ++it;
+    }
+  };
+
+  // Track one entry; if "rewrite" is set, loads with a known value become copies and
+  // stores that are overwritten unread are removed.  "pending" holds the stores in
+  // this block that haven't been read yet.
+  auto step = [&](IC_Entry & entry, Facts & facts, std::map<Element, int> & pending, int pos, bool rewrite) {
+    if (entry.is_call) { facts = Facts(); pending.clear(); return; }
+    const bool is_get = entry.inst == "ar_get_idx", is_set = entry.inst == "ar_set_idx";
+    Affine index;
+    if ((is_get || is_set) && entry.args[0].IsArray() && form_of(entry.args[1], facts, index)) {
+      const Element element(entry.args[0].var_id, index);
+      if (is_set) {
+        auto prev = pending.find(element);
+        if (rewrite && prev != pending.end()) ic_array[prev->second].Clear();
+        for (auto it = facts.values.begin(); it != facts.values.end(); ) {
+          if (it->first.first == element.first && may_alias(it->first.second, index)) it = facts.values.erase(it);
+          else ++it;
+        }
+        pending[element] = pos;
+        facts.values[element] = entry.args[2];
+        return;
+      }
+      for (auto it = pending.begin(); it != pending.end(); ) {
+        if (it->first.first == element.first && may_alias(it->first.second, index)) it = pending.erase(it);
+        else ++it;
+      }
+      const IC_Argument out = entry.args[2];
+      auto known = facts.values.find(element);
+      IC_Argument value = out;
+      if (known != facts.values.end()) {
+        value = known->second;
+        if (rewrite) {
+          IC_Entry copy("val_copy", entry.label, entry.comment);
+          copy.args.push_back(value);
+          copy.args.push_back(out);
+          entry = copy;
+        }
+      }
+      kill(out.var_id, facts);
+      if (index.first != out.var_id) facts.values[element] = value;
+      return;
+    }
+
+    // Anything else that reads an array (besides its size) might read any element.
+    if (entry.inst != "ar_get_siz") {
+      for (int n = 0; n < (int) entry.args.size(); n++) {
+        if (!entry.args[n].IsArray() || !entry.IsLoad(n)) continue;
+        for (auto it = pending.begin(); it != pending.end(); ) {
+          if (it->first.first == entry.args[n].var_id) it = pending.erase(it);
+          else ++it;
+        }
+      }
+    }
+
+    // Note simple sums so indices worked out separately can still be matched.
+    Affine sum;
+    bool has_sum = false;
+    if (entry.args.size() >= 2 && entry.args.back().IsScalar()) {
+      Affine in1, in2;
+      if (entry.inst == "val_copy") has_sum = form_of(entry.args[0], facts, sum);
+      else if ((entry.inst == "add" || entry.inst == "sub") && form_of(entry.args[0], facts, in1) &&
+               form_of(entry.args[1], facts, in2) && in2.first == -1) {
+        sum = Affine(in1.first, entry.inst == "add" ? in1.second + in2.second : in1.second - in2.second);
+        has_sum = true;
+      } else if (entry.inst == "add" && form_of(entry.args[0], facts, in1) &&
+                 form_of(entry.args[1], facts, in2) && in1.first == -1) {
+        sum = Affine(in2.first, in1.second + in2.second);
+        has_sum = true;
+      }
+    }
+    std::vector<int> uses, defs;
+    EntryUseDef(entry, uses, defs);
+    for (int v : defs) {
+      kill(v, facts);
+      for (auto it = pending.begin(); it != pending.end(); ) {
+        if (it->first.first == v || it->first.second.first == v) it = pending.erase(it);
+        else ++it;
+      }
+    }
+    const int to_id = entry.args.empty() ? -1 : entry.args.back().var_id;
+    if (has_sum && sum.first != to_id && sum != Affine(to_id, 0.0)) facts.forms[to_id] = sum;
+  };
+
+  // Nothing is known on entry to a function; elsewhere only what holds on every path in.
+  std::set<std::string> call_targets;
+  for (const IC_Entry & entry : ic_array) if (entry.is_call) call_targets.insert(entry.args[0].str_value);
+  std::vector<Facts> facts_in(num_blocks);
+  std::vector<bool> visited(num_blocks, false);
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int b = 0; b < num_blocks; b++) {
+      const IC_Block & block = blocks[b];
+      if (block.region < 0) continue;
+      Facts known;
+      bool first = true;
+      for (int p : block.pred) {
+        if (!visited[p]) continue;
+        Facts out = facts_in[p];
+        std::map<Element, int> pending;
+        for (int i = blocks[p].first; i <= blocks[p].last; i++) step(ic_array[i], out, pending, i, false);
+
+        // Carrying a variable into another block would keep it alive (and in a register)
+        // for longer than the load it replaces would cost, so only constants go further.
+        for (auto it = out.values.begin(); it != out.values.end(); ) {
+          if (!it->second.IsConst()) it = out.values.erase(it);
+          else ++it;
+        }
+        if (first) { known = out; first = false; continue; }
+        for (auto it = known.forms.begin(); it != known.forms.end(); ) {
+          auto match = out.forms.find(it->first);
+          if (match == out.forms.end() || match->second != it->second) it = known.forms.erase(it);
+          else ++it;
+        }
+        for (auto it = known.values.begin(); it != known.values.end(); ) {
+          auto match = out.values.find(it->first);
+          if (match == out.values.end() || !same_arg(match->second, it->second)) it = known.values.erase(it);
+          else ++it;
+        }
+      }
+      if (b == 0 || block.pred.size() == 0 || call_targets.count(ic_array[block.first].label)) known = Facts();
+      else if (first) continue;
+      if (!visited[b] || !same_facts(known, facts_in[b])) {
+        visited[b] = true;
+        facts_in[b] = known;
+        changed = true;
+      }
+    }
+  }
+
+  for (int b = 0; b < num_blocks; b++) {
+    if (!visited[b] || blocks[b].region < 0) continue;
+    Facts known = facts_in[b];
+    std::map<Element, int> pending;
+    for (int i = blocks[b].first; i <= blocks[b].last; i++) step(ic_array[i], known, pending, i, true);
+  }
+}
+
+// Arrays are values, so ar_copy normally duplicates every element.  Skip that work
+// when no one can tell the difference: if the source is never read again, the
+// destination simply takes over its memory; and an argument the function never
+// changes or hands on can share the caller's array for the length of the call.
+// A variable that is moved from is cleared, unless it is a temporary that nothing
+// else ever sets, so it can't go on to resize or free the block it gave away.
+// Functions never free their parameters, so the caller frees an array it hands to a
+// call once the call returns: the parameter it was moved or copied into (which by
+// then holds nothing, if the function moved it on), or its own array if it was only
+// shared and isn't needed afterward.
+// (Needs ComputeLiveness(); BuildCFG() must be run again afterward.)
+void IC_Array::ShareArrays(const std::vector<IC_Block> & blocks)
+{
+  // A function's result is only ever read once, as it is collected after the call,
+  // so the caller can always take it over (even though it looks live at returns).
+  auto returned_by = [this](int pos, int var_id) {
+    int prev = pos - 1;
+    while (prev >= 0 && ic_array[prev].inst == "") prev--;
+    if (prev < 0) return false;
+    const IC_Function * callee = FindCallee(ic_array[prev]);
+    return callee != NULL && callee->ret.var_id == var_id;
+  };
+
+  // Arrays saved on the stack around a call come back later, so they must stay unique.
+  std::set<int> saved;
+  for (const IC_Entry & entry : ic_array) {
+    if (entry.inst == "ar_push" && !entry.args[0].IsConst()) saved.insert(entry.args[0].var_id);
+  }
+
+  // An array handed to more than one parameter of the same call can't be moved into
+  // any of them, or the function could change one and see it through another.
+  auto copies_in_block = [&](const IC_Block & block, int var_id) {
+    int count = 0;
+    for (int i = block.first; i <= block.last; i++) {
+      const IC_Entry & entry = ic_array[i];
+      if (entry.inst == "ar_copy" && !entry.args[0].IsConst() && entry.args[0].var_id == var_id) count++;
+    }
+    return count;
+  };
+
+  // Temporaries are set in just one place and never changed there, so they can't be
+  // used again before they are set anew.  Parameters and results last across calls.
+  std::map<int, int> set_count;
+  for (const IC_Entry & entry : ic_array) {
+    for (int i = 0; i < (int) entry.args.size(); i++) {
+      if (entry.args[i].IsArray() && entry.IsStore(i)) set_count[entry.args[i].var_id]++;
+    }
+    if ((entry.inst == "ar_set_siz" || entry.inst == "ar_set_idx") && entry.args[0].IsArray()) {
+      set_count[entry.args[0].var_id] += 2;
+    }
+  }
+  for (auto & fun : functions) {
+    for (const IC_Argument & param : fun.second.params) set_count[param.var_id] += 2;
+    set_count[fun.second.ret.var_id] += 2;
+  }
+
+  std::set<int> params, results;
+  for (auto & fun : functions) {
+    for (const IC_Argument & param : fun.second.params) params.insert(param.var_id);
+    results.insert(fun.second.ret.var_id);
+  }
+
+  std::set<int> cleared;                   // Positions of moves whose source must be cleared
+  std::map<int, std::set<int>> returns_free; // Call positions -> arrays to free once back
+  for (const IC_Block & block : blocks) {
+    if (block.region < 0) continue;
+    for (int i = block.first; i <= block.last; i++) {
+      IC_Entry & entry = ic_array[i];
+      if (entry.inst != "ar_copy" || entry.args[0].IsConst()) continue;
+      const int src = entry.args[0].var_id;
+      if (saved.count(src)) continue;
+      if (entry.live_after.count(src) && !returned_by(i, src)) continue;
+      if (ic_array[block.last].is_call && copies_in_block(block, src) > 1) continue;
+      entry.inst = "val_copy";
+      entry.comment = "Move array.";
+      if (set_count[src] > 1) cleared.insert(i);
+    }
+  }
+
+  // With the moves in place, see which parameters may be changed or passed along.
+  SummarizeFunctions(blocks);
+  for (const IC_Block & block : blocks) {
+    if (block.region < 0) continue;
+    const IC_Function * callee = FindCallee(ic_array[block.last]);
+    if (callee == NULL || !ic_array[block.last + 1].after_call) continue;
+    for (int i = block.first; i < block.last; i++) {
+      IC_Entry & entry = ic_array[i];
+      if ((entry.inst != "ar_copy" && entry.inst != "val_copy") || !entry.args[0].IsArray()) continue;
+      const int src = entry.args[0].var_id;
+      const int dest = entry.args[1].var_id;
+      for (int k = 0; k < (int) callee->params.size(); k++) {
+        if (callee->params[k].var_id != dest) continue;
+        if (literal_arrays.count(src) || literal_arrays.count(dest)) break;
+        // The function must not be able to reach the caller's array some other way.
+        if (entry.inst == "val_copy" || callee->param_mutated[k] || callee->param_escapes[k]
+            || callee->ref.count(src) || callee->mod.count(src) || callee->array_mod.count(src)) {
+          returns_free[block.last].insert(dest);
+          break;
+        }
+        entry.inst = "val_copy";
+        entry.comment = "Share array with call.";
+        if (!ic_array[block.last + 1].live_after.count(src) && !params.count(src)
+            && !results.count(src) && !saved.count(src)) {
+          returns_free[block.last].insert(src);
+        }
+        break;
+      }
+    }
+  }
+
+  if (cleared.empty() && returns_free.empty()) return;
+  std::vector<IC_Entry> new_array;
+  new_array.reserve(ic_array.size() + cleared.size() + returns_free.size());
+  for (int i = 0; i < (int) ic_array.size(); i++) {
+    new_array.push_back(ic_array[i]);
+    if (cleared.count(i)) {
+      IC_Entry clear("val_copy", "", "Moved-from array no longer owns its block.");
+      clear.args.push_back(IC_Argument("0", -1, IC_Argument::ARG_CONST));
+      clear.args.push_back(ic_array[i].args[0]);
+      new_array.push_back(clear);
+    }
+    if (i > 0 && returns_free.count(i - 1)) {   // Just after the return label
+      for (int var_id : returns_free[i - 1]) {
+        IC_Entry entry("ar_free", "", "Array handed to the call is no longer needed.");
+        entry.args.push_back(IC_Argument(std::string("a") + std::to_string(var_id), var_id, IC_Argument::ARG_ARRAY));
+        new_array.push_back(entry);
+      }
+    }
+  }
+  ic_array.swap(new_array);
+}
+
+
+// Give arrays back to the allocator once the variables holding them die.  Only
+// arrays that belong to a single variable qualify: parameters (which may share the
+// caller's array), return values, and arrays that other activations of a recursive
+// function may be using are never freed, nor is an array handed over by a move or
+// to a call.  (Needs ComputeLiveness().)
+void IC_Array::FreeDeadArrays(const std::vector<IC_Block> & blocks)
+{
+  // An array saved around a recursive call might be sharing its block with the other
+  // activations of the function, unless each activation always makes its own (that
+  // is, the array is never read by a function before being set there).
+  std::set<int> shared;
+  for (auto & fun : functions) shared.insert(fun.second.ref.begin(), fun.second.ref.end());
+  std::set<int> unowned;
+  for (const IC_Entry & entry : ic_array) {
+    if (entry.inst != "ar_push" || entry.args[0].IsConst()) continue;
+    if (shared.count(entry.args[0].var_id)) unowned.insert(entry.args[0].var_id);
+  }
+  // Only a copy saved on the stack can still refer to an array's block when it is resized.
+  for (IC_Entry & entry : ic_array) {
+    if (entry.inst == "ar_set_siz") entry.array_owned = !unowned.count(entry.args[0].var_id);
+  }
+  for (auto & fun : functions) {
+    for (const IC_Argument & param : fun.second.params) unowned.insert(param.var_id);
+    unowned.insert(fun.second.ret.var_id);
+  }
+  unowned.insert(literal_arrays.begin(), literal_arrays.end());
+
+  // While an array is saved on the stack around a call, its block will come back when
+  // it is restored, so it isn't finished with until after that.
+  std::map<int, std::set<int>> saved_at;   // Entry position -> arrays saved there
+  for (int i = 0; i < (int) ic_array.size(); i++) {
+    const IC_Entry & entry = ic_array[i];
+    if (entry.inst != "ar_push" || entry.args[0].IsConst()) continue;
+    const int var_id = entry.args[0].var_id;
+    if (unowned.count(var_id)) continue;
+    for (int j = i; j < (int) ic_array.size(); j++) {
+      if (ic_array[j].inst == "ar_pop" && ic_array[j].args[0].var_id == var_id) break;
+      saved_at[j].insert(var_id);
+    }
+  }
+
+  // Which owned arrays does this entry read for the last time?
+  auto dying = [&](int pos) {
+    const IC_Entry & entry = ic_array[pos];
+    std::vector<int> vars;
+    if (entry.inst == "ar_pop" && !entry.live_after.count(entry.args[0].var_id)
+        && !unowned.count(entry.args[0].var_id)) {
+      vars.push_back(entry.args[0].var_id);      // Restored, but not needed any more.
+    }
+    if (entry.IsJump() || entry.inst == "val_copy" || entry.inst == "ar_free") return vars;
+    for (int i = 0; i < (int) entry.args.size(); i++) {
+      const IC_Argument & arg = entry.args[i];
+      if (!arg.IsArray() || !entry.IsLoad(i) || unowned.count(arg.var_id)) continue;
+      if (saved_at.count(pos) && saved_at[pos].count(arg.var_id)) continue;
+      if (entry.live_after.count(arg.var_id)) continue;
+      if (std::find(vars.begin(), vars.end(), arg.var_id) == vars.end()) vars.push_back(arg.var_id);
+    }
+    return vars;
+  };
+  auto make_free = [](int var_id) {
+    IC_Entry entry("ar_free", "", "Array is no longer needed.");
+    entry.args.push_back(IC_Argument(std::string("a") + std::to_string(var_id), var_id, IC_Argument::ARG_ARRAY));
+    return entry;
+  };
+
+  // Arrays that die on the way into a block (such as after the last pass of a loop).
+  // Only arrays the function itself uses count; others are just passing through
+  // calls it makes, and their owners may still look at them.
+  std::map<int, std::vector<int>> block_frees;
+  std::map<int, std::set<int>> arrays;   // Array variables used in each region
+  for (const IC_Block & block : blocks) {
+    for (int i = block.first; i <= block.last; i++) {
+      for (const IC_Argument & arg : ic_array[i].args) {
+        if (arg.IsArray()) arrays[block.region].insert(arg.var_id);
+      }
+    }
+  }
+  for (int b = 0; b < (int) blocks.size(); b++) {
+    const IC_Block & block = blocks[b];
+    if (block.region < 0 || block.pred.size() != 1) continue;
+    const IC_Entry & first = ic_array[block.first];
+    if (first.after_call || (first.label != "" && first.inst != "")) continue;
+    const IC_Block & pred = blocks[block.pred[0]];
+    if (ic_array[pred.last].is_call) continue;
+    for (int v : pred.live_out) {
+      if (arrays[block.region].count(v) && !unowned.count(v) && !block.live_in.count(v)) {
+        block_frees[b].push_back(v);
+      }
+    }
+  }
+
+  std::vector<IC_Entry> new_array;
+  new_array.reserve(ic_array.size());
+  for (int b = 0; b < (int) blocks.size(); b++) {
+    const IC_Block & block = blocks[b];
+    for (int i = block.first; i <= block.last; i++) {
+      const IC_Entry & entry = ic_array[i];
+      const bool at_start = i == block.first && block_frees.count(b);
+      if (at_start && entry.inst != "") {
+        for (int v : block_frees[b]) new_array.push_back(make_free(v));
+      }
+      new_array.push_back(entry);
+      if (at_start && entry.inst == "") {
+        for (int v : block_frees[b]) new_array.push_back(make_free(v));
+      }
+      if (block.region < 0) continue;
+      for (int v : dying(i)) new_array.push_back(make_free(v));
+    }
+  }
+  ic_array.swap(new_array);
+}
+
+
+// Work out what is known about each array's size (and whether it has been set up
+// at all) wherever it is resized or read.  Values are tracked as a range of offsets
+// from a variable (or from zero), so "a.resize(a.size() - 1)" is known to shrink and
+// a range from either side of an "if" still bounds the size afterward.  Resizes pick
+// a cheaper expansion from what is known, and size reads that would just give back a
+// known constant (or a variable still in use) become copies, as do remainders ("mod")
+// of whole numbers already known to be smaller (in size) than the divisor.
+void IC_Array::AnalyzeArraySizes(const std::vector<IC_Block> & blocks)
+{
+  struct Bound {
+    int base;       // Variable the value is measured from (-1 for none)
+    double lo, hi;  // Smallest and largest offset from it
+    bool whole;     // Is the value known to be a whole number?
+    bool operator==(const Bound & in) const {
+      return base == in.base && lo == in.lo && hi == in.hi && whole == in.whole;
+    }
+    bool operator!=(const Bound & in) const { return !(*this == in); }
+  };
+  struct Facts {
+    std::map<int, Bound> values;   // Scalar var_id -> its value
+    std::map<int, Bound> sizes;    // Array var_id -> its size (only meaningful if set up)
+    std::map<int, bool> init;      // Array var_id -> has it been set up?
+    bool operator==(const Facts & in) const { return values == in.values && sizes == in.sizes && init == in.init; }
+  };
+  const int num_blocks = (int) blocks.size();
+
+  auto bound_of = [](const IC_Argument & arg, const Facts & facts, Bound & out) {
+    double value = 0.0;
+    if (ConstValue(arg, value)) { out = Bound{-1, value, value, value == std::floor(value)}; return true; }
+    if (!arg.IsScalar()) return false;
+    auto it = facts.values.find(arg.var_id);
+    out = (it == facts.values.end()) ? Bound{arg.var_id, 0.0, 0.0, false} : it->second;
+    return true;
+  };
+  auto kill = [](int var_id, Facts & facts) {
+    facts.values.erase(var_id);
+    facts.sizes.erase(var_id);
+    facts.init.erase(var_id);
+    for (auto * table : {&facts.values, &facts.sizes}) {
+      for (auto it = table->begin(); it != table->end(); ) {
+        if (it->second.base == var_id) it = table->erase(it);
+        else ++it;
+      }
+    }
+  };
+
+  SummarizeFunctions(blocks);
+  auto step = [&](IC_Entry & entry, Facts & facts, bool rewrite) {
+    if (entry.is_call) {
+      const IC_Function * callee = FindCallee(entry);
+      if (callee == NULL) facts = Facts();
+      else for (int v : callee->mod) kill(v, facts);
+      return;
+    }
+    const int to_id = entry.args.empty() ? -1 : entry.args.back().var_id;
+    Bound result;
+    bool has_result = false;
+    if (entry.inst == "ar_set_siz" && entry.args[0].IsArray()) {
+      const int array_id = entry.args[0].var_id;
+      Bound size;
+      const bool has_size = bound_of(entry.args[1], facts, size);
+      auto init = facts.init.find(array_id);
+      auto old_size = facts.sizes.find(array_id);
+      if (rewrite) {
+        entry.resize_kind = IC_Entry::RESIZE_ANY;
+        if (init != facts.init.end()) entry.resize_kind = init->second ? IC_Entry::RESIZE_INIT : IC_Entry::RESIZE_EMPTY;
+        if (entry.resize_kind == IC_Entry::RESIZE_INIT && has_size && old_size != facts.sizes.end() &&
+            old_size->second.base == size.base && size.hi <= old_size->second.lo) {
+          entry.resize_kind = IC_Entry::RESIZE_SHRINK;
+        }
+      }
+      kill(array_id, facts);
+      facts.init[array_id] = true;
+      if (has_size) facts.sizes[array_id] = size;
+      return;
+    }
+    if (entry.inst == "ar_get_siz" && entry.args[0].IsArray()) {
+      const int array_id = entry.args[0].var_id;
+      auto init = facts.init.find(array_id);
+      auto size = facts.sizes.find(array_id);
+      const bool empty = init != facts.init.end() && !init->second;
+      if (empty) facts.sizes[array_id] = Bound{-1, 0.0, 0.0, true};
+      size = facts.sizes.find(array_id);
+      const bool known = init != facts.init.end() && size != facts.sizes.end();
+      if (rewrite) {
+        entry.resize_kind = IC_Entry::RESIZE_ANY;
+        if (init != facts.init.end()) entry.resize_kind = init->second ? IC_Entry::RESIZE_INIT : IC_Entry::RESIZE_EMPTY;
+      }
+      if (known && rewrite && size->second.lo == size->second.hi) {
+        const Bound & value = size->second;
+        IC_Entry copy("val_copy", entry.label, entry.comment);
+        if (value.base == -1) {
+          std::stringstream ss;
+          ss << value.lo;
+          copy.args.push_back(IC_Argument(ss.str(), -1, IC_Argument::ARG_CONST));
+        } else if (value.lo == 0.0 && entry.live_after.count(value.base)) {
+          copy.args.push_back(IC_Argument(std::string("s") + std::to_string(value.base), value.base, IC_Argument::ARG_SCALAR));
+        }
+        if (copy.args.size()) {
+          copy.args.push_back(entry.args[1]);
+          copy.live_after = entry.live_after;
+          entry = copy;
+        }
+      }
+      const Bound value = known ? size->second : Bound{to_id, 0.0, 0.0, false};
+      kill(to_id, facts);
+      if (value.base != to_id) facts.values[to_id] = value;
+      else facts.sizes[array_id] = value;
+      return;
+    }
+    if (entry.inst == "ar_free") { kill(entry.args[0].var_id, facts); return; }
+
+    // Moving or copying an array carries over what is known about it.
+    Facts moved;
+    if ((entry.inst == "val_copy" || entry.inst == "ar_copy") && entry.args.size() == 2 && entry.args[1].IsArray()) {
+      const int from_id = entry.args[0].var_id;
+      if (facts.init.count(from_id)) moved.init[to_id] = facts.init[from_id];
+      if (facts.sizes.count(from_id)) moved.sizes[to_id] = facts.sizes[from_id];
+    }
+
+    // Simple sums keep their relation to the values they were worked out from.
+    Bound in1, in2;
+    double divisor = 0.0;
+    if (entry.args.size() >= 2 && entry.args.back().IsScalar()) {
+      if (entry.inst == "val_copy") has_result = bound_of(entry.args[0], facts, result);
+      else if ((entry.inst == "add" || entry.inst == "sub") && bound_of(entry.args[0], facts, in1) &&
+               bound_of(entry.args[1], facts, in2) && (in1.base == -1 || in2.base == -1)) {
+        if (entry.inst == "add") {
+          if (in1.base == -1) std::swap(in1, in2);
+          result = Bound{in1.base, in1.lo + in2.lo, in1.hi + in2.hi, in1.whole && in2.whole};
+          has_result = true;
+        } else if (in2.base == -1) {
+          result = Bound{in1.base, in1.lo - in2.hi, in1.hi - in2.lo, in1.whole && in2.whole};
+          has_result = true;
+        }
+      }
+      // A remainder from a constant lies strictly between its negative and itself; if
+      // the value is a whole number already in range, the remainder is just the value.
+      else if (entry.inst == "mod" && ConstValue(entry.args[1], divisor) && std::fabs(divisor) >= 1.0 &&
+               std::fabs(divisor) <= 2147483647.0) {
+        const double limit = std::floor(std::fabs(divisor)) - 1.0;
+        const bool known = bound_of(entry.args[0], facts, in1) && in1.base == -1;
+        if (known && in1.whole && in1.lo >= -limit && in1.hi <= limit) {
+          if (rewrite) {
+            IC_Entry copy("val_copy", entry.label, entry.comment);
+            copy.args.push_back(entry.args[0]);
+            copy.args.push_back(entry.args[2]);
+            copy.live_after = entry.live_after;
+            entry = copy;
+          }
+          result = in1;
+        } else {
+          result = Bound{-1, -limit, limit, true};
+          if (known && in1.lo >= 0.0) result.lo = 0.0;
+          if (known && in1.hi <= 0.0) result.hi = 0.0;
+        }
+        has_result = true;
+      }
+    }
+    std::vector<int> uses, defs;
+    EntryUseDef(entry, uses, defs);
+    for (int v : defs) kill(v, facts);
+    if (has_result && result.base != to_id && result != Bound{to_id, 0.0, 0.0, false}) facts.values[to_id] = result;
+    for (auto & fact : moved.init) facts.init[fact.first] = fact.second;
+    for (auto & fact : moved.sizes) if (fact.second.base != to_id) facts.sizes[fact.first] = fact.second;
+  };
+
+  // Every array starts out uninitialized when the program begins; nothing is known on
+  // entry to a function.  Elsewhere, keep the widest range seen along any path in.
+  std::set<int> array_ids;
+  for (const IC_Entry & entry : ic_array) {
+    for (const IC_Argument & arg : entry.args) if (arg.IsArray()) array_ids.insert(arg.var_id);
+  }
+  std::set<std::string> call_targets;
+  for (const IC_Entry & entry : ic_array) if (entry.is_call) call_targets.insert(entry.args[0].str_value);
+  auto merge = [](std::map<int, Bound> & known, const std::map<int, Bound> & out) {
+    for (auto it = known.begin(); it != known.end(); ) {
+      auto match = out.find(it->first);
+      if (match == out.end() || match->second.base != it->second.base) { it = known.erase(it); continue; }
+      it->second.lo = std::min(it->second.lo, match->second.lo);
+      it->second.hi = std::max(it->second.hi, match->second.hi);
+      it->second.whole = it->second.whole && match->second.whole;
+      ++it;
+    }
+  };
+  std::vector<Facts> facts_in(num_blocks);
+  std::vector<bool> visited(num_blocks, false);
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int b = 0; b < num_blocks; b++) {
+      const IC_Block & block = blocks[b];
+      if (block.region < 0) continue;
+      Facts known;
+      bool first = true;
+      if (b == 0) {   // The program start is one more way into the first block.
+        for (int v : array_ids) known.init[v] = false;
+        first = false;
+      }
+      for (int p : block.pred) {
+        if (!visited[p]) continue;
+        Facts out = facts_in[p];
+        for (int i = blocks[p].first; i <= blocks[p].last; i++) step(ic_array[i], out, false);
+        if (first) { known = out; first = false; continue; }
+        merge(known.values, out.values);
+        merge(known.sizes, out.sizes);
+        for (auto it = known.init.begin(); it != known.init.end(); ) {
+          auto match = out.init.find(it->first);
+          if (match == out.init.end() || match->second != it->second) it = known.init.erase(it);
+          else ++it;
+        }
+      }
+      if (b == 0) ;
+      else if (block.pred.size() == 0 || call_targets.count(ic_array[block.first].label)) known = Facts();
+      else if (first) continue;
+
+      // A range that keeps growing around a loop is dropped rather than followed.
+      if (visited[b]) {
+        for (auto & table : {std::make_pair(&known.values, &facts_in[b].values), std::make_pair(&known.sizes, &facts_in[b].sizes)}) {
+          for (auto it = table.first->begin(); it != table.first->end(); ) {
+            auto old = table.second->find(it->first);
+            if (old == table.second->end() || old->second.base != it->second.base ||
+                it->second.lo < old->second.lo || it->second.hi > old->second.hi) it = table.first->erase(it);
+            else ++it;
+          }
+        }
+      }
+      if (!visited[b] || !(known == facts_in[b])) {
+        visited[b] = true;
+        facts_in[b] = known;
+        changed = true;
+      }
+    }
+  }
+
+  for (int b = 0; b < num_blocks; b++) {
+    if (!visited[b] || blocks[b].region < 0) continue;
+    Facts known = facts_in[b];
+    for (int i = blocks[b].first; i <= blocks[b].last; i++) step(ic_array[i], known, true);
+  }
+}
+
+// Replace variables with the constants they are known to hold, so the constants
+// can be used directly instead of keeping the variables in registers.
+void IC_Array::PropagateConstants(std::vector<IC_Block> & blocks)
+{
+  typedef std::map<int, std::string> ConstMap;
+  const int num_blocks = (int) blocks.size();
+
+  // The constant an argument holds, if known.
+  auto const_of = [](const IC_Argument & arg, const ConstMap & known, std::string & out) {
+    if (arg.IsConst()) { out = arg.str_value; return true; }
+    auto it = known.find(arg.var_id);
+    if (!arg.IsScalar() || it == known.end()) return false;
+    out = it->second;
+    return true;
+  };
+
+  SummarizeFunctions(blocks);
+  auto step = [this, &const_of](const IC_Entry & entry, ConstMap & known) {
+    if (entry.is_call) {
+      // Only what the function might change is lost.
+      const IC_Function * callee = FindCallee(entry);
+      if (callee == NULL) known.clear();
+      else for (int v : callee->mod) known.erase(v);
+      return;
+    }
+    if (entry.inst == "val_copy" && entry.args.size() == 2 && entry.args[1].IsScalar()) {
+      const IC_Argument & from = entry.args[0];
+      const int to_id = entry.args[1].var_id;
+      if (from.IsConst()) { known[to_id] = from.str_value; return; }
+      auto it = known.find(from.var_id);
+      if (it != known.end()) { known[to_id] = it->second; return; }
+    }
+    std::string in1, in2, result;
+    if (entry.args.size() == 3 && entry.args[2].IsScalar() && const_of(entry.args[0], known, in1) &&
+        const_of(entry.args[1], known, in2) && FoldMath(entry.inst, in1, in2, result)) {
+      known[entry.args[2].var_id] = result;
+      return;
+    }
+    std::vector<int> uses, defs;
+    EntryUseDef(entry, uses, defs);
+    for (int v : defs) known.erase(v);
+  };
+
+  // Nothing is known at the start of the program or on entry to a function.
+  std::set<std::string> call_targets;
+  for (const IC_Entry & entry : ic_array) if (entry.is_call) call_targets.insert(entry.args[0].str_value);
+  std::vector<bool> region_start(num_blocks, false);
+  for (int b = 0; b < num_blocks; b++) {
+    region_start[b] = (b == 0) || call_targets.count(ic_array[blocks[b].first].label);
+  }
+
+  // Iterate until the constants known on entry to each block settle down.
+  std::vector<ConstMap> const_in(num_blocks);
+  std::vector<bool> visited(num_blocks, false);
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int b = 0; b < num_blocks; b++) {
+      const IC_Block & block = blocks[b];
+      if (block.region < 0) continue;
+
+      // Keep only constants that agree along every incoming path seen so far.
+      ConstMap known;
+      bool first = true;
+      for (int p : block.pred) {
+        if (!visited[p]) continue;
+        ConstMap out = const_in[p];
+        for (int i = blocks[p].first; i <= blocks[p].last; i++) step(ic_array[i], out);
+        if (first) { known = out; first = false; continue; }
+        for (auto it = known.begin(); it != known.end(); ) {
+          auto match = out.find(it->first);
+          if (match == out.end() || match->second != it->second) it = known.erase(it);
+          else ++it;
+        }
+      }
+      if (region_start[b] || block.pred.size() == 0) known.clear();
+      else if (first) continue;                      // No paths in have been seen yet.
+
+      if (!visited[b] || known != const_in[b]) {
+        visited[b] = true;
+        const_in[b] = known;
+        changed = true;
+      }
+    }
+  }
+
+  // Now substitute the constants into each instruction that reads them.
+  for (int b = 0; b < num_blocks; b++) {
+    IC_Block & block = blocks[b];
+    block.const_in = const_in[b];
+    if (!visited[b]) continue;
+    ConstMap known = const_in[b];
+    for (int i = block.first; i <= block.last; i++) {
+      IC_Entry & entry = ic_array[i];
+      for (int n = 0; n < (int) entry.args.size(); n++) {
+        IC_Argument & arg = entry.args[n];
+        if (!arg.IsScalar() || !entry.IsLoad(n) || entry.IsStore(n)) continue;
+        auto it = known.find(arg.var_id);
+        if (it != known.end()) arg = IC_Argument(it->second, -1, IC_Argument::ARG_CONST);
+      }
+
+      // Calculations on constants become copies, and tests of constants either always
+      // jump or never do (leaving unreachable code for RemoveDeadBlocks()).
+      std::string result;
+      if (entry.args.size() == 3 && entry.args[2].IsScalar() && entry.args[0].IsConst() &&
+          entry.args[1].IsConst() && FoldMath(entry.inst, entry.args[0].str_value, entry.args[1].str_value, result)) {
+        IC_Entry copy("val_copy", entry.label, entry.comment);
+        copy.args.push_back(IC_Argument(result, -1, IC_Argument::ARG_CONST));
+        copy.args.push_back(entry.args[2]);
+        entry = copy;
+      }
+      // Reaching a fixed-size array element at a known address is just a copy.
+      int first, count;
+      double addr = 0.0;
+      const int addr_arg = (entry.inst == "load") ? 0 : 1;
+      if (StaticBlock(entry, first, count) && ConstValue(entry.args[addr_arg], addr) &&
+          addr >= first && addr < first + count && addr == (int) addr) {
+        const IC_Argument cell("s" + std::to_string((int) addr), (int) addr, IC_Argument::ARG_SCALAR);
+        IC_Entry copy("val_copy", entry.label, entry.comment);
+        copy.args.push_back(entry.inst == "load" ? cell : entry.args[0]);
+        copy.args.push_back(entry.inst == "load" ? entry.args[1] : cell);
+        entry = copy;
+      }
+      double test = 0.0;
+      if ((entry.inst == "jump_if_0" || entry.inst == "jump_if_n0") && ConstValue(entry.args[0], test)) {
+        if ((test == 0.0) == (entry.inst == "jump_if_0")) {
+          IC_Entry jump("jump", entry.label, entry.comment);
+          jump.args.push_back(entry.args[1]);
+          entry = jump;
+        } else entry.Clear();
+      }
+      // A jump table with a known index goes to just one of its labels.
+      if (entry.inst == "jump_table" && ConstValue(entry.args[0], test)) {
+        const int target = (test < 0.0) ? 1 : 2 + (int) test;
+        if (target < (int) entry.args.size()) {
+          IC_Entry jump("jump", entry.label, entry.comment);
+          jump.args.push_back(entry.args[target]);
+          entry = jump;
+        }
+      }
+      step(entry, known);
+    }
+  }
+}
+
+
+// Linear-scan allocation of registers to variables that stay live across blocks.
+// Each variable gets at most one interval per region; longer-lived variables that
+// are used heavily in loops win out when there are too few registers to go around.
+void IC_Array::AllocateRegisters(const std::vector<IC_Block> & blocks, int num_regs)
+{
+  struct Interval {
+    int var_id;
+    int start;      // First IC entry covered
+    int end;        // Last IC entry covered
+    bool load;      // Must the value be loaded at the start?
+    double weight;  // Estimated cycles saved by keeping this variable in a register
+    int reg_id;
+    int home_reg;   // Register the value arrives in at the start, if passed in one (else -1)
+  };
+
+  for (IC_Entry & entry : ic_array) { entry.pin_start.clear(); entry.pin_end.clear(); }
+
+  // Fixed-size array elements reached through an address have to stay in memory.
+  std::set<int> in_memory;
+  for (const IC_Entry & entry : ic_array) {
+    int first, count;
+    if (StaticBlock(entry, first, count)) for (int v = first; v < first + count; v++) in_memory.insert(v);
+  }
+
+  // Gather the blocks where each variable is live or used, separately per region.
+  std::map<std::pair<int,int>, std::set<int>> var_blocks;
+  for (int b = 0; b < (int) blocks.size(); b++) {
+    const IC_Block & block = blocks[b];
+    if (block.region < 0) continue;
+    for (int v : block.live_in) var_blocks[std::make_pair(block.region, v)].insert(b);
+    for (int v : block.live_out) var_blocks[std::make_pair(block.region, v)].insert(b);
+    for (int i = block.first; i <= block.last; i++) {
+      std::vector<int> uses, defs;
+      EntryUseDef(ic_array[i], uses, defs);
+      for (int v : uses) var_blocks[std::make_pair(block.region, v)].insert(b);
+      for (int v : defs) var_blocks[std::make_pair(block.region, v)].insert(b);
+    }
+  }
+
+  auto freq = [&](int b) { return std::pow(10.0, std::min(blocks[b].loop_depth, 8)); };
+  const double load_cost = cost_table.TubeCode("load");
+  const double store_cost = cost_table.TubeCode("store");
+
+  std::vector<Interval> intervals;
+  for (auto & vb : var_blocks) {
+    const int region = vb.first.first;
+    const int var_id = vb.first.second;
+    const int first_b = *vb.second.begin();
+    const int last_b = *vb.second.rbegin();
+    if (in_memory.count(var_id)) continue;
+
+    // Intervals must stay inside their own region.
+    bool ok = true;
+    for (int b = first_b; b <= last_b; b++) {
+      if (blocks[b].region != region && blocks[b].region != -1) ok = false;
+    }
+    if (!ok) continue;
+
+    Interval cur{var_id, -1, -1, false, 0.0, -1, -1};
+    const IC_Block & start_block = blocks[first_b];
+    if (start_block.live_in.count(var_id)) {
+      if (start_block.pred.size()) continue;   // Can't place a single load for a loop header.
+      cur.start = start_block.first;
+      cur.load = true;
+      cur.weight -= load_cost * freq(first_b);
+    } else {
+      for (int i = start_block.first; i <= start_block.last && cur.start < 0; i++) {
+        if (RefersTo(ic_array[i], var_id)) cur.start = i;
+      }
+    }
+    const IC_Block & end_block = blocks[last_b];
+    if (end_block.live_out.count(var_id)) cur.end = end_block.last;
+    else {
+      for (int i = end_block.last; i >= end_block.first && cur.end < 0; i--) {
+        if (RefersTo(ic_array[i], var_id)) cur.end = i;
+      }
+    }
+    if (cur.start < 0 || cur.end < cur.start) continue;
+
+    const IC_Entry & start_entry = ic_array[cur.start];
+    if (start_entry.inst == "") {
+      for (int k = 0; k < (int) start_entry.reg_vars.size(); k++) {
+        if (start_entry.reg_vars[k] == var_id) cur.home_reg = k;
+      }
+      if (start_entry.reg_return == var_id) cur.home_reg = 0;
+    }
+
+    // Each block that would otherwise load the variable, or store it on the way
+    // out, saves a memory access.
+    for (int b : vb.second) {
+      const IC_Block & block = blocks[b];
+      if (block.region != region) continue;
+      bool used = false, defined = false;
+      for (int i = block.first; i <= block.last; i++) {
+        std::vector<int> uses, defs;
+        EntryUseDef(ic_array[i], uses, defs);
+        if (std::find(uses.begin(), uses.end(), var_id) != uses.end()) used = true;
+        if (std::find(defs.begin(), defs.end(), var_id) != defs.end()) defined = true;
+      }
+      if (used && block.live_in.count(var_id)) cur.weight += load_cost * freq(b);
+      if (defined && block.live_out.count(var_id)) cur.weight += store_cost * freq(b);
+    }
+
+    // ...but calls and array copies force a store and reload.
+    for (int i = cur.start; i <= cur.end; i++) {
+      if (IsClobber(ic_array[i]) && ic_array[i].live_after.count(var_id)) {
+        cur.weight -= (load_cost + store_cost) * freq(ic_array[i].block - 1);
+      }
+    }
+
+    if (cur.weight > 0.0) intervals.push_back(cur);
+  }
+
+  std::sort(intervals.begin(), intervals.end(),
+            [](const Interval & a, const Interval & b) {
+              if (a.start != b.start) return a.start < b.start;
+              if ((a.home_reg >= 0) != (b.home_reg >= 0)) return a.home_reg >= 0;
+              return a.end < b.end;
+            });
+
+  // Scan through the intervals in order of their starting points.
+  std::vector<int> demand(ic_array.size());
+  for (int i = 0; i < (int) ic_array.size(); i++) demand[i] = RegDemand(ic_array[i]);
+
+  std::vector<Interval *> active;
+  std::vector<Interval *> chosen;
+  for (Interval & cur : intervals) {
+    for (int k = (int) active.size() - 1; k >= 0; k--) {
+      if (active[k]->end < cur.start) active.erase(active.begin() + k);
+    }
+
+    while (true) {
+      // Find the entries where adding this interval would leave too few scratch registers.
+      std::vector<Interval *> blocking;
+      bool fits = (int) active.size() < num_regs;
+      for (int i = cur.start; i <= cur.end; i++) {
+        int count = 1 + demand[i];
+        for (Interval * other : active) if (other->start <= i && other->end >= i) count++;
+        if (count > num_regs) fits = false;
+        if (count > num_regs || (int) active.size() >= num_regs) {
+          for (Interval * other : active) {
+            if (other->start <= i && other->end >= i &&
+                std::find(blocking.begin(), blocking.end(), other) == blocking.end()) {
+              blocking.push_back(other);
+            }
+          }
+        }
+      }
+      if (fits) break;
+
+      // Spill whichever candidate has the least to gain from a register.
+      Interval * victim = &cur;
+      for (Interval * other : blocking) if (other->weight < victim->weight) victim = other;
+      if (victim == &cur) break;
+      active.erase(std::find(active.begin(), active.end(), victim));
+      chosen.erase(std::find(chosen.begin(), chosen.end(), victim));
+      victim->reg_id = -1;
+    }
+    if ((int) active.size() >= num_regs) continue;
+
+    // Check that the interval now fits everywhere it needs to; if not, leave it in memory.
+    bool fits = true;
+    for (int i = cur.start; i <= cur.end && fits; i++) {
+      int count = 1 + demand[i];
+      for (Interval * other : active) if (other->start <= i && other->end >= i) count++;
+      if (count > num_regs) fits = false;
+    }
+    if (!fits) continue;
+
+    std::vector<bool> reg_used(num_regs, false);
+    for (Interval * other : active) reg_used[other->reg_id] = true;
+    if (cur.home_reg >= 0 && !reg_used[cur.home_reg]) cur.reg_id = cur.home_reg;
+    else for (int r = 0; r < num_regs; r++) if (!reg_used[r]) { cur.reg_id = r; break; }
+    active.push_back(&cur);
+    chosen.push_back(&cur);
+  }
+
+  // Let the affected entries know where each dedicated register begins and ends.
+  for (Interval * cur : chosen) {
+    ic_array[cur->start].pin_start.push_back(TC_Pin{cur->var_id, cur->reg_id, cur->load});
+    ic_array[cur->end].pin_end.push_back(cur->var_id);
+  }
+}
+
+
+namespace {
+  // Read a constant argument as an integer, if it is one.
+  bool IntConst(const IC_Argument & arg, int & value)
+  {
+    if (!arg.IsConst() || arg.str_value.size() == 0) return false;
+    const std::string & str = arg.str_value;
+    for (int i = (str[0] == '-') ? 1 : 0; i < (int) str.size(); i++) {
+      if (str[i] < '0' || str[i] > '9') return false;
+    }
+    value = std::stoi(str);
+    return true;
+  }
+
+  struct LoopInfo {
+    int header;      // First block in the loop (where the exit test is)
+    int latch;       // Last block in the loop (which jumps back to the header)
+    int trips;       // How many times does the body run? (-1 if unknown)
+    std::string name;
+  };
+}
+
+
+// Print the estimated cycles for each block, loop, and function in the program.
+// Loops whose trip counts can be worked out are multiplied through; the others are
+// left out of the function totals, which list what each pass through them costs
+// instead.  Branches inside a loop are assumed to be taken every time.
+void IC_Array::PrintCostReport(std::ostream & ofs)
+{
+  std::vector<IC_Block> blocks = BuildCFG();
+  PropagateConstants(blocks);
+  const int num_blocks = (int) blocks.size();
+
+  // Find the loops (one per backward edge) and try to work out their trip counts.
+  std::vector<LoopInfo> loops;
+  for (int b = 0; b < num_blocks; b++) {
+    if (blocks[b].region < 0) continue;
+    for (int h : blocks[b].succ) {
+      if (h > b) continue;
+      LoopInfo loop{h, b, -1, ic_array[blocks[h].first].label};
+      if (loop.name == "") loop.name = "block " + std::to_string(h + 1);
+
+      // The header should end by testing a counter against a constant limit...
+      const IC_Entry & exit_jump = ic_array[blocks[h].last];
+      std::string test_inst;
+      int counter = -1, limit = 0;
+      if (exit_jump.inst == "jump_if_0" || exit_jump.inst == "jump_if_n0") {
+        for (int i = blocks[h].first; i < blocks[h].last; i++) {
+          const IC_Entry & entry = ic_array[i];
+          if (entry.inst.compare(0, 5, "test_") != 0 || entry.args[2].var_id != exit_jump.args[0].var_id) continue;
+          if (entry.args[0].IsScalar() && IntConst(entry.args[1], limit)) {
+            test_inst = entry.inst;
+            counter = entry.args[0].var_id;
+          }
+        }
+      }
+      // Normalize to the condition under which the loop keeps going.
+      if (exit_jump.inst == "jump_if_n0") {
+        static std::map<std::string, std::string> negate = {
+          {"test_less", "test_gte"}, {"test_gte", "test_less"}, {"test_gtr", "test_lte"},
+          {"test_lte", "test_gtr"}, {"test_equ", "test_nequ"}, {"test_nequ", "test_equ"} };
+        test_inst = negate[test_inst];
+      }
+
+      // ...which is changed exactly once in the loop, by a constant step, somewhere
+      // every pass must go through (the header or the block that jumps back)...
+      int step = 0, num_defs = 0;
+      for (int i = blocks[h].first; counter >= 0 && i <= blocks[b].last; i++) {
+        std::vector<int> uses, defs;
+        EntryUseDef(ic_array[i], uses, defs);
+        if (std::find(defs.begin(), defs.end(), counter) == defs.end()) continue;
+        num_defs++;
+        if (i > blocks[h].last && i < blocks[b].first) continue;
+        const IC_Entry * def = &ic_array[i];
+        if (def->inst == "val_copy" && !def->args[0].IsConst()) {   // Step may go through a temporary
+          for (int j = i - 1; j >= blocks[h].first; j--) {
+            if (ic_array[j].args.size() == 3 && ic_array[j].args[2].var_id == def->args[0].var_id) {
+              def = &ic_array[j];
+              break;
+            }
+          }
+        }
+        int amount = 0;
+        if ((def->inst == "add" || def->inst == "sub") && def->args[0].var_id == counter &&
+            !def->args[0].IsConst() && IntConst(def->args[1], amount)) {
+          step = (def->inst == "add") ? amount : -amount;
+        }
+      }
+
+      // ...and starts from a known constant.
+      int start = 0;
+      bool start_known = false;
+      const IC_Block & header = blocks[h];
+      int pre = -1, num_pre = 0;
+      for (int p : header.pred) if (p < h) { pre = p; num_pre++; }
+      if (counter >= 0 && num_pre == 1) {
+        for (int i = blocks[pre].last; i >= blocks[pre].first; i--) {
+          std::vector<int> uses, defs;
+          EntryUseDef(ic_array[i], uses, defs);
+          if (std::find(defs.begin(), defs.end(), counter) == defs.end()) continue;
+          start_known = ic_array[i].inst == "val_copy" && IntConst(ic_array[i].args[0], start);
+          pre = -1;
+          break;
+        }
+        if (pre != -1 && blocks[pre].const_in.count(counter)) {
+          start_known = IntConst(IC_Argument(blocks[pre].const_in[counter], -1, IC_Argument::ARG_CONST), start);
+        }
+      }
+
+      if (num_defs == 1 && step != 0 && start_known) {
+        const int dist = (step > 0) ? limit - start : start - limit;   // Distance in the step direction
+        const int size = std::abs(step);
+        const bool rising = step > 0;
+        if ((test_inst == "test_less" && rising) || (test_inst == "test_gtr" && !rising)) {
+          loop.trips = (dist > 0) ? (dist + size - 1) / size : 0;
+        }
+        if ((test_inst == "test_lte" && rising) || (test_inst == "test_gte" && !rising)) {
+          loop.trips = (dist >= 0) ? dist / size + 1 : 0;
+        }
+        if (test_inst == "test_nequ" && dist >= 0 && dist % size == 0) loop.trips = dist / size;
+      }
+      loops.push_back(loop);
+    }
+  }
+
+  // How many times does each block run (assuming unknown loops run zero times)?
+  std::vector<double> block_cycles(num_blocks, 0.0), block_count(num_blocks, 1.0);
+  std::vector<bool> has_array_copy(num_blocks, false);
+  for (int b = 0; b < num_blocks; b++) {
+    for (int i = blocks[b].first; i <= blocks[b].last; i++) {
+      block_cycles[b] += ic_array[i].cycles;
+      if (cost_table.ICPerElement(ic_array[i].inst)) has_array_copy[b] = true;
+    }
+    for (const LoopInfo & loop : loops) {
+      if (b < loop.header || b > loop.latch) continue;
+      const int trips = std::max(loop.trips, 0);
+      block_count[b] *= (b == loop.header) ? trips + 1 : trips;
+    }
+  }
+
+  // Name each region after the function it holds.
+  std::map<int, std::string> region_names;
+  std::map<std::string, int> label_region;
+  for (int b = 0; b < num_blocks; b++) {
+    const std::string & label = ic_array[blocks[b].first].label;
+    if (blocks[b].region >= 0 && label != "") label_region[label] = blocks[b].region;
+  }
+  for (int b = 0; b < num_blocks; b++) {
+    if (blocks[b].region < 0 || blocks[b].succ.empty()) continue;
+    const IC_Entry & term = ic_array[blocks[b].last];
+    if (!term.is_call || !label_region.count(term.args[0].str_value)) continue;
+    const std::string & label = term.args[0].str_value;
+    region_names[label_region[label]] = label.substr(label.find('_') + 1);
+  }
+  if (num_blocks) region_names[blocks[0].region] = "main";
+
+  // Work out the cost of each function, including the functions it calls.
+  const int setup_cycles = cost_table.TubeCode("val_copy") + cost_table.TubeCode("store");  // Stack & heap setup
+  std::map<int, double> region_total;
+  std::map<int, int> region_state;   // 0 = not started, 1 = in progress, 2 = done
+  std::map<int, bool> region_exact;    // Apart from its own loops of unknown length
+  std::map<int, bool> region_unbounded; // Does it have loops of unknown length?
+  for (const LoopInfo & loop : loops) {
+    if (loop.trips < 0) region_unbounded[blocks[loop.header].region] = true;
+  }
+  std::function<double(int)> total_cost = [&](int region) -> double {
+    if (region_state[region] == 2) return region_total[region];
+    if (region_state[region] == 1) { region_exact[region] = false; return 0.0; }  // Recursion
+    region_state[region] = 1;
+    region_exact[region] = true;
+    double total = 0.0;
+    if (num_blocks && region == blocks[0].region) total += setup_cycles;
+    for (int b = 0; b < num_blocks; b++) {
+      if (blocks[b].region != region) continue;
+      total += block_cycles[b] * block_count[b];
+      if (has_array_copy[b]) region_exact[region] = false;
+      const IC_Entry & term = ic_array[blocks[b].last];
+      if (term.is_call && label_region.count(term.args[0].str_value)) {
+        const int callee = label_region[term.args[0].str_value];
+        total += total_cost(callee) * block_count[b];
+        if (!region_exact[callee] || region_unbounded[callee]) region_exact[region] = false;
+      }
+    }
+    region_total[region] = total;
+    region_state[region] = 2;
+    return total;
+  };
+
+  // Cycles for one pass through a loop, counting the calls made and any inner loops
+  // of known length.
+  auto loop_cost = [&](const LoopInfo & loop) {
+    double per_iter = 0.0;
+    for (int b = loop.header; b <= loop.latch; b++) {
+      double inner = 1.0;
+      for (const LoopInfo & other : loops) {
+        if (&other == &loop || other.header < loop.header || other.latch > loop.latch) continue;
+        if (b >= other.header && b <= other.latch) {
+          inner *= (b == other.header) ? std::max(other.trips, 0) + 1 : std::max(other.trips, 1);
+        }
+      }
+      double cycles = block_cycles[b];
+      const IC_Entry & term = ic_array[blocks[b].last];
+      if (term.is_call && label_region.count(term.args[0].str_value)) {
+        cycles += total_cost(label_region[term.args[0].str_value]);
+      }
+      per_iter += cycles * inner;
+    }
+    return per_iter;
+  };
+
+  ofs << "=== Estimated TubeCode cycles ===" << std::endl;
+  for (auto & region : region_names) {
+    const int r = region.first;
+    const double total = total_cost(r);
+    ofs << "Function " << region.second << ": ~" << (long long) total << " cycles";
+    for (const LoopInfo & loop : loops) {
+      if (blocks[loop.header].region != r || loop.trips >= 0) continue;
+      ofs << " + " << (long long) loop_cost(loop) << " per pass through " << loop.name;
+    }
+    if (!region_exact[r]) ofs << " + unknown array copies / recursion / called loops";
+    ofs << std::endl;
+    if (num_blocks && r == blocks[0].region) ofs << "  setup: " << setup_cycles << " cycles" << std::endl;
+    for (int b = 0; b < num_blocks; b++) {
+      if (blocks[b].region != r) continue;
+      ofs << "  block " << (b + 1) << ": " << (long long) block_cycles[b] << " cycles x "
+          << (long long) block_count[b];
+      if (blocks[b].loop_depth) ofs << " (loop depth " << blocks[b].loop_depth << ")";
+      if (has_array_copy[b]) ofs << " + " << cost_table.ICPerElement("ar_copy") << "/array element copied";
+      ofs << std::endl;
+    }
+    for (const LoopInfo & loop : loops) {
+      if (blocks[loop.header].region != r) continue;
+      ofs << "  loop " << loop.name << " (blocks " << (loop.header + 1) << "-" << (loop.latch + 1) << "): "
+          << (long long) loop_cost(loop) << " cycles/iteration, ";
+      if (loop.trips >= 0) ofs << loop.trips << " iterations";
+      else ofs << "unknown iterations";
+      ofs << std::endl;
+    }
+  }
+}
@@ -148,6 +148,13 @@ def check_needed_files():
         raise TestFailed(["Failed (Only one README file allowed)"]) 
 
 
+def check_calibration():
+    output, returncode = call_and_get_output(
+        [os.path.join(".", PROJECT_EXECUTABLE), "-calibrate", TUBECODE_PATH], timeout=TEST_TIMEOUT)
+    if returncode or not re.search(r"^  load +\d+$", output, re.MULTILINE):
+        raise TestFailed([output, "Failed (-calibrate didn't measure instruction costs)"])
+
+
 def call_and_get_output(args, timeout=None):
     try:
         output = check_output(args, stderr=subprocess.STDOUT,
@@ -184,7 +191,29 @@ def clean_up(paths):
     return wrap
 
 
-@clean_up(["ref.tca", "stu.tca", "ref.tic", "stu.tic"])
+@clean_up(["stu.tca", "cost.tca"])
+def check_cost_report():
+    stu_exe_path = os.path.join(".", PROJECT_EXECUTABLE)
+    report, returncode = call_and_get_output(
+        [stu_exe_path, "-cost-report", "example.tube", "cost.tca"], timeout=TEST_TIMEOUT)
+    match = re.search(r"^Function main: ~(\d+) cycles$", report, re.MULTILINE)
+    if returncode or not match:
+        raise TestFailed([report, "Failed (-cost-report didn't estimate main)"])
+    call_and_get_output([stu_exe_path, "example.tube", "stu.tca"], timeout=TEST_TIMEOUT)
+    with open("cost.tca") as cost_file, open("stu.tca") as stu_file:
+        if cost_file.read() != stu_file.read():
+            raise TestFailed(["Failed (-cost-report changed the generated code)"])
+
+    # example.tube has no loops or calls, so the estimate should be exact.
+    output, returncode = call_and_get_output([TUBECODE_PATH, "-c", "stu.tca"], timeout=TEST_TIMEOUT)
+    cycles = re.search(r"Total CPU cycles used: (\d+)", output)
+    if returncode or not cycles or cycles.group(1) != match.group(1):
+        raise TestFailed([report, output, "Failed (-cost-report estimate doesn't match the VM)"])
+    for path in ["stu.tca", "cost.tca"]:
+        rm(path)
+
+
+@clean_up(["ref.tca", "stu.tca", "ref.tic", "stu.tic", "flag.tca", "flag.tic"])
 def run_test(test_file_path, compiler_flags=None, ic_only=False):
 
     @contextlib.contextmanager
@@ -345,14 +374,111 @@ tubecode output doesn't include the number of cycles used
         return int(cycles_str)
 
 
+    def get_extra_flags(test_file_path):
+        # A "# Flags: ..." line asks for the program to also be built with those flags.
+        with open(test_file_path) as test_file:
+            for line in test_file:
+                match = re.match(r"#\s*Flags:(.*)", line)
+                if match:
+                    return match.group(1).split()
+        return []
+
+    def test_extra_flags(stu_args, flags, ic_only):
+        if ic_only:
+            executable = TUBEIC_PATH
+            extension = '.tic'
+        else:
+            executable = TUBECODE_PATH
+            extension = '.tca'
+
+        flag_args = stu_args[:1] + flags + stu_args[1:-1] + ["flag" + extension]
+        flag_output, flag_returncode = call_and_get_output(flag_args, timeout=TEST_TIMEOUT)
+        if flag_returncode or re.search("ERROR", flag_output, re.IGNORECASE):
+            raise TestFailed(["Student Compiler Output with {}:".format(" ".join(flags)), flag_output,
+                              "Failed (student compiler raised an error with {})".format(" ".join(flags))])
+
+        outputs = []
+        for name in ["stu", "flag"]:
+            output, returncode = call_and_get_output(
+                [executable] + ([] if ic_only else ["-c"]) + [name + extension], timeout=TEST_TIMEOUT)
+            if returncode:
+                raise TestFailed([output, "Failed (student {} caused error in execution)".format(
+                            name + extension)])
+            # The cycle counts are expected to differ.
+            outputs.append(output.split('\n') if ic_only else output.split('\n')[:-2])
+        if outputs[0] != outputs[1]:
+            raise TestFailed(["Student Execution Output:"] + outputs[0] +
+                             ["Student Execution Output with {}:".format(" ".join(flags))] + outputs[1] +
+                             ["Failed (output with {} differs)".format(" ".join(flags))])
+
+    def test_expected_output(test_file_path, expected_path, stu_args, ic_only, allowed_cycles=None):
+        # Programs using features the reference compiler lacks list their expected
+        # output (or, for fail tests, the expected error message) instead.
+        stu_output, stu_returncode = call_and_get_output(stu_args, timeout=TEST_TIMEOUT)
+        lines = ["Student Compiler Output:", stu_output]
+        stu_said_error = bool(re.search("ERROR", stu_output, re.IGNORECASE) or stu_returncode)
+        with open(expected_path) as expected_file:
+            expected = expected_file.read()
+        if os.path.basename(test_file_path).startswith("fail"):
+            if stu_said_error and expected.strip() not in stu_output:
+                raise TestFailed(lines + ["Expected Error:", expected,
+                                          "Failed (student compiler raises a different error)"])
+            if stu_said_error:
+                raise TestPassed(lines + ["Passed (student compiler raises needed error)"])
+            raise TestFailed(lines + ["Failed (student compiler doesn't raise needed error)"])
+        if stu_said_error:
+            raise TestFailed(lines + ["Failed (student compiler raised an error needlessly)"])
+
+        extra_flags = get_extra_flags(test_file_path)
+        if extra_flags:
+            test_extra_flags(stu_args, extra_flags, ic_only)
+
+        executable = TUBEIC_PATH if ic_only else TUBECODE_PATH
+        extension = '.tic' if ic_only else '.tca'
+        output, returncode = call_and_get_output(
+            [executable] + ([] if ic_only else ["-c"]) + ["stu" + extension], timeout=TEST_TIMEOUT)
+        lines += ["Expected Execution Output:", expected, "Student Execution Output:", output]
+        if returncode:
+            raise TestFailed(lines + ["Failed (student {} caused error in execution)".format(extension)])
+        if ic_only:
+            if output != expected:
+                raise TestFailed(lines + ["Failed (student .tic execution output differs from expected)"])
+            raise TestPassed(["Passed (Student .tic has expected output)"])
+
+        output_lines = output.split('\n')
+        cycles = int(re.search(r"\d+", output_lines[-2]).group())
+        if "\n".join(output_lines[:-2]) + "\n" != expected:
+            raise TestFailed(lines + ["Failed (student .tca execution output differs from expected)"])
+        if allowed_cycles is not None and cycles > allowed_cycles:
+            raise TestFailed(lines + ["Failed (student compiler runs for too many cycles ({}))".format(cycles)])
+
+        # The intermediate code for the same program must give the same output.
+        ic_output, ic_returncode = call_and_get_output(
+            stu_args[:1] + ["-ic"] + stu_args[1:-1] + ["stu.tic"], timeout=TEST_TIMEOUT)
+        if ic_returncode or re.search("ERROR", ic_output, re.IGNORECASE):
+            raise TestFailed(["Student Compiler Output with -ic:", ic_output,
+                              "Failed (student compiler raised an error with -ic)"])
+        output, returncode = call_and_get_output([TUBEIC_PATH, "stu.tic"], timeout=TEST_TIMEOUT)
+        if returncode or output != expected:
+            raise TestFailed(["Expected Execution Output:", expected, "Student .tic Execution Output:", output,
+                              "Failed (student .tic execution output differs from expected)"])
+        raise TestPassed(["Passed (Student has expected output in {} cycles)".format(cycles)])
+
+
     lines = ["Testing: " + test_file_path]
     ref_args, stu_args = get_ref_stu_args(test_file_path, compiler_flags, ic_only)
+    expected_path = os.path.splitext(test_file_path)[0] + ".expected"
         
     with add_lines_to_TestResult(lines):
-        lines += run_compilers(ref_args, stu_args)
-        check_if_files_created(ic_only)
         if OPTIMIZATION_MODE:
             cycles = get_cycles_allowed(test_file_path)
+        if exists(expected_path):
+            test_expected_output(test_file_path, expected_path, stu_args, ic_only, allowed_cycles=cycles)
+        lines += run_compilers(ref_args, stu_args)
+        check_if_files_created(ic_only)
+        extra_flags = get_extra_flags(test_file_path)
+        if extra_flags:
+            test_extra_flags(stu_args, extra_flags, ic_only)
         test_output(ic_only, allowed_cycles=cycles)
 
 def test_files_in_order(test_globs):
@@ -418,6 +544,12 @@ def get_all_outcomes(tests):
     make = try_to_outcome_wrapper("make_worked", make_executable)
     all_outcomes.append(make())
 
+    calibrate = try_to_outcome_wrapper("calibrate_worked", check_calibration)
+    all_outcomes.append(calibrate())
+
+    cost_report = try_to_outcome_wrapper("cost_report_worked", check_cost_report)
+    all_outcomes.append(cost_report())
+
     if TEST_TIC_OUTPUT:
         tic_outcomes = run_tests(tests, ic_only=True)
         tic_renamed_outcomes = list(map(
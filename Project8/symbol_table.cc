@@ -1,5 +1,8 @@
 #include "symbol_table.h"
 
+#include <algorithm>
+#include <functional>
+
 #include "ast.h"
 #include "ic.h"
 #include "tube8-parser.tab.hh"
@@ -46,6 +49,7 @@ void tableFunction::CompileTubeIC(symbolTable & table, IC_Array & ica)
 
   // Drop a label to mark the beginning on this function.
   ica.AddLabel(call_label);
+  ica.AddFunction(this);
 
   // Process the AST for this function
   if (ast == NULL) {
@@ -58,9 +62,144 @@ void tableFunction::CompileTubeIC(symbolTable & table, IC_Array & ica)
   ast->CompileTubeIC(table, ica);
 }
 
+std::string tableFunction::GetCloneLabel(const std::vector<std::string> & const_args, int & budget)
+{
+  // Reuse an identical copy if there is one.
+  for (int i = 0; i < (int) clone_args.size(); i++) {
+    if (clone_args[i] == const_args) return GetCloneLabel(i);
+  }
+
+  // Copying a recursive function would only specialize the outermost call.
+  const int max_clones = 4;
+  if (ast == NULL || effects.recursion || (int) clone_args.size() >= max_clones) return "";
+  const int size = ast->CountNodes();
+  if (size > budget) return "";
+
+  budget -= size;
+  clone_args.push_back(const_args);
+  return GetCloneLabel((int) clone_args.size() - 1);
+}
+
+std::string tableFunction::GetCloneLabel(int clone_id) const
+{
+  std::stringstream label;
+  label << call_label << "_spec" << clone_id;
+  return label.str();
+}
+
+// A specialized copy starts by setting its constant parameters, so that constant
+// propagation can simplify the rest of the body.
+void tableFunction::CompileClone(symbolTable & table, IC_Array & ica, int clone_id)
+{
+  const std::vector<std::string> & const_args = clone_args[clone_id];
+  std::string fun_comment = "FUNCTION: ";
+  fun_comment += name;
+  fun_comment += " (specialized)";
+  ica.Add("nop", "", "", "", fun_comment);
+
+  std::string label = GetCloneLabel(clone_id);
+  ica.AddLabel(label);
+  ica.AddFunction(this, label, const_args);
+  for (int i = 0; i < (int) args.size(); i++) {
+    if (const_args[i] != "") ica.Add("val_copy", const_args[i], args[i]);
+  }
+  ast->CompileTubeIC(table, ica);
+}
+
+// Build the call graph starting from the main program, keeping only the functions that
+// can actually be called.  Tarjan's algorithm finds the strongly-connected components
+// (groups of mutually recursive functions), and finishes each one only after every
+// component it calls, so function_order lists callees before their callers.
+void symbolTable::BuildCallGraph(ASTNode * main_ast)
+{
+  FunctionEffects main_effects;
+  if (main_ast != NULL) main_ast->CollectEffects(main_effects);
+
+  std::map<tableFunction *, int> index, low_link;
+  std::vector<tableFunction *> stack;
+  std::set<tableFunction *> on_stack;
+  int num_sccs = 0;
+  function_order.clear();
+  for (auto & fun : function_map) fun.second->scc_id = -1;
+
+  std::function<void(tableFunction *)> visit = [&](tableFunction * fun) {
+    index[fun] = low_link[fun] = (int) index.size();
+    stack.push_back(fun);
+    on_stack.insert(fun);
+    for (tableFunction * callee : fun->effects.calls) {
+      if (index.count(callee) == 0) {
+        visit(callee);
+        low_link[fun] = std::min(low_link[fun], low_link[callee]);
+      } else if (on_stack.count(callee)) {
+        low_link[fun] = std::min(low_link[fun], index[callee]);
+      }
+    }
+    if (low_link[fun] != index[fun]) return;
+
+    // fun is the root of a component; everything above it on the stack belongs to it.
+    std::vector<tableFunction *> component;
+    do {
+      component.push_back(stack.back());
+      on_stack.erase(stack.back());
+      stack.pop_back();
+    } while (component.back() != fun);
+    const int scc_id = num_sccs++;
+    for (tableFunction * member : component) {
+      member->scc_id = scc_id;
+      member->effects.recursion = component.size() > 1 || member->effects.calls.count(member);
+      function_order.push_back(member);
+    }
+  };
+  for (tableFunction * fun : main_effects.calls) {
+    if (index.count(fun) == 0) visit(fun);
+  }
+}
+
+// Work out what each function may do, including through the functions it calls.
+void symbolTable::AnalyzeEffects(ASTNode * main_ast)
+{
+  for (auto & fun : function_map) {
+    tableFunction * cur_fun = fun.second;
+    cur_fun->effects = FunctionEffects();
+    if (cur_fun->ast != NULL) cur_fun->ast->CollectEffects(cur_fun->effects);
+  }
+
+  BuildCallGraph(main_ast);
+
+  // Each function also has the effects of those it calls.  Going bottom-up, only
+  // recursive functions need more than one pass.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (tableFunction * cur_fun : function_order) {
+      FunctionEffects & effects = cur_fun->effects;
+      for (tableFunction * callee : effects.calls) {
+        const FunctionEffects & sub = callee->effects;
+        if ((sub.reads_globals && !effects.reads_globals) || (sub.writes_globals && !effects.writes_globals) ||
+            (sub.mutates_arrays && !effects.mutates_arrays) || (sub.uses_random && !effects.uses_random) ||
+            (sub.does_output && !effects.does_output) || (sub.recursion && !effects.recursion)) {
+          changed = true;
+        }
+        effects.reads_globals |= sub.reads_globals;
+        effects.writes_globals |= sub.writes_globals;
+        effects.mutates_arrays |= sub.mutates_arrays;
+        effects.uses_random |= sub.uses_random;
+        effects.does_output |= sub.does_output;
+        effects.recursion |= sub.recursion;
+      }
+    }
+  }
+}
+
 void symbolTable::CompileTubeIC(IC_Array & ica)
 {
-  if (function_map.size() > 0) {
+  // Every function must be defined, even if it is never called.
+  for (auto & fun : function_map) {
+    if (fun.second->GetAST() == NULL) fun.second->CompileTubeIC(*this, ica);   // Reports the error.
+  }
+
+  // Only functions reachable from the main program are emitted, callees first.
+  if (function_order.size() > 0) {
     std::string end_label = "define_functions_end";
     
     ica.Add("nop");
@@ -69,12 +208,21 @@ void symbolTable::CompileTubeIC(IC_Array & ica)
     ica.Add("jump", end_label, "", "", "Skip over function defs during normal execution");
     ica.Add("nop");
     
-    for (std::map<std::string, tableFunction *>::iterator it = function_map.begin();
-         it != function_map.end();
-         ++it ) {
-      tableFunction * cur_fun = it->second;
+    for (tableFunction * cur_fun : function_order) {
       cur_fun->CompileTubeIC(*this, ica);
     }
+
+    // Specialized copies can ask for more copies, so keep going until all are done.
+    bool added = true;
+    while (added) {
+      added = false;
+      for (tableFunction * cur_fun : function_order) {
+        while (cur_fun->clones_compiled < (int) cur_fun->clone_args.size()) {
+          cur_fun->CompileClone(*this, ica, cur_fun->clones_compiled++);
+          added = true;
+        }
+      }
+    }
     
     ica.AddLabel(end_label);
   }
@@ -17,6 +17,7 @@
 // tableEntry : all of the stored information about a single variable.
 
 class symbolTable;
+class tableFunction;
 class ASTNode;
 class IC_Array;
 
@@ -32,6 +33,7 @@ protected:
   int index_id;            // If this variable is an array index, which index?
   int scope;               // What scope was this variable created at?
   tableEntry * next;       // Pointer to another variable this one is shadowing.
+  std::vector<tableEntry *> elements;  // If this is a fixed-size array, its element variables.
 
   tableEntry(int in_type) 
     : type_id (in_type)
@@ -54,6 +56,8 @@ protected:
     , array_id(-1)
     , array_ptr(NULL)
     , index_id(-1)
+    , scope(-1)
+    , next(NULL)
   {
   }
   virtual ~tableEntry() { ; }
@@ -69,6 +73,7 @@ public:
   int GetIndexID()       const { return index_id; }
   int GetScope()         const { return scope; }
   tableEntry * GetNext() const { return next; }
+  const std::vector<tableEntry *> & GetElements() const { return elements; }
 
   void SetName(std::string in_name) { name = in_name; }
   void SetVarID(int in_id) { var_id = in_id; }
@@ -85,6 +90,24 @@ public:
 
 
 
+// What a function may do besides compute its result; see symbolTable::AnalyzeEffects().
+// The flags include everything done by the functions it calls.
+struct FunctionEffects {
+  bool reads_globals = false;    // Reads a variable declared outside of any function
+  bool writes_globals = false;   // Assigns to (or changes the array held in) such a variable
+  bool mutates_arrays = false;   // Changes the contents or size of any array
+  bool uses_random = false;      // Calls random()
+  bool does_output = false;      // Prints anything
+  bool recursion = false;        // Might end up calling itself
+  std::set<tableFunction *> calls;  // Functions called directly
+
+  // A pure function's result depends only on its arguments, and calling it has no
+  // visible effect; it is also non-recursive, so it is sure to finish.
+  bool IsPure() const {
+    return !reads_globals && !writes_globals && !uses_random && !does_output && !recursion;
+  }
+};
+
 class tableFunction {
   friend class symbolTable;
 protected:
@@ -96,6 +119,10 @@ protected:
   std::vector<tableEntry *> args; // Pointers to parameter variables
   bool args_set;                  // Have we already set the arguments?
   int dec_line;                   // Line was this function first declared on
+  FunctionEffects effects;        // What this function may do (once analyzed)
+  std::vector<std::vector<std::string>> clone_args;  // Constant arguments of each specialized copy
+  int clones_compiled;            // How many of those copies have been compiled so far
+  int scc_id;                     // Group of mutually recursive functions this is in (-1 if never called)
 
   tableFunction(int in_type, const std::string in_name)
     : name(in_name)
@@ -104,6 +131,8 @@ protected:
     , ast(NULL)
     , args_set(false)
     , dec_line(-1)
+    , clones_compiled(0)
+    , scc_id(-1)
   {
     call_label = "function_";
     call_label += name;
@@ -118,6 +147,8 @@ public:
   std::string GetCallLabel() const { return call_label; }
   const std::vector<tableEntry *> & GetArgs() const { return args; }
   int GetDeclareLine()  const { return dec_line; }
+  const FunctionEffects & GetEffects() const { return effects; }
+  int GetSCC()          const { return scc_id; }
 
   void SetReturnID(int in_id) { return_id = in_id; }
   void SetAST(ASTNode * in_ast) { ast = in_ast; }
@@ -127,7 +158,13 @@ public:
   bool ReturnIsArray() { return Type::IsArray(return_type); }
   bool ReturnIsScalar() { return Type::IsScalar(return_type); }
 
+  // Call label for a copy of this function with some parameters fixed to constants (const_args
+  // holds "" for parameters that are still passed in); returns "" if no copy should be made.
+  std::string GetCloneLabel(const std::vector<std::string> & const_args, int & budget);
+  std::string GetCloneLabel(int clone_id) const;
+
   void CompileTubeIC(symbolTable & table, IC_Array & ica);
+  void CompileClone(symbolTable & table, IC_Array & ica, int clone_id);
 };
 
 
@@ -146,12 +183,17 @@ private:
   std::vector<std::string> while_start_stack; // Start labels for while commands, in case of continue
   std::vector<std::string> while_end_stack;   // End labels for while commands, in case of break
   tableFunction * cur_function;               // Which function are we currently defining?
+  int clone_budget;                           // AST nodes that may still be copied into specialized functions
+  std::vector<tableFunction *> function_order; // Functions the program can call, callees before callers
+  std::map<std::string, tableEntry *> literal_map; // Pooled array literals, by type and contents
+
+  void BuildCallGraph(ASTNode * main_ast);
 
   // Figure out the next memory position to use.  Ideally, we should be
   // recycling these!!
   int GetNextID() { return next_var_id++; }
 public:
-  symbolTable() : cur_scope(0), next_var_id(1), next_label_id(0), cur_function(NULL) { 
+  symbolTable() : cur_scope(0), next_var_id(1), next_label_id(0), cur_function(NULL), clone_budget(2000) { 
     scope_info.push_back(new std::vector<tableEntry *>);
   }
   ~symbolTable() {
@@ -170,6 +212,8 @@ public:
     return *(scope_info[scope]);
   }
   tableFunction * GetCurFunction() { return cur_function; }
+  int & GetCloneBudget() { return clone_budget; }
+  const std::vector<tableFunction *> & GetFunctionOrder() { return function_order; }
 
   const std::set<int> & GetTempScalars() { return temp_svar_ids; }
   const std::set<int> & GetTempArrays() { return temp_avar_ids; }
@@ -256,6 +300,22 @@ public:
     return new_entry;
   }
 
+  // Insert a fixed-size array.  Its elements are plain variables with consecutive IDs (so
+  // they sit in a static block of memory cells), the first sharing the array's own ID.
+  // Returns NULL if the block would run into the stack, which starts at cell 10000.
+  tableEntry * AddFixedArray(std::string in_name, int size) {
+    if (next_var_id + size >= 10000) return NULL;
+    tableEntry * new_entry = AddEntry(Type::FIXED_VALUE_ARRAY, in_name);
+    for (int i = 0; i < size; i++) {
+      tableEntry * element = new tableEntry(Type::VALUE, in_name + "[" + std::to_string(i) + "]");
+      element->SetVarID( (i == 0) ? new_entry->GetVarID() : GetNextID() );
+      element->SetScope(cur_scope);
+      var_archive.push_back(element);
+      new_entry->elements.push_back(element);
+    }
+    return new_entry;
+  }
+
   // Start defining a new function.
   tableFunction * StartFunction(int return_type, std::string in_name) {
     cur_function = LookupFunction(in_name);
@@ -285,6 +345,19 @@ public:
     return new_entry;
   }
 
+  // The variable holding the pooled copy of an array literal (described by its contents),
+  // made the first time it is seen.  It is never a temporary, so calls don't back it up.
+  tableEntry * GetLiteralVar(int type_id, const std::string & value) {
+    tableEntry *& entry = literal_map[Type::AsString(type_id) + ":" + value];
+    if (entry == NULL) {
+      entry = new tableEntry(type_id, value);
+      entry->SetVarID( GetNextID() );
+      entry->SetScope(0);
+      var_archive.push_back(entry);
+    }
+    return entry;
+  }
+
   // Don't create a full variable; just get an unused variable ID.
   tableEntry * GetTempVar(int type_id) {
     const int id=GetNextID();
@@ -308,6 +381,7 @@ public:
     else delete del_var;
   }
 
+  void AnalyzeEffects(ASTNode * main_ast);
   void CompileTubeIC(IC_Array & ica);
 
   void Debug() {
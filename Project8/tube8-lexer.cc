@@ -0,0 +1,269 @@
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+
+#include "symbol_table.h"
+#include "type_info.h"
+#include "ast.h"
+#include "tube_cost.h"
+#include "tube8-parser.tab.hh"
+
+#include <iostream>
+#include <stdio.h>
+#include <string>
+
+// Two global variables (not clean, but works...)
+int line_num = 1;
+std::string out_filename = "";
+bool use_int_code = false;
+bool cost_report = false;
+bool use_gc = false;
+
+#define LX_OPS "+-*/%=(),!{}[].:?;"
+#define LX_SWITCH
+#define LX_MOD
+FILE * yyin = NULL;
+char * yytext = NULL;
+static std::string lx_buf;
+static size_t lx_pos = 0;
+static bool lx_loaded = false;
+static std::string lx_text;
+
+static void lx_load() {
+  if (lx_loaded) return;
+  lx_loaded = true;
+  if (!yyin) yyin = stdin;
+  int c;
+  while ((c = fgetc(yyin)) != EOF) lx_buf += (char) c;
+}
+
+static int lx_set(size_t len) {
+  lx_text = lx_buf.substr(lx_pos, len);
+  lx_pos += len;
+  yytext = (char *) lx_text.c_str();
+  return 0;
+}
+
+static bool lx_alpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+static bool lx_digit(char c) { return c >= '0' && c <= '9'; }
+
+int yylex() {
+  lx_load();
+  const std::string & b = lx_buf;
+  while (lx_pos < b.size()) {
+    char c = b[lx_pos];
+    size_t n = b.size();
+    auto at = [&](size_t i) -> char { return (lx_pos + i < n) ? b[lx_pos + i] : '\0'; };
+    if (c == ' ' || c == '\t' || c == '\r') { lx_pos++; continue; }
+    if (c == '\n') { line_num++; lx_pos++; continue; }
+    if (c == '#') { while (lx_pos < n && b[lx_pos] != '\n') lx_pos++; continue; }
+
+    // identifiers & keywords
+    {
+      size_t i = 0;
+      while (at(i) == '_') i++;
+      if (lx_alpha(at(i))) {
+        i++;
+        while (lx_alpha(at(i)) || lx_digit(at(i)) || at(i) == '_') i++;
+        lx_set(i);
+        std::string s = lx_text;
+        if (s == "break") return COMMAND_BREAK;
+        if (s == "continue") return COMMAND_CONTINUE;
+        if (s == "define") return COMMAND_DEFINE;
+        if (s == "declare") return COMMAND_DECLARE;
+        if (s == "else") return COMMAND_ELSE;
+        if (s == "for") return COMMAND_FOR;
+        if (s == "if") return COMMAND_IF;
+        if (s == "print") return COMMAND_PRINT;
+        if (s == "random") return COMMAND_RANDOM;
+        if (s == "return") return COMMAND_RETURN;
+        if (s == "while") return COMMAND_WHILE;
+#ifdef LX_SWITCH
+        if (s == "switch") return COMMAND_SWITCH;
+        if (s == "case") return COMMAND_CASE;
+        if (s == "default") return COMMAND_DEFAULT;
+#endif
+        yylval.lexeme = strdup(yytext);
+        if (s == "val" || s == "char" || s == "string") return TYPE;
+        if (s == "array") return META_TYPE;
+        return ID;
+      }
+    }
+
+    // numbers
+    {
+      size_t i = 0;
+      while (lx_digit(at(i))) i++;
+      size_t best = i;
+      if (at(i) == '.' && lx_digit(at(i + 1))) {
+        size_t j = i + 1;
+        while (lx_digit(at(j))) j++;
+        best = j;
+      }
+      if (best > 0) { lx_set(best); yylval.lexeme = strdup(yytext); return VAL_LIT; }
+    }
+
+    // chars
+    if (c == '\'') {
+      if (at(1) == '\\' && (at(2) == '\\' || at(2) == '\'' || at(2) == 'n' || at(2) == 't') && at(3) == '\'') {
+        lx_set(4); yylval.lexeme = strdup(yytext); return CHAR_LIT;
+      }
+      if (at(1) != '\n' && at(1) != '\0' && at(2) == '\'') {
+        lx_set(3); yylval.lexeme = strdup(yytext); return CHAR_LIT;
+      }
+    }
+
+    // strings
+    if (c == '"') {
+      size_t i = 1; bool bad = false; bool closed = false;
+      while (lx_pos + i < n) {
+        char d = b[lx_pos + i];
+        if (d == '\\') {
+          char e = at(i + 1);
+          if (e == '\n' || e == '\0') break;
+          if (!(e == 'n' || e == 't' || e == '"' || e == '\\')) bad = true;
+          i += 2; continue;
+        }
+        if (d == '"') { closed = true; i++; break; }
+        i++;
+      }
+      if (!closed) {
+        std::cout << "ERROR(line " << line_num << "): Unterminated string." << std::endl;
+        exit(1);
+      }
+      if (bad) {
+        std::cout << "ERROR(line " << line_num << "): Unknown escape char in string." << std::endl;
+        exit(1);
+      }
+      lx_set(i); yylval.lexeme = strdup(yytext); return STRING_LIT;
+    }
+
+    // two-char operators
+    {
+      std::string two = b.substr(lx_pos, 2);
+      if (two == "+=") { lx_set(2); return CASSIGN_ADD; }
+      if (two == "-=") { lx_set(2); return CASSIGN_SUB; }
+      if (two == "*=") { lx_set(2); return CASSIGN_MULT; }
+      if (two == "/=") { lx_set(2); return CASSIGN_DIV; }
+#ifdef LX_MOD
+      if (two == "%=") { lx_set(2); return CASSIGN_MOD; }
+#endif
+      if (two == "==") { lx_set(2); return COMP_EQU; }
+      if (two == "!=") { lx_set(2); return COMP_NEQU; }
+      if (two == "<=") { lx_set(2); return COMP_LTE; }
+      if (two == ">=") { lx_set(2); return COMP_GTE; }
+      if (two == "&&") { lx_set(2); return BOOL_AND; }
+      if (two == "||") { lx_set(2); return BOOL_OR; }
+    }
+    if (c == '<') { lx_set(1); return COMP_LESS; }
+    if (c == '>') { lx_set(1); return COMP_GTR; }
+    if (strchr(LX_OPS, c) != NULL) {
+      lx_set(1); yylval.lexeme = strdup(yytext); return (int) c;
+    }
+    lx_set(1);
+    std::cout << "ERROR(line " << line_num << "): Unknown Token '" << yytext << "'." << std::endl;
+    exit(1);
+  }
+  return 0;
+}
+
+
+
+void LexMain(int argc, char * argv[])
+{
+  FILE * file = NULL;
+  bool input_found = false;
+  bool calibrated = false;
+
+  use_int_code = false;
+  cost_report = false;
+  use_gc = false;
+
+  // Loop through all of the command-line arguments.
+  for (int arg_id = 1; arg_id < argc; arg_id++) {
+    std::string cur_arg(argv[arg_id]);
+
+    if (cur_arg == "-h") {
+      std::cout << "Tubular Compiler v. 0.6.0 (Project 6 release 1)"  << std::endl
+           << "Format: " << argv[0] << "[flags] [filename]" << std::endl
+           << std::endl
+           << "Available Flags:" << std::endl
+           << "  -h  :  Help (this information)" << std::endl
+           << "  -ic :  Genereate Intermediate Code" << std::endl
+           << "  -cost-report :  Print estimated cycles per block, loop, and function" << std::endl
+           << "  -gc :  Include a garbage collector for arrays" << std::endl
+           << "  -calibrate [vm] :  Measure instruction costs using the tubecode executable [vm]" << std::endl;
+        ;
+      exit(0);
+    }
+
+    if (cur_arg == "-ic") {
+      use_int_code = true;
+      continue;
+    }
+
+    if (cur_arg == "-cost-report") {
+      cost_report = true;
+      continue;
+    }
+
+    if (cur_arg == "-gc") {
+      use_gc = true;
+      continue;
+    }
+
+    if (cur_arg == "-calibrate") {
+      if (arg_id + 1 >= argc) {
+        std::cerr << "ERROR: -calibrate requires the path to a tubecode executable." << std::endl;
+        exit(1);
+      }
+      if (!cost_table.Calibrate(argv[++arg_id], std::cerr)) exit(1);
+      calibrated = true;
+      continue;
+    }
+
+    // PROCESS OTHER ARGUMENTS HERE IF YOU ADD THEM
+
+    // If the next argument begins with a dash, assume it's an unknown flag...
+    if (cur_arg[0] == '-') {
+      std::cerr << "ERROR: Unknown command-line flag: " << cur_arg << std::endl;
+      exit(1);
+    }
+
+    // Assume the current argument is a filename (first input, then output)
+    if (!input_found) {
+      file = fopen(argv[arg_id], "r");
+      if (!file) {
+        std::cerr << "Error opening " << cur_arg << std::endl;
+        exit(1);
+      }
+      yyin = file;
+      input_found = true;
+      continue;
+    } else if (out_filename == "") {
+      out_filename = cur_arg;
+    }
+
+    // Both files already loaded!
+    else {
+      std::cout << "ERROR: Unknown argument '" << cur_arg << "'" << std::endl;
+      exit(1);
+    }
+  }
+
+  // Calibration alone just reports the measured costs.
+  if (calibrated && input_found == false) {
+    cost_table.Print(std::cout);
+    exit(0);
+  }
+
+  // Make sure we've loaded input and output filenames before we finish...
+  if (input_found == false || out_filename == "") {
+    std::cerr << "Format: " << argv[0] << "[flags] [input filename] [output filename]" << std::endl;
+    std::cerr << "Type '" << argv[0] << " -h' for help." << std::endl;
+    exit(1);
+  }
+ 
+  return;
+}
+
@@ -0,0 +1,2524 @@
+/* A Bison parser, made by GNU Bison 3.8.2.  */
+
+/* Bison implementation for Yacc-like parsers in C
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* As a special exception, you may create a larger work that contains
+   part or all of the Bison parser skeleton and distribute that work
+   under terms of your choice, so long as that work isn't itself a
+   parser generator using the skeleton or a modified version thereof
+   as a parser skeleton.  Alternatively, if you modify or redistribute
+   the parser skeleton itself, you may (at your option) remove this
+   special exception, which will cause the skeleton and the resulting
+   Bison output files to be licensed under the GNU General Public
+   License without this special exception.
+
+   This special exception was added by the Free Software Foundation in
+   version 2.2 of Bison.  */
+
+/* C LALR(1) parser skeleton written by Richard Stallman, by
+   simplifying the original so-called "semantic" parser.  */
+
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+/* All symbols defined below should begin with yy or YY, to avoid
+   infringing on user name space.  This should be done even for local
+   variables, as they might otherwise be expanded by user macros.
+   There are some unavoidable exceptions within include files to
+   define necessary library symbols; they are noted "INFRINGES ON
+   USER NAME SPACE" below.  */
+
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
+
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
+
+/* Skeleton name.  */
+#define YYSKELETON_NAME "yacc.c"
+
+/* Pure parsers.  */
+#define YYPURE 0
+
+/* Push parsers.  */
+#define YYPUSH 0
+
+/* Pull parsers.  */
+#define YYPULL 1
+
+
+
+
+/* First part of user prologue.  */
+#line 1 "tube8.y"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <stdio.h>
+
+#include "symbol_table.h"
+#include "ast.h"
+#include "type_info.h"
+
+extern int line_num;
+extern int yylex();
+extern std::string out_filename;
+extern bool use_int_code;
+extern bool cost_report;
+ 
+symbolTable symbol_table;
+int error_count = 0;
+
+// Create an error function to call when the current line has an error
+void yyerror(std::string err_string) {
+  std::cout << "ERROR(line " << line_num << "): "
+       << err_string << std::endl;
+  error_count++;
+}
+
+// Create an alternate error function when a *different* line than being read in has an error.
+void yyerror2(std::string err_string, int orig_line) {
+  std::cout << "ERROR(line " << orig_line << "): "
+       << err_string << std::endl;
+  error_count++;
+}
+
+
+#line 108 "tube8-parser.tab.cc"
+
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
+#  else
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
+# ifndef YY_NULLPTR
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
+#  else
+#   define YY_NULLPTR ((void*)0)
+#  endif
+# endif
+
+#include "tube8-parser.tab.hh"
+/* Symbol kind.  */
+enum yysymbol_kind_t
+{
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_CASSIGN_ADD = 3,                /* CASSIGN_ADD  */
+  YYSYMBOL_CASSIGN_SUB = 4,                /* CASSIGN_SUB  */
+  YYSYMBOL_CASSIGN_MULT = 5,               /* CASSIGN_MULT  */
+  YYSYMBOL_CASSIGN_DIV = 6,                /* CASSIGN_DIV  */
+  YYSYMBOL_CASSIGN_MOD = 7,                /* CASSIGN_MOD  */
+  YYSYMBOL_COMP_EQU = 8,                   /* COMP_EQU  */
+  YYSYMBOL_COMP_NEQU = 9,                  /* COMP_NEQU  */
+  YYSYMBOL_COMP_LESS = 10,                 /* COMP_LESS  */
+  YYSYMBOL_COMP_LTE = 11,                  /* COMP_LTE  */
+  YYSYMBOL_COMP_GTR = 12,                  /* COMP_GTR  */
+  YYSYMBOL_COMP_GTE = 13,                  /* COMP_GTE  */
+  YYSYMBOL_BOOL_AND = 14,                  /* BOOL_AND  */
+  YYSYMBOL_BOOL_OR = 15,                   /* BOOL_OR  */
+  YYSYMBOL_COMMAND_PRINT = 16,             /* COMMAND_PRINT  */
+  YYSYMBOL_COMMAND_IF = 17,                /* COMMAND_IF  */
+  YYSYMBOL_COMMAND_ELSE = 18,              /* COMMAND_ELSE  */
+  YYSYMBOL_COMMAND_WHILE = 19,             /* COMMAND_WHILE  */
+  YYSYMBOL_COMMAND_FOR = 20,               /* COMMAND_FOR  */
+  YYSYMBOL_COMMAND_BREAK = 21,             /* COMMAND_BREAK  */
+  YYSYMBOL_COMMAND_CONTINUE = 22,          /* COMMAND_CONTINUE  */
+  YYSYMBOL_COMMAND_RANDOM = 23,            /* COMMAND_RANDOM  */
+  YYSYMBOL_COMMAND_RETURN = 24,            /* COMMAND_RETURN  */
+  YYSYMBOL_COMMAND_DEFINE = 25,            /* COMMAND_DEFINE  */
+  YYSYMBOL_COMMAND_DECLARE = 26,           /* COMMAND_DECLARE  */
+  YYSYMBOL_COMMAND_SWITCH = 27,            /* COMMAND_SWITCH  */
+  YYSYMBOL_COMMAND_CASE = 28,              /* COMMAND_CASE  */
+  YYSYMBOL_COMMAND_DEFAULT = 29,           /* COMMAND_DEFAULT  */
+  YYSYMBOL_VAL_LIT = 30,                   /* VAL_LIT  */
+  YYSYMBOL_CHAR_LIT = 31,                  /* CHAR_LIT  */
+  YYSYMBOL_STRING_LIT = 32,                /* STRING_LIT  */
+  YYSYMBOL_TYPE = 33,                      /* TYPE  */
+  YYSYMBOL_META_TYPE = 34,                 /* META_TYPE  */
+  YYSYMBOL_ID = 35,                        /* ID  */
+  YYSYMBOL_36_ = 36,                       /* '='  */
+  YYSYMBOL_37_ = 37,                       /* ':'  */
+  YYSYMBOL_38_ = 38,                       /* '?'  */
+  YYSYMBOL_39_ = 39,                       /* '+'  */
+  YYSYMBOL_40_ = 40,                       /* '-'  */
+  YYSYMBOL_41_ = 41,                       /* '*'  */
+  YYSYMBOL_42_ = 42,                       /* '/'  */
+  YYSYMBOL_43_ = 43,                       /* '%'  */
+  YYSYMBOL_UMINUS = 44,                    /* UMINUS  */
+  YYSYMBOL_45_ = 45,                       /* '!'  */
+  YYSYMBOL_46_ = 46,                       /* '.'  */
+  YYSYMBOL_NOELSE = 47,                    /* NOELSE  */
+  YYSYMBOL_48_ = 48,                       /* ';'  */
+  YYSYMBOL_49_ = 49,                       /* '('  */
+  YYSYMBOL_50_ = 50,                       /* ')'  */
+  YYSYMBOL_51_ = 51,                       /* ','  */
+  YYSYMBOL_52_ = 52,                       /* '['  */
+  YYSYMBOL_53_ = 53,                       /* ']'  */
+  YYSYMBOL_54_ = 54,                       /* '{'  */
+  YYSYMBOL_55_ = 55,                       /* '}'  */
+  YYSYMBOL_YYACCEPT = 56,                  /* $accept  */
+  YYSYMBOL_program = 57,                   /* program  */
+  YYSYMBOL_statement_list = 58,            /* statement_list  */
+  YYSYMBOL_statement = 59,                 /* statement  */
+  YYSYMBOL_type_any = 60,                  /* type_any  */
+  YYSYMBOL_var_declare = 61,               /* var_declare  */
+  YYSYMBOL_declare_assign = 62,            /* declare_assign  */
+  YYSYMBOL_var_usage = 63,                 /* var_usage  */
+  YYSYMBOL_array_index = 64,               /* array_index  */
+  YYSYMBOL_lhs_ok = 65,                    /* lhs_ok  */
+  YYSYMBOL_expression = 66,                /* expression  */
+  YYSYMBOL_argument_list = 67,             /* argument_list  */
+  YYSYMBOL_argument = 68,                  /* argument  */
+  YYSYMBOL_command = 69,                   /* command  */
+  YYSYMBOL_if_start = 70,                  /* if_start  */
+  YYSYMBOL_while_start = 71,               /* while_start  */
+  YYSYMBOL_for_init = 72,                  /* for_init  */
+  YYSYMBOL_opt_expr = 73,                  /* opt_expr  */
+  YYSYMBOL_for_start = 74,                 /* for_start  */
+  YYSYMBOL_flow_command = 75,              /* flow_command  */
+  YYSYMBOL_case_list = 76,                 /* case_list  */
+  YYSYMBOL_declare_start = 77,             /* declare_start  */
+  YYSYMBOL_define_start = 78,              /* define_start  */
+  YYSYMBOL_fun_arg_list = 79,              /* fun_arg_list  */
+  YYSYMBOL_fun_arg_test = 80,              /* fun_arg_test  */
+  YYSYMBOL_define_command = 81,            /* define_command  */
+  YYSYMBOL_82_1 = 82,                      /* $@1  */
+  YYSYMBOL_declare_command = 83,           /* declare_command  */
+  YYSYMBOL_block_start = 84,               /* block_start  */
+  YYSYMBOL_block_end = 85,                 /* block_end  */
+  YYSYMBOL_code_block = 86                 /* code_block  */
+};
+typedef enum yysymbol_kind_t yysymbol_kind_t;
+
+
+
+
+#ifdef short
+# undef short
+#endif
+
+/* On compilers that do not define __PTRDIFF_MAX__ etc., make sure
+   <limits.h> and (if available) <stdint.h> are included
+   so that the code can choose integer types of a good width.  */
+
+#ifndef __PTRDIFF_MAX__
+# include <limits.h> /* INFRINGES ON USER NAME SPACE */
+# if defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stdint.h> /* INFRINGES ON USER NAME SPACE */
+#  define YY_STDINT_H
+# endif
+#endif
+
+/* Narrow types that promote to a signed type and that can represent a
+   signed or unsigned integer of at least N bits.  In tables they can
+   save space and decrease cache pressure.  Promoting to a signed type
+   helps avoid bugs in integer arithmetic.  */
+
+#ifdef __INT_LEAST8_MAX__
+typedef __INT_LEAST8_TYPE__ yytype_int8;
+#elif defined YY_STDINT_H
+typedef int_least8_t yytype_int8;
+#else
+typedef signed char yytype_int8;
+#endif
+
+#ifdef __INT_LEAST16_MAX__
+typedef __INT_LEAST16_TYPE__ yytype_int16;
+#elif defined YY_STDINT_H
+typedef int_least16_t yytype_int16;
+#else
+typedef short yytype_int16;
+#endif
+
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
+#endif
+
+#if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST8_TYPE__ yytype_uint8;
+#elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST8_MAX <= INT_MAX)
+typedef uint_least8_t yytype_uint8;
+#elif !defined __UINT_LEAST8_MAX__ && UCHAR_MAX <= INT_MAX
+typedef unsigned char yytype_uint8;
+#else
+typedef short yytype_uint8;
+#endif
+
+#if defined __UINT_LEAST16_MAX__ && __UINT_LEAST16_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST16_TYPE__ yytype_uint16;
+#elif (!defined __UINT_LEAST16_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST16_MAX <= INT_MAX)
+typedef uint_least16_t yytype_uint16;
+#elif !defined __UINT_LEAST16_MAX__ && USHRT_MAX <= INT_MAX
+typedef unsigned short yytype_uint16;
+#else
+typedef int yytype_uint16;
+#endif
+
+#ifndef YYPTRDIFF_T
+# if defined __PTRDIFF_TYPE__ && defined __PTRDIFF_MAX__
+#  define YYPTRDIFF_T __PTRDIFF_TYPE__
+#  define YYPTRDIFF_MAXIMUM __PTRDIFF_MAX__
+# elif defined PTRDIFF_MAX
+#  ifndef ptrdiff_t
+#   include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  endif
+#  define YYPTRDIFF_T ptrdiff_t
+#  define YYPTRDIFF_MAXIMUM PTRDIFF_MAX
+# else
+#  define YYPTRDIFF_T long
+#  define YYPTRDIFF_MAXIMUM LONG_MAX
+# endif
+#endif
+
+#ifndef YYSIZE_T
+# ifdef __SIZE_TYPE__
+#  define YYSIZE_T __SIZE_TYPE__
+# elif defined size_t
+#  define YYSIZE_T size_t
+# elif defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  define YYSIZE_T size_t
+# else
+#  define YYSIZE_T unsigned
+# endif
+#endif
+
+#define YYSIZE_MAXIMUM                                  \
+  YY_CAST (YYPTRDIFF_T,                                 \
+           (YYPTRDIFF_MAXIMUM < YY_CAST (YYSIZE_T, -1)  \
+            ? YYPTRDIFF_MAXIMUM                         \
+            : YY_CAST (YYSIZE_T, -1)))
+
+#define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
+
+
+/* Stored state numbers (used for stacks). */
+typedef yytype_uint8 yy_state_t;
+
+/* State numbers in computations.  */
+typedef int yy_state_fast_t;
+
+#ifndef YY_
+# if defined YYENABLE_NLS && YYENABLE_NLS
+#  if ENABLE_NLS
+#   include <libintl.h> /* INFRINGES ON USER NAME SPACE */
+#   define YY_(Msgid) dgettext ("bison-runtime", Msgid)
+#  endif
+# endif
+# ifndef YY_
+#  define YY_(Msgid) Msgid
+# endif
+#endif
+
+
+#ifndef YY_ATTRIBUTE_PURE
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
+#endif
+
+#ifndef YY_ATTRIBUTE_UNUSED
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
+# else
+#  define YY_ATTRIBUTE_UNUSED
+# endif
+#endif
+
+/* Suppress unused-variable warnings by "using" E.  */
+#if ! defined lint || defined __GNUC__
+# define YY_USE(E) ((void) (E))
+#else
+# define YY_USE(E) /* empty */
+#endif
+
+/* Suppress an incorrect diagnostic about yylval being uninitialized.  */
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
+    _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
+    _Pragma ("GCC diagnostic pop")
+#else
+# define YY_INITIAL_VALUE(Value) Value
+#endif
+#ifndef YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END
+#endif
+#ifndef YY_INITIAL_VALUE
+# define YY_INITIAL_VALUE(Value) /* Nothing. */
+#endif
+
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
+
+#define YY_ASSERT(E) ((void) (0 && (E)))
+
+#if !defined yyoverflow
+
+/* The parser invokes alloca or malloc; define the necessary symbols.  */
+
+# ifdef YYSTACK_USE_ALLOCA
+#  if YYSTACK_USE_ALLOCA
+#   ifdef __GNUC__
+#    define YYSTACK_ALLOC __builtin_alloca
+#   elif defined __BUILTIN_VA_ARG_INCR
+#    include <alloca.h> /* INFRINGES ON USER NAME SPACE */
+#   elif defined _AIX
+#    define YYSTACK_ALLOC __alloca
+#   elif defined _MSC_VER
+#    include <malloc.h> /* INFRINGES ON USER NAME SPACE */
+#    define alloca _alloca
+#   else
+#    define YYSTACK_ALLOC alloca
+#    if ! defined _ALLOCA_H && ! defined EXIT_SUCCESS
+#     include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
+      /* Use EXIT_SUCCESS as a witness for stdlib.h.  */
+#     ifndef EXIT_SUCCESS
+#      define EXIT_SUCCESS 0
+#     endif
+#    endif
+#   endif
+#  endif
+# endif
+
+# ifdef YYSTACK_ALLOC
+   /* Pacify GCC's 'empty if-body' warning.  */
+#  define YYSTACK_FREE(Ptr) do { /* empty */; } while (0)
+#  ifndef YYSTACK_ALLOC_MAXIMUM
+    /* The OS might guarantee only one guard page at the bottom of the stack,
+       and a page size can be as small as 4096 bytes.  So we cannot safely
+       invoke alloca (N) if N exceeds 4096.  Use a slightly smaller number
+       to allow for a few compiler-allocated temporary stack slots.  */
+#   define YYSTACK_ALLOC_MAXIMUM 4032 /* reasonable circa 2006 */
+#  endif
+# else
+#  define YYSTACK_ALLOC YYMALLOC
+#  define YYSTACK_FREE YYFREE
+#  ifndef YYSTACK_ALLOC_MAXIMUM
+#   define YYSTACK_ALLOC_MAXIMUM YYSIZE_MAXIMUM
+#  endif
+#  if (defined __cplusplus && ! defined EXIT_SUCCESS \
+       && ! ((defined YYMALLOC || defined malloc) \
+             && (defined YYFREE || defined free)))
+#   include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
+#   ifndef EXIT_SUCCESS
+#    define EXIT_SUCCESS 0
+#   endif
+#  endif
+#  ifndef YYMALLOC
+#   define YYMALLOC malloc
+#   if ! defined malloc && ! defined EXIT_SUCCESS
+void *malloc (YYSIZE_T); /* INFRINGES ON USER NAME SPACE */
+#   endif
+#  endif
+#  ifndef YYFREE
+#   define YYFREE free
+#   if ! defined free && ! defined EXIT_SUCCESS
+void free (void *); /* INFRINGES ON USER NAME SPACE */
+#   endif
+#  endif
+# endif
+#endif /* !defined yyoverflow */
+
+#if (! defined yyoverflow \
+     && (! defined __cplusplus \
+         || (defined YYSTYPE_IS_TRIVIAL && YYSTYPE_IS_TRIVIAL)))
+
+/* A type that is properly aligned for any stack member.  */
+union yyalloc
+{
+  yy_state_t yyss_alloc;
+  YYSTYPE yyvs_alloc;
+};
+
+/* The size of the maximum gap between one aligned stack and the next.  */
+# define YYSTACK_GAP_MAXIMUM (YYSIZEOF (union yyalloc) - 1)
+
+/* The size of an array large to enough to hold all stacks, each with
+   N elements.  */
+# define YYSTACK_BYTES(N) \
+     ((N) * (YYSIZEOF (yy_state_t) + YYSIZEOF (YYSTYPE)) \
+      + YYSTACK_GAP_MAXIMUM)
+
+# define YYCOPY_NEEDED 1
+
+/* Relocate STACK from its old location to the new one.  The
+   local variables YYSIZE and YYSTACKSIZE give the old and new number of
+   elements in the stack, and YYPTR gives the new location of the
+   stack.  Advance YYPTR to a properly aligned location for the next
+   stack.  */
+# define YYSTACK_RELOCATE(Stack_alloc, Stack)                           \
+    do                                                                  \
+      {                                                                 \
+        YYPTRDIFF_T yynewbytes;                                         \
+        YYCOPY (&yyptr->Stack_alloc, Stack, yysize);                    \
+        Stack = &yyptr->Stack_alloc;                                    \
+        yynewbytes = yystacksize * YYSIZEOF (*Stack) + YYSTACK_GAP_MAXIMUM; \
+        yyptr += yynewbytes / YYSIZEOF (*yyptr);                        \
+      }                                                                 \
+    while (0)
+
+#endif
+
+#if defined YYCOPY_NEEDED && YYCOPY_NEEDED
+/* Copy COUNT objects from SRC to DST.  The source and destination do
+   not overlap.  */
+# ifndef YYCOPY
+#  if defined __GNUC__ && 1 < __GNUC__
+#   define YYCOPY(Dst, Src, Count) \
+      __builtin_memcpy (Dst, Src, YY_CAST (YYSIZE_T, (Count)) * sizeof (*(Src)))
+#  else
+#   define YYCOPY(Dst, Src, Count)              \
+      do                                        \
+        {                                       \
+          YYPTRDIFF_T yyi;                      \
+          for (yyi = 0; yyi < (Count); yyi++)   \
+            (Dst)[yyi] = (Src)[yyi];            \
+        }                                       \
+      while (0)
+#  endif
+# endif
+#endif /* !YYCOPY_NEEDED */
+
+/* YYFINAL -- State number of the termination state.  */
+#define YYFINAL  3
+/* YYLAST -- Last index in YYTABLE.  */
+#define YYLAST   582
+
+/* YYNTOKENS -- Number of terminals.  */
+#define YYNTOKENS  56
+/* YYNNTS -- Number of nonterminals.  */
+#define YYNNTS  31
+/* YYNRULES -- Number of rules.  */
+#define YYNRULES  92
+/* YYNSTATES -- Number of states.  */
+#define YYNSTATES  189
+
+/* YYMAXUTOK -- Last valid token kind.  */
+#define YYMAXUTOK   292
+
+
+/* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex, with out-of-bounds checking.  */
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
+
+/* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex.  */
+static const yytype_int8 yytranslate[] =
+{
+       0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,    45,     2,     2,     2,    43,     2,     2,
+      49,    50,    41,    39,    51,    40,    46,    42,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,    37,    48,
+       2,    36,     2,    38,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,    52,     2,    53,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,    54,     2,    55,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
+       5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
+      15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
+      25,    26,    27,    28,    29,    30,    31,    32,    33,    34,
+      35,    44,    47
+};
+
+#if YYDEBUG
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+static const yytype_int16 yyrline[] =
+{
+       0,    69,    69,   112,   115,   119,   122,   126,   127,   128,
+     129,   130,   131,   132,   134,   148,   162,   173,   210,   218,
+     231,   236,   237,   239,   243,   247,   251,   255,   259,   263,
+     267,   271,   275,   279,   283,   287,   291,   295,   299,   303,
+     307,   311,   315,   319,   323,   324,   328,   332,   336,   341,
+     342,   343,   357,   373,   379,   387,   391,   396,   401,   408,
+     411,   417,   421,   425,   430,   435,   440,   441,   442,   443,
+     445,   446,   448,   453,   458,   462,   466,   470,   479,   483,
+     488,   494,   522,   550,   551,   553,   554,   556,   556,   563,
+     568,   569,   570
+};
+#endif
+
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if YYDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
+/* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
+   First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
+static const char *const yytname[] =
+{
+  "\"end of file\"", "error", "\"invalid token\"", "CASSIGN_ADD",
+  "CASSIGN_SUB", "CASSIGN_MULT", "CASSIGN_DIV", "CASSIGN_MOD", "COMP_EQU",
+  "COMP_NEQU", "COMP_LESS", "COMP_LTE", "COMP_GTR", "COMP_GTE", "BOOL_AND",
+  "BOOL_OR", "COMMAND_PRINT", "COMMAND_IF", "COMMAND_ELSE",
+  "COMMAND_WHILE", "COMMAND_FOR", "COMMAND_BREAK", "COMMAND_CONTINUE",
+  "COMMAND_RANDOM", "COMMAND_RETURN", "COMMAND_DEFINE", "COMMAND_DECLARE",
+  "COMMAND_SWITCH", "COMMAND_CASE", "COMMAND_DEFAULT", "VAL_LIT",
+  "CHAR_LIT", "STRING_LIT", "TYPE", "META_TYPE", "ID", "'='", "':'", "'?'",
+  "'+'", "'-'", "'*'", "'/'", "'%'", "UMINUS", "'!'", "'.'", "NOELSE",
+  "';'", "'('", "')'", "','", "'['", "']'", "'{'", "'}'", "$accept",
+  "program", "statement_list", "statement", "type_any", "var_declare",
+  "declare_assign", "var_usage", "array_index", "lhs_ok", "expression",
+  "argument_list", "argument", "command", "if_start", "while_start",
+  "for_init", "opt_expr", "for_start", "flow_command", "case_list",
+  "declare_start", "define_start", "fun_arg_list", "fun_arg_test",
+  "define_command", "$@1", "declare_command", "block_start", "block_end",
+  "code_block", YY_NULLPTR
+};
+
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
+{
+  return yytname[yysymbol];
+}
+#endif
+
+#define YYPACT_NINF (-44)
+
+#define yypact_value_is_default(Yyn) \
+  ((Yyn) == YYPACT_NINF)
+
+#define YYTABLE_NINF (-23)
+
+#define yytable_value_is_error(Yyn) \
+  ((Yyn) == YYTABLE_NINF)
+
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
+static const yytype_int16 yypact[] =
+{
+     -44,     9,   329,   -44,   -37,   -30,   -28,   -16,   -44,   -44,
+      -4,   530,    -3,    -3,    76,   -44,   -44,   -44,   -44,    84,
+      85,   530,   530,   -44,   530,   530,   -44,   -44,   -19,   -31,
+       8,    44,    19,   213,   256,    88,   368,   368,   368,   -44,
+     100,   111,   -44,   -44,   -44,   -44,   530,   530,   530,   494,
+     530,   434,   112,   128,   129,   530,   132,   500,   120,   120,
+     131,   434,   -33,   -44,   -44,   530,   -44,   -44,   530,   530,
+     530,   530,   530,   530,   530,   530,   530,   530,   530,   530,
+     530,   530,   530,   530,   530,   530,   530,   530,   530,   140,
+     -44,   -44,   149,   -44,   -44,     7,     7,   289,    -8,   144,
+     187,   142,   -44,   434,   141,   200,   143,   -44,   -44,   243,
+      28,   -44,    55,   -44,   530,   -44,   434,    73,   434,   434,
+     434,   434,   434,   434,    89,    89,    89,    89,    89,    89,
+     473,    81,   415,   -14,   -14,   120,   120,   120,   130,   368,
+     -44,   137,   153,   154,   -44,   -44,   -44,   -44,   -44,   530,
+     -44,   155,   126,   -44,   161,   -44,   -44,   -44,   530,   524,
+     -44,     7,   -44,   -44,   434,   145,   -44,   156,   434,   -44,
+      57,   -44,   368,   530,   -21,   157,   -44,   -44,   171,   530,
+     170,   -44,   -44,   -44,   425,   368,   368,   -44,   -44
+};
+
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
+static const yytype_int8 yydefact[] =
+{
+       3,     0,     2,     1,     0,     0,     0,     0,    61,    62,
+       0,     0,     0,     0,     0,    45,    46,    47,    14,     0,
+      19,     0,     0,    13,     0,     0,    90,     4,     0,     0,
+       0,    49,    50,     0,     0,     0,     0,     0,     0,    11,
+       0,     0,     5,     6,     3,    12,     0,     0,     0,    69,
+       0,    63,     0,     0,     0,     0,     0,     0,    42,    43,
+       0,    59,     0,    58,    16,     0,     7,     8,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       9,    10,    74,    75,    76,    86,    86,     0,     0,     0,
+       0,    66,    67,    68,     0,     0,     0,    82,    81,     0,
+       0,    51,     0,    44,     0,    48,    18,     0,    37,    38,
+      39,    40,    41,    36,    28,    29,    30,    31,    32,    33,
+      34,    35,     0,    23,    24,    25,    26,    27,     0,     0,
+      83,    85,     0,     0,    91,    92,    60,    64,    65,    71,
+      55,     0,     0,    15,     0,    52,    57,    20,     0,     0,
+      73,     0,    89,    87,    70,     0,    78,     0,    56,    53,
+       0,    84,     0,    71,     0,     0,    54,    88,     0,     0,
+       0,    77,    17,    72,     0,     0,     0,    80,    79
+};
+
+/* YYPGOTO[NTERM-NUM].  */
+static const yytype_int16 yypgoto[] =
+{
+     -44,   -44,   178,   -35,    97,   -43,   174,   -44,   -44,   -44,
+     -11,   -42,   110,   -44,   -44,   -44,   -44,    58,   -44,   -44,
+     -44,   -44,   -44,   -44,   136,   -44,   -44,   -44,    82,    61,
+     -44
+};
+
+/* YYDEFGOTO[NTERM-NUM].  */
+static const yytype_uint8 yydefgoto[] =
+{
+       0,     1,     2,    27,    28,    29,    30,    31,    32,    33,
+      34,    62,    63,    35,    36,    37,   104,   165,    38,    39,
+     174,    40,    41,   141,   142,    42,   172,    43,    44,   145,
+      45
+};
+
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
+static const yytype_int16 yytable[] =
+{
+      51,    92,    93,    94,    98,    65,   101,   179,   180,     3,
+      58,    59,    46,    60,    61,   112,    64,    66,   114,    47,
+     115,    48,   -22,   -22,   -22,   -22,   -22,    86,    87,    88,
+      18,    52,    89,    49,   144,    61,    99,   100,   103,   105,
+      18,    19,   146,   114,   109,    50,    61,   -21,   -21,   -21,
+     -21,   -21,   140,   140,   116,   -22,    67,   117,   118,   119,
+     120,   121,   122,   123,   124,   125,   126,   127,   128,   129,
+     130,   131,   132,   133,   134,   135,   136,   137,   153,   154,
+     -21,    75,    76,    77,    78,    79,    80,    81,    82,    75,
+      76,    77,    78,    79,    80,    81,    68,   -23,   -23,   -23,
+     -23,   -23,   -23,    61,   160,   155,   114,   176,   114,    53,
+      54,    83,    84,    85,    86,    87,    88,   170,   171,    89,
+      84,    85,    86,    87,    88,    55,   157,    89,    84,    85,
+      86,    87,    88,    56,    57,    89,    91,   177,   164,    75,
+      76,    77,    78,    79,    80,    81,    82,   168,    61,    95,
+     187,   188,    75,    76,    77,    78,    79,    80,    81,    82,
+      96,   106,   164,   107,   108,   110,    89,   139,   184,    83,
+      84,    85,    86,    87,    88,   138,   151,    89,    65,   159,
+      26,   113,    83,    84,    85,    86,    87,    88,   161,   149,
+      89,   167,   182,   173,   147,    75,    76,    77,    78,    79,
+      80,    81,    82,   162,   163,   153,   175,   185,    75,    76,
+      77,    78,    79,    80,    81,    82,    69,    70,    71,    72,
+      73,   183,    97,   102,   156,    83,    84,    85,    86,    87,
+      88,   178,   143,    89,   166,   181,     0,   148,    83,    84,
+      85,    86,    87,    88,     0,     0,    89,     0,     0,    74,
+     150,    75,    76,    77,    78,    79,    80,    81,    82,     0,
+       0,     0,     0,     0,    75,    76,    77,    78,    79,    80,
+      81,    82,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,    83,    84,    85,    86,    87,    88,     0,     0,    89,
+       0,     0,     0,   152,    83,    84,    85,    86,    87,    88,
+       0,     0,    89,     0,    90,     4,     5,     0,     6,     7,
+       8,     9,    10,    11,    12,    13,    14,     0,     0,    15,
+      16,    17,    18,    19,    20,     0,     0,     0,     0,    21,
+       0,     0,     0,     0,    22,     0,     0,    23,    24,     0,
+       0,    25,     0,    26,   144,     4,     5,     0,     6,     7,
+       8,     9,    10,    11,    12,    13,    14,     0,     0,    15,
+      16,    17,    18,    19,    20,     0,     0,     0,     0,    21,
+       0,     0,     0,     0,    22,     0,     0,    23,    24,     0,
+       0,    25,     0,    26,     4,     5,     0,     6,     7,     8,
+       9,    10,    11,     0,     0,    14,     0,     0,    15,    16,
+      17,    18,    19,    20,     0,     0,     0,     0,    21,     0,
+       0,     0,     0,    22,     0,     0,    23,    24,     0,     0,
+      25,     0,    26,    75,    76,    77,    78,    79,    80,    81,
+      82,     0,     0,    75,    76,    77,    78,    79,    80,    81,
+      82,     0,    75,    76,    77,    78,    79,    80,    81,    82,
+       0,     0,   158,    83,    84,    85,    86,    87,    88,     0,
+       0,    89,   186,    83,    84,    85,    86,    87,    88,     0,
+       0,    89,    83,    84,    85,    86,    87,    88,     0,     0,
+      89,    75,    76,    77,    78,    79,    80,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,    84,    85,    86,    87,    88,    10,     0,    89,
+       0,     0,     0,    10,    15,    16,    17,    18,    19,    20,
+      15,    16,    17,     0,    21,    20,     0,     0,     0,    22,
+      21,     0,     0,    24,     0,    22,    25,    10,     0,    24,
+     111,     0,    25,    10,    15,    16,    17,     0,     0,    20,
+      15,    16,    17,     0,    21,    20,     0,     0,     0,    22,
+      21,     0,     0,    24,   169,    22,    25,     0,     0,    24,
+       0,     0,    25
+};
+
+static const yytype_int16 yycheck[] =
+{
+      11,    36,    37,    38,    46,    36,    49,    28,    29,     0,
+      21,    22,    49,    24,    25,    57,    35,    48,    51,    49,
+      53,    49,     3,     4,     5,     6,     7,    41,    42,    43,
+      33,    34,    46,    49,    55,    46,    47,    48,    49,    50,
+      33,    34,    50,    51,    55,    49,    57,     3,     4,     5,
+       6,     7,    95,    96,    65,    36,    48,    68,    69,    70,
+      71,    72,    73,    74,    75,    76,    77,    78,    79,    80,
+      81,    82,    83,    84,    85,    86,    87,    88,    50,    51,
+      36,     8,     9,    10,    11,    12,    13,    14,    15,     8,
+       9,    10,    11,    12,    13,    14,    52,     8,     9,    10,
+      11,    12,    13,   114,   139,    50,    51,    50,    51,    12,
+      13,    38,    39,    40,    41,    42,    43,   159,   161,    46,
+      39,    40,    41,    42,    43,    49,    53,    46,    39,    40,
+      41,    42,    43,    49,    49,    46,    48,   172,   149,     8,
+       9,    10,    11,    12,    13,    14,    15,   158,   159,    49,
+     185,   186,     8,     9,    10,    11,    12,    13,    14,    15,
+      49,    49,   173,    35,    35,    33,    46,    18,   179,    38,
+      39,    40,    41,    42,    43,    35,    33,    46,    36,    49,
+      54,    50,    38,    39,    40,    41,    42,    43,    51,    48,
+      46,    30,    35,    48,    50,     8,     9,    10,    11,    12,
+      13,    14,    15,    50,    50,    50,    50,    37,     8,     9,
+      10,    11,    12,    13,    14,    15,     3,     4,     5,     6,
+       7,    50,    44,    49,   114,    38,    39,    40,    41,    42,
+      43,   173,    96,    46,   152,   174,    -1,    50,    38,    39,
+      40,    41,    42,    43,    -1,    -1,    46,    -1,    -1,    36,
+      50,     8,     9,    10,    11,    12,    13,    14,    15,    -1,
+      -1,    -1,    -1,    -1,     8,     9,    10,    11,    12,    13,
+      14,    15,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    38,    39,    40,    41,    42,    43,    -1,    -1,    46,
+      -1,    -1,    -1,    50,    38,    39,    40,    41,    42,    43,
+      -1,    -1,    46,    -1,    48,    16,    17,    -1,    19,    20,
+      21,    22,    23,    24,    25,    26,    27,    -1,    -1,    30,
+      31,    32,    33,    34,    35,    -1,    -1,    -1,    -1,    40,
+      -1,    -1,    -1,    -1,    45,    -1,    -1,    48,    49,    -1,
+      -1,    52,    -1,    54,    55,    16,    17,    -1,    19,    20,
+      21,    22,    23,    24,    25,    26,    27,    -1,    -1,    30,
+      31,    32,    33,    34,    35,    -1,    -1,    -1,    -1,    40,
+      -1,    -1,    -1,    -1,    45,    -1,    -1,    48,    49,    -1,
+      -1,    52,    -1,    54,    16,    17,    -1,    19,    20,    21,
+      22,    23,    24,    -1,    -1,    27,    -1,    -1,    30,    31,
+      32,    33,    34,    35,    -1,    -1,    -1,    -1,    40,    -1,
+      -1,    -1,    -1,    45,    -1,    -1,    48,    49,    -1,    -1,
+      52,    -1,    54,     8,     9,    10,    11,    12,    13,    14,
+      15,    -1,    -1,     8,     9,    10,    11,    12,    13,    14,
+      15,    -1,     8,     9,    10,    11,    12,    13,    14,    15,
+      -1,    -1,    37,    38,    39,    40,    41,    42,    43,    -1,
+      -1,    46,    37,    38,    39,    40,    41,    42,    43,    -1,
+      -1,    46,    38,    39,    40,    41,    42,    43,    -1,    -1,
+      46,     8,     9,    10,    11,    12,    13,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    39,    40,    41,    42,    43,    23,    -1,    46,
+      -1,    -1,    -1,    23,    30,    31,    32,    33,    34,    35,
+      30,    31,    32,    -1,    40,    35,    -1,    -1,    -1,    45,
+      40,    -1,    -1,    49,    -1,    45,    52,    23,    -1,    49,
+      50,    -1,    52,    23,    30,    31,    32,    -1,    -1,    35,
+      30,    31,    32,    -1,    40,    35,    -1,    -1,    -1,    45,
+      40,    -1,    -1,    49,    50,    45,    52,    -1,    -1,    49,
+      -1,    -1,    52
+};
+
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
+static const yytype_int8 yystos[] =
+{
+       0,    57,    58,     0,    16,    17,    19,    20,    21,    22,
+      23,    24,    25,    26,    27,    30,    31,    32,    33,    34,
+      35,    40,    45,    48,    49,    52,    54,    59,    60,    61,
+      62,    63,    64,    65,    66,    69,    70,    71,    74,    75,
+      77,    78,    81,    83,    84,    86,    49,    49,    49,    49,
+      49,    66,    34,    60,    60,    49,    49,    49,    66,    66,
+      66,    66,    67,    68,    35,    36,    48,    48,    52,     3,
+       4,     5,     6,     7,    36,     8,     9,    10,    11,    12,
+      13,    14,    15,    38,    39,    40,    41,    42,    43,    46,
+      48,    48,    59,    59,    59,    49,    49,    58,    67,    66,
+      66,    61,    62,    66,    72,    66,    49,    35,    35,    66,
+      33,    50,    67,    50,    51,    53,    66,    66,    66,    66,
+      66,    66,    66,    66,    66,    66,    66,    66,    66,    66,
+      66,    66,    66,    66,    66,    66,    66,    66,    35,    18,
+      61,    79,    80,    80,    55,    85,    50,    50,    50,    48,
+      50,    33,    50,    50,    51,    50,    68,    53,    37,    49,
+      59,    51,    50,    50,    66,    73,    84,    30,    66,    50,
+      67,    61,    82,    48,    76,    50,    50,    59,    73,    28,
+      29,    85,    35,    50,    66,    37,    37,    59,    59
+};
+
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr1[] =
+{
+       0,    56,    57,    58,    58,    58,    58,    59,    59,    59,
+      59,    59,    59,    59,    60,    60,    61,    61,    62,    63,
+      64,    65,    65,    66,    66,    66,    66,    66,    66,    66,
+      66,    66,    66,    66,    66,    66,    66,    66,    66,    66,
+      66,    66,    66,    66,    66,    66,    66,    66,    66,    66,
+      66,    66,    66,    66,    66,    66,    66,    67,    67,    68,
+      69,    69,    69,    69,    70,    71,    72,    72,    72,    72,
+      73,    73,    74,    75,    75,    75,    75,    75,    76,    76,
+      76,    77,    78,    79,    79,    80,    80,    82,    81,    83,
+      84,    85,    86
+};
+
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr2[] =
+{
+       0,     2,     1,     0,     2,     2,     2,     2,     2,     2,
+       2,     1,     1,     1,     1,     4,     2,     7,     3,     1,
+       4,     1,     1,     3,     3,     3,     3,     3,     3,     3,
+       3,     3,     3,     3,     3,     3,     3,     3,     3,     3,
+       3,     3,     2,     2,     3,     1,     1,     1,     3,     1,
+       1,     3,     4,     5,     6,     4,     5,     3,     1,     1,
+       4,     1,     1,     2,     4,     4,     1,     1,     1,     0,
+       1,     0,     8,     4,     2,     2,     2,     7,     0,     5,
+       4,     3,     3,     1,     3,     1,     0,     0,     6,     4,
+       1,     1,     3
+};
+
+
+enum { YYENOMEM = -2 };
+
+#define yyerrok         (yyerrstatus = 0)
+#define yyclearin       (yychar = YYEMPTY)
+
+#define YYACCEPT        goto yyacceptlab
+#define YYABORT         goto yyabortlab
+#define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
+
+
+#define YYRECOVERING()  (!!yyerrstatus)
+
+#define YYBACKUP(Token, Value)                                    \
+  do                                                              \
+    if (yychar == YYEMPTY)                                        \
+      {                                                           \
+        yychar = (Token);                                         \
+        yylval = (Value);                                         \
+        YYPOPSTACK (yylen);                                       \
+        yystate = *yyssp;                                         \
+        goto yybackup;                                            \
+      }                                                           \
+    else                                                          \
+      {                                                           \
+        yyerror (YY_("syntax error: cannot back up")); \
+        YYERROR;                                                  \
+      }                                                           \
+  while (0)
+
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
+
+
+/* Enable debugging if requested.  */
+#if YYDEBUG
+
+# ifndef YYFPRINTF
+#  include <stdio.h> /* INFRINGES ON USER NAME SPACE */
+#  define YYFPRINTF fprintf
+# endif
+
+# define YYDPRINTF(Args)                        \
+do {                                            \
+  if (yydebug)                                  \
+    YYFPRINTF Args;                             \
+} while (0)
+
+
+
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
+do {                                                                      \
+  if (yydebug)                                                            \
+    {                                                                     \
+      YYFPRINTF (stderr, "%s ", Title);                                   \
+      yy_symbol_print (stderr,                                            \
+                  Kind, Value); \
+      YYFPRINTF (stderr, "\n");                                           \
+    }                                                                     \
+} while (0)
+
+
+/*-----------------------------------.
+| Print this symbol's value on YYO.  |
+`-----------------------------------*/
+
+static void
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
+{
+  FILE *yyoutput = yyo;
+  YY_USE (yyoutput);
+  if (!yyvaluep)
+    return;
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+}
+
+
+/*---------------------------.
+| Print this symbol on YYO.  |
+`---------------------------*/
+
+static void
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
+{
+  YYFPRINTF (yyo, "%s %s (",
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
+
+  yy_symbol_value_print (yyo, yykind, yyvaluep);
+  YYFPRINTF (yyo, ")");
+}
+
+/*------------------------------------------------------------------.
+| yy_stack_print -- Print the state stack from its BOTTOM up to its |
+| TOP (included).                                                   |
+`------------------------------------------------------------------*/
+
+static void
+yy_stack_print (yy_state_t *yybottom, yy_state_t *yytop)
+{
+  YYFPRINTF (stderr, "Stack now");
+  for (; yybottom <= yytop; yybottom++)
+    {
+      int yybot = *yybottom;
+      YYFPRINTF (stderr, " %d", yybot);
+    }
+  YYFPRINTF (stderr, "\n");
+}
+
+# define YY_STACK_PRINT(Bottom, Top)                            \
+do {                                                            \
+  if (yydebug)                                                  \
+    yy_stack_print ((Bottom), (Top));                           \
+} while (0)
+
+
+/*------------------------------------------------.
+| Report that the YYRULE is going to be reduced.  |
+`------------------------------------------------*/
+
+static void
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule)
+{
+  int yylno = yyrline[yyrule];
+  int yynrhs = yyr2[yyrule];
+  int yyi;
+  YYFPRINTF (stderr, "Reducing stack by rule %d (line %d):\n",
+             yyrule - 1, yylno);
+  /* The symbols being reduced.  */
+  for (yyi = 0; yyi < yynrhs; yyi++)
+    {
+      YYFPRINTF (stderr, "   $%d = ", yyi + 1);
+      yy_symbol_print (stderr,
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)]);
+      YYFPRINTF (stderr, "\n");
+    }
+}
+
+# define YY_REDUCE_PRINT(Rule)          \
+do {                                    \
+  if (yydebug)                          \
+    yy_reduce_print (yyssp, yyvsp, Rule); \
+} while (0)
+
+/* Nonzero means print parse trace.  It is left uninitialized so that
+   multiple parsers can coexist.  */
+int yydebug;
+#else /* !YYDEBUG */
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
+# define YY_STACK_PRINT(Bottom, Top)
+# define YY_REDUCE_PRINT(Rule)
+#endif /* !YYDEBUG */
+
+
+/* YYINITDEPTH -- initial size of the parser's stacks.  */
+#ifndef YYINITDEPTH
+# define YYINITDEPTH 200
+#endif
+
+/* YYMAXDEPTH -- maximum size the stacks can grow to (effective only
+   if the built-in stack extension method is used).
+
+   Do not make this value too large; the results are undefined if
+   YYSTACK_ALLOC_MAXIMUM < YYSTACK_BYTES (YYMAXDEPTH)
+   evaluated with infinite-precision integer arithmetic.  */
+
+#ifndef YYMAXDEPTH
+# define YYMAXDEPTH 10000
+#endif
+
+
+
+
+
+
+/*-----------------------------------------------.
+| Release the memory associated to this symbol.  |
+`-----------------------------------------------*/
+
+static void
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep)
+{
+  YY_USE (yyvaluep);
+  if (!yymsg)
+    yymsg = "Deleting";
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
+
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+}
+
+
+/* Lookahead token kind.  */
+int yychar;
+
+/* The semantic value of the lookahead symbol.  */
+YYSTYPE yylval;
+/* Number of syntax errors so far.  */
+int yynerrs;
+
+
+
+
+/*----------.
+| yyparse.  |
+`----------*/
+
+int
+yyparse (void)
+{
+    yy_state_fast_t yystate = 0;
+    /* Number of tokens to shift before error messages enabled.  */
+    int yyerrstatus = 0;
+
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
+       to reallocate them elsewhere.  */
+
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
+
+    /* The state stack: array, bottom, top.  */
+    yy_state_t yyssa[YYINITDEPTH];
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
+
+    /* The semantic value stack: array, bottom, top.  */
+    YYSTYPE yyvsa[YYINITDEPTH];
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
+
+  int yyn;
+  /* The return value of yyparse.  */
+  int yyresult;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
+  /* The variables used to return semantic value and location from the
+     action routines.  */
+  YYSTYPE yyval;
+
+
+
+#define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
+
+  /* The number of symbols on the RHS of the reduced rule.
+     Keep to zero when no symbol should be popped.  */
+  int yylen = 0;
+
+  YYDPRINTF ((stderr, "Starting parse\n"));
+
+  yychar = YYEMPTY; /* Cause a token to be read.  */
+
+  goto yysetstate;
+
+
+/*------------------------------------------------------------.
+| yynewstate -- push a new state, which is found in yystate.  |
+`------------------------------------------------------------*/
+yynewstate:
+  /* In all cases, when you get here, the value and location stacks
+     have just been pushed.  So pushing a state here evens the stacks.  */
+  yyssp++;
+
+
+/*--------------------------------------------------------------------.
+| yysetstate -- set current state (the top of the stack) to yystate.  |
+`--------------------------------------------------------------------*/
+yysetstate:
+  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
+  YY_ASSERT (0 <= yystate && yystate < YYNSTATES);
+  YY_IGNORE_USELESS_CAST_BEGIN
+  *yyssp = YY_CAST (yy_state_t, yystate);
+  YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
+
+  if (yyss + yystacksize - 1 <= yyssp)
+#if !defined yyoverflow && !defined YYSTACK_RELOCATE
+    YYNOMEM;
+#else
+    {
+      /* Get the current used size of the three stacks, in elements.  */
+      YYPTRDIFF_T yysize = yyssp - yyss + 1;
+
+# if defined yyoverflow
+      {
+        /* Give user a chance to reallocate the stack.  Use copies of
+           these so that the &'s don't force the real ones into
+           memory.  */
+        yy_state_t *yyss1 = yyss;
+        YYSTYPE *yyvs1 = yyvs;
+
+        /* Each stack pointer address is followed by the size of the
+           data in use in that stack, in bytes.  This used to be a
+           conditional around just the two extra args, but that might
+           be undefined if yyoverflow is a macro.  */
+        yyoverflow (YY_("memory exhausted"),
+                    &yyss1, yysize * YYSIZEOF (*yyssp),
+                    &yyvs1, yysize * YYSIZEOF (*yyvsp),
+                    &yystacksize);
+        yyss = yyss1;
+        yyvs = yyvs1;
+      }
+# else /* defined YYSTACK_RELOCATE */
+      /* Extend the stack our own way.  */
+      if (YYMAXDEPTH <= yystacksize)
+        YYNOMEM;
+      yystacksize *= 2;
+      if (YYMAXDEPTH < yystacksize)
+        yystacksize = YYMAXDEPTH;
+
+      {
+        yy_state_t *yyss1 = yyss;
+        union yyalloc *yyptr =
+          YY_CAST (union yyalloc *,
+                   YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
+        if (! yyptr)
+          YYNOMEM;
+        YYSTACK_RELOCATE (yyss_alloc, yyss);
+        YYSTACK_RELOCATE (yyvs_alloc, yyvs);
+#  undef YYSTACK_RELOCATE
+        if (yyss1 != yyssa)
+          YYSTACK_FREE (yyss1);
+      }
+# endif
+
+      yyssp = yyss + yysize - 1;
+      yyvsp = yyvs + yysize - 1;
+
+      YY_IGNORE_USELESS_CAST_BEGIN
+      YYDPRINTF ((stderr, "Stack size increased to %ld\n",
+                  YY_CAST (long, yystacksize)));
+      YY_IGNORE_USELESS_CAST_END
+
+      if (yyss + yystacksize - 1 <= yyssp)
+        YYABORT;
+    }
+#endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
+
+
+  if (yystate == YYFINAL)
+    YYACCEPT;
+
+  goto yybackup;
+
+
+/*-----------.
+| yybackup.  |
+`-----------*/
+yybackup:
+  /* Do appropriate processing given the current state.  Read a
+     lookahead token if we need one and don't already have one.  */
+
+  /* First try to decide what to do without reference to lookahead token.  */
+  yyn = yypact[yystate];
+  if (yypact_value_is_default (yyn))
+    goto yydefault;
+
+  /* Not known => get a lookahead token if don't already have one.  */
+
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
+  if (yychar == YYEMPTY)
+    {
+      YYDPRINTF ((stderr, "Reading a token\n"));
+      yychar = yylex ();
+    }
+
+  if (yychar <= YYEOF)
+    {
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
+      YYDPRINTF ((stderr, "Now at end of input.\n"));
+    }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
+  else
+    {
+      yytoken = YYTRANSLATE (yychar);
+      YY_SYMBOL_PRINT ("Next token is", yytoken, &yylval, &yylloc);
+    }
+
+  /* If the proper action on seeing token YYTOKEN is to reduce or to
+     detect an error, take that action.  */
+  yyn += yytoken;
+  if (yyn < 0 || YYLAST < yyn || yycheck[yyn] != yytoken)
+    goto yydefault;
+  yyn = yytable[yyn];
+  if (yyn <= 0)
+    {
+      if (yytable_value_is_error (yyn))
+        goto yyerrlab;
+      yyn = -yyn;
+      goto yyreduce;
+    }
+
+  /* Count tokens shifted since error; after three, turn off error
+     status.  */
+  if (yyerrstatus)
+    yyerrstatus--;
+
+  /* Shift the lookahead token.  */
+  YY_SYMBOL_PRINT ("Shifting", yytoken, &yylval, &yylloc);
+  yystate = yyn;
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+
+  /* Discard the shifted token.  */
+  yychar = YYEMPTY;
+  goto yynewstate;
+
+
+/*-----------------------------------------------------------.
+| yydefault -- do the default action for the current state.  |
+`-----------------------------------------------------------*/
+yydefault:
+  yyn = yydefact[yystate];
+  if (yyn == 0)
+    goto yyerrlab;
+  goto yyreduce;
+
+
+/*-----------------------------.
+| yyreduce -- do a reduction.  |
+`-----------------------------*/
+yyreduce:
+  /* yyn is the number of a rule to reduce with.  */
+  yylen = yyr2[yyn];
+
+  /* If YYLEN is nonzero, implement the default value of the action:
+     '$$ = $1'.
+
+     Otherwise, the following line sets YYVAL to garbage.
+     This behavior is undocumented and Bison
+     users should not rely upon it.  Assigning to YYVAL
+     unconditionally makes the parser a bit smaller, and it avoids a
+     GCC warning that YYVAL may be used uninitialized.  */
+  yyval = yyvsp[1-yylen];
+
+
+  YY_REDUCE_PRINT (yyn);
+  switch (yyn)
+    {
+  case 2: /* program: statement_list  */
+#line 69 "tube8.y"
+                             {
+                // This rule should be the final one to trigger.
+
+                IC_Array ic_array;  // Intermediate code container
+
+                // Find the functions the program uses and what each one does, before
+                // compiling any calls to them.
+                symbol_table.AnalyzeEffects((yyvsp[0].ast_node));
+
+                // Traverse the AST, filling ic_array with code
+                (yyvsp[0].ast_node)->CompileTubeIC(symbol_table, ic_array);
+
+                // Generate function code from the symbol table
+                symbol_table.CompileTubeIC(ic_array);
+
+                // Fill in the string literals the code uses before anything else runs.
+                ic_array.AddLiteralPool();
+
+                ic_array.AddBlock();
+                ic_array.AddLocal();
+                ic_array.AlgebraicOpt();
+                ic_array.AlgebraicOpt();
+
+                // Open the specified output file
+                std::ofstream out_file(out_filename.c_str()); 
+
+                // Determine the proper output format.
+                if (use_int_code == true) {
+                  ic_array.PrintIC(out_file);        // Write Intermediate Code
+                } else {
+                  ic_array.PrintTubeCode(out_file);  // Write TubeCode Assembly
+                }
+
+                // Estimate the cycles the TubeCode would use, if requested.
+                if (cost_report == true) {
+                  if (use_int_code == true) {
+                    std::stringstream tube_code;
+                    ic_array.PrintTubeCode(tube_code);
+                  }
+                  ic_array.PrintCostReport(std::cout);
+                }
+              }
+#line 1430 "tube8-parser.tab.cc"
+    break;
+
+  case 3: /* statement_list: %empty  */
+#line 112 "tube8.y"
+                 {
+	           (yyval.ast_node) = new ASTNode_Root;
+                 }
+#line 1438 "tube8-parser.tab.cc"
+    break;
+
+  case 4: /* statement_list: statement_list statement  */
+#line 115 "tube8.y"
+                                          {
+                   if ((yyvsp[0].ast_node) != NULL) (yyvsp[-1].ast_node)->AddChild((yyvsp[0].ast_node));
+                   (yyval.ast_node) = (yyvsp[-1].ast_node);
+		 }
+#line 1447 "tube8-parser.tab.cc"
+    break;
+
+  case 5: /* statement_list: statement_list define_command  */
+#line 119 "tube8.y"
+                                               {
+                   (yyval.ast_node) = (yyvsp[-1].ast_node);
+		 }
+#line 1455 "tube8-parser.tab.cc"
+    break;
+
+  case 6: /* statement_list: statement_list declare_command  */
+#line 122 "tube8.y"
+                                          {
+                   (yyval.ast_node) = (yyvsp[-1].ast_node);
+  }
+#line 1463 "tube8-parser.tab.cc"
+    break;
+
+  case 7: /* statement: var_declare ';'  */
+#line 126 "tube8.y"
+                                {  (yyval.ast_node) = NULL; /* Only update symbol table */ }
+#line 1469 "tube8-parser.tab.cc"
+    break;
+
+  case 8: /* statement: declare_assign ';'  */
+#line 127 "tube8.y"
+                                {  (yyval.ast_node) = (yyvsp[-1].ast_node);  }
+#line 1475 "tube8-parser.tab.cc"
+    break;
+
+  case 9: /* statement: expression ';'  */
+#line 128 "tube8.y"
+                                {  (yyval.ast_node) = (yyvsp[-1].ast_node);  }
+#line 1481 "tube8-parser.tab.cc"
+    break;
+
+  case 10: /* statement: command ';'  */
+#line 129 "tube8.y"
+                                {  (yyval.ast_node) = (yyvsp[-1].ast_node);  }
+#line 1487 "tube8-parser.tab.cc"
+    break;
+
+  case 11: /* statement: flow_command  */
+#line 130 "tube8.y"
+                                {  (yyval.ast_node) = (yyvsp[0].ast_node);  }
+#line 1493 "tube8-parser.tab.cc"
+    break;
+
+  case 12: /* statement: code_block  */
+#line 131 "tube8.y"
+                                {  (yyval.ast_node) = (yyvsp[0].ast_node);  }
+#line 1499 "tube8-parser.tab.cc"
+    break;
+
+  case 13: /* statement: ';'  */
+#line 132 "tube8.y"
+                                {  (yyval.ast_node) = NULL; /* No statement to include */ }
+#line 1505 "tube8-parser.tab.cc"
+    break;
+
+  case 14: /* type_any: TYPE  */
+#line 134 "tube8.y"
+                     {
+		  std::string type_name = (yyvsp[0].lexeme);
+		  int type_id = 0;
+		  if (type_name == "val") type_id = Type::VALUE;
+		  else if (type_name == "char") type_id = Type::CHAR;
+		  else if (type_name == "string") type_id = Type::STRING;
+		  else {
+		    std::string err_string = "unknown type '";
+		    err_string += (yyvsp[0].lexeme);
+                    err_string += "'";
+		    yyerror(err_string);
+		  }
+                  (yyval.value) = type_id;
+                }
+#line 1524 "tube8-parser.tab.cc"
+    break;
+
+  case 15: /* type_any: META_TYPE '(' TYPE ')'  */
+#line 148 "tube8.y"
+                                       {
+		  std::string type_name = (yyvsp[-1].lexeme);
+		  int type_id = 0;
+		  if (type_name == "val") type_id = Type::VALUE_ARRAY;
+		  else if (type_name == "char") type_id = Type::STRING;
+		  else {
+		    std::string err_string = "unknown type 'array(";
+		    err_string += (yyvsp[-1].lexeme);
+                    err_string += ")'";
+		    yyerror(err_string);
+		  }
+                  (yyval.value) = type_id;
+                }
+#line 1542 "tube8-parser.tab.cc"
+    break;
+
+  case 16: /* var_declare: type_any ID  */
+#line 162 "tube8.y"
+                            {
+	          if (symbol_table.InCurScope((yyvsp[0].lexeme)) == true) {
+		    std::string err_string = "redeclaration of variable '";
+		    err_string += (yyvsp[0].lexeme);
+                    err_string += "'";
+                    yyerror(err_string);
+		    exit(1);
+                  }
+
+                  (yyval.symbol_table_entry) = symbol_table.AddEntry((yyvsp[-1].value), (yyvsp[0].lexeme));
+	        }
+#line 1558 "tube8-parser.tab.cc"
+    break;
+
+  case 17: /* var_declare: META_TYPE '(' TYPE ',' VAL_LIT ')' ID  */
+#line 173 "tube8.y"
+                                                      {
+		  std::string type_name = (yyvsp[-4].lexeme);
+		  if (type_name != "val") {
+		    std::string err_string = "unknown type 'array(";
+		    err_string += (yyvsp[-4].lexeme);
+                    err_string += ", N)'";
+		    yyerror(err_string);
+		    exit(1);
+		  }
+	          if (symbol_table.InCurScope((yyvsp[0].lexeme)) == true) {
+		    std::string err_string = "redeclaration of variable '";
+		    err_string += (yyvsp[0].lexeme);
+                    err_string += "'";
+                    yyerror(err_string);
+		    exit(1);
+                  }
+                  // The elements have fixed memory cells, so each call can't get its own.
+                  if (symbol_table.GetCurFunction() != NULL) {
+                    yyerror("fixed-size arrays cannot be declared inside functions");
+                    exit(1);
+                  }
+                  double size = std::stod((yyvsp[-2].lexeme));
+                  if (size < 1 || size != std::floor(size)) {
+                    yyerror("size of a fixed-size array must be a whole number of at least 1");
+                    exit(1);
+                  }
+
+                  (yyval.symbol_table_entry) = symbol_table.AddFixedArray((yyvsp[0].lexeme), (int) std::min(size, 10000.0));
+                  if ((yyval.symbol_table_entry) == NULL) {
+		    std::string err_string = "fixed-size array '";
+		    err_string += (yyvsp[0].lexeme);
+                    err_string += "' does not fit in static memory";
+                    yyerror(err_string);
+		    exit(1);
+                  }
+	        }
+#line 1599 "tube8-parser.tab.cc"
+    break;
+
+  case 18: /* declare_assign: var_declare '=' expression  */
+#line 210 "tube8.y"
+                                            {
+                   ASTNode_Variable * var_node = new ASTNode_Variable((yyvsp[-2].symbol_table_entry));
+                   var_node->SetLineNum(line_num);
+
+	           (yyval.ast_node) = new ASTNode_Assign(var_node, (yyvsp[0].ast_node));
+                   (yyval.ast_node)->SetLineNum(line_num);
+	         }
+#line 1611 "tube8-parser.tab.cc"
+    break;
+
+  case 19: /* var_usage: ID  */
+#line 218 "tube8.y"
+                {
+	       tableEntry * cur_entry = symbol_table.Lookup((yyvsp[0].lexeme));
+               if (cur_entry == NULL) {
+		 std::string err_string = "unknown variable '";
+		 err_string += (yyvsp[0].lexeme);
+                 err_string += "'";
+		 yyerror(err_string);
+                 exit(1);
+               }
+	       (yyval.ast_node) = new ASTNode_Variable(cur_entry);
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1628 "tube8-parser.tab.cc"
+    break;
+
+  case 20: /* array_index: var_usage '[' expression ']'  */
+#line 231 "tube8.y"
+                                          {
+               (yyval.ast_node) = new ASTNode_ArrayAccess((yyvsp[-3].ast_node), (yyvsp[-1].ast_node));
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1637 "tube8-parser.tab.cc"
+    break;
+
+  case 21: /* lhs_ok: var_usage  */
+#line 236 "tube8.y"
+                   { (yyval.ast_node) = (yyvsp[0].ast_node); }
+#line 1643 "tube8-parser.tab.cc"
+    break;
+
+  case 22: /* lhs_ok: array_index  */
+#line 237 "tube8.y"
+                     { (yyval.ast_node) = (yyvsp[0].ast_node); }
+#line 1649 "tube8-parser.tab.cc"
+    break;
+
+  case 23: /* expression: expression '+' expression  */
+#line 239 "tube8.y"
+                                       { 
+	       (yyval.ast_node) = new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), '+');
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1658 "tube8-parser.tab.cc"
+    break;
+
+  case 24: /* expression: expression '-' expression  */
+#line 243 "tube8.y"
+                                       {
+	       (yyval.ast_node) = new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), '-');
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1667 "tube8-parser.tab.cc"
+    break;
+
+  case 25: /* expression: expression '*' expression  */
+#line 247 "tube8.y"
+                                       {
+	       (yyval.ast_node) = new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), '*');
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1676 "tube8-parser.tab.cc"
+    break;
+
+  case 26: /* expression: expression '/' expression  */
+#line 251 "tube8.y"
+                                       {
+	       (yyval.ast_node) = new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), '/');
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1685 "tube8-parser.tab.cc"
+    break;
+
+  case 27: /* expression: expression '%' expression  */
+#line 255 "tube8.y"
+                                       {
+	       (yyval.ast_node) = new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), '%');
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1694 "tube8-parser.tab.cc"
+    break;
+
+  case 28: /* expression: expression COMP_EQU expression  */
+#line 259 "tube8.y"
+                                            {
+               (yyval.ast_node) = new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), COMP_EQU);
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1703 "tube8-parser.tab.cc"
+    break;
+
+  case 29: /* expression: expression COMP_NEQU expression  */
+#line 263 "tube8.y"
+                                             {
+               (yyval.ast_node) = new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), COMP_NEQU);
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1712 "tube8-parser.tab.cc"
+    break;
+
+  case 30: /* expression: expression COMP_LESS expression  */
+#line 267 "tube8.y"
+                                             {
+               (yyval.ast_node) = new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), COMP_LESS);
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1721 "tube8-parser.tab.cc"
+    break;
+
+  case 31: /* expression: expression COMP_LTE expression  */
+#line 271 "tube8.y"
+                                            {
+               (yyval.ast_node) = new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), COMP_LTE);
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1730 "tube8-parser.tab.cc"
+    break;
+
+  case 32: /* expression: expression COMP_GTR expression  */
+#line 275 "tube8.y"
+                                            {
+               (yyval.ast_node) = new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), COMP_GTR);
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1739 "tube8-parser.tab.cc"
+    break;
+
+  case 33: /* expression: expression COMP_GTE expression  */
+#line 279 "tube8.y"
+                                            {
+               (yyval.ast_node) = new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), COMP_GTE);
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1748 "tube8-parser.tab.cc"
+    break;
+
+  case 34: /* expression: expression BOOL_AND expression  */
+#line 283 "tube8.y"
+                                            {
+               (yyval.ast_node) = new ASTNode_Bool2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), '&');
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1757 "tube8-parser.tab.cc"
+    break;
+
+  case 35: /* expression: expression BOOL_OR expression  */
+#line 287 "tube8.y"
+                                           {
+               (yyval.ast_node) = new ASTNode_Bool2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), '|');
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1766 "tube8-parser.tab.cc"
+    break;
+
+  case 36: /* expression: lhs_ok '=' expression  */
+#line 291 "tube8.y"
+                                   {
+               (yyval.ast_node) = new ASTNode_Assign((yyvsp[-2].ast_node), (yyvsp[0].ast_node));
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1775 "tube8-parser.tab.cc"
+    break;
+
+  case 37: /* expression: lhs_ok CASSIGN_ADD expression  */
+#line 295 "tube8.y"
+                                           {
+               (yyval.ast_node) = new ASTNode_Assign((yyvsp[-2].ast_node), new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), '+') );
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1784 "tube8-parser.tab.cc"
+    break;
+
+  case 38: /* expression: lhs_ok CASSIGN_SUB expression  */
+#line 299 "tube8.y"
+                                           {
+               (yyval.ast_node) = new ASTNode_Assign((yyvsp[-2].ast_node), new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), '-') );
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1793 "tube8-parser.tab.cc"
+    break;
+
+  case 39: /* expression: lhs_ok CASSIGN_MULT expression  */
+#line 303 "tube8.y"
+                                            {
+               (yyval.ast_node) = new ASTNode_Assign((yyvsp[-2].ast_node), new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), '*') );
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1802 "tube8-parser.tab.cc"
+    break;
+
+  case 40: /* expression: lhs_ok CASSIGN_DIV expression  */
+#line 307 "tube8.y"
+                                           {
+               (yyval.ast_node) = new ASTNode_Assign((yyvsp[-2].ast_node), new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), '/') );
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1811 "tube8-parser.tab.cc"
+    break;
+
+  case 41: /* expression: lhs_ok CASSIGN_MOD expression  */
+#line 311 "tube8.y"
+                                           {
+               (yyval.ast_node) = new ASTNode_Assign((yyvsp[-2].ast_node), new ASTNode_Math2((yyvsp[-2].ast_node), (yyvsp[0].ast_node), '%') );
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1820 "tube8-parser.tab.cc"
+    break;
+
+  case 42: /* expression: '-' expression  */
+#line 315 "tube8.y"
+                                         {
+               (yyval.ast_node) = new ASTNode_Math1((yyvsp[0].ast_node), '-');
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1829 "tube8-parser.tab.cc"
+    break;
+
+  case 43: /* expression: '!' expression  */
+#line 319 "tube8.y"
+                                         {
+               (yyval.ast_node) = new ASTNode_Math1((yyvsp[0].ast_node), '!');
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1838 "tube8-parser.tab.cc"
+    break;
+
+  case 44: /* expression: '(' expression ')'  */
+#line 323 "tube8.y"
+                                { (yyval.ast_node) = (yyvsp[-1].ast_node); }
+#line 1844 "tube8-parser.tab.cc"
+    break;
+
+  case 45: /* expression: VAL_LIT  */
+#line 324 "tube8.y"
+                     {
+               (yyval.ast_node) = new ASTNode_Literal(Type::VALUE, (yyvsp[0].lexeme));
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1853 "tube8-parser.tab.cc"
+    break;
+
+  case 46: /* expression: CHAR_LIT  */
+#line 328 "tube8.y"
+                      {
+               (yyval.ast_node) = new ASTNode_Literal(Type::CHAR, (yyvsp[0].lexeme));
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1862 "tube8-parser.tab.cc"
+    break;
+
+  case 47: /* expression: STRING_LIT  */
+#line 332 "tube8.y"
+                        {
+               (yyval.ast_node) = new ASTNode_Literal(Type::STRING, (yyvsp[0].lexeme));
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1871 "tube8-parser.tab.cc"
+    break;
+
+  case 48: /* expression: '[' argument_list ']'  */
+#line 336 "tube8.y"
+                                   {
+               (yyval.ast_node) = new ASTNode_ArrayLiteral((yyvsp[-1].ast_node));
+               delete (yyvsp[-1].ast_node);
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1881 "tube8-parser.tab.cc"
+    break;
+
+  case 49: /* expression: var_usage  */
+#line 341 "tube8.y"
+                       { (yyval.ast_node) = (yyvsp[0].ast_node); }
+#line 1887 "tube8-parser.tab.cc"
+    break;
+
+  case 50: /* expression: array_index  */
+#line 342 "tube8.y"
+                         { (yyval.ast_node) = (yyvsp[0].ast_node); }
+#line 1893 "tube8-parser.tab.cc"
+    break;
+
+  case 51: /* expression: ID '(' ')'  */
+#line 343 "tube8.y"
+                        {
+	       tableFunction * cur_fun = symbol_table.LookupFunction((yyvsp[-2].lexeme));
+               if (cur_fun == NULL) {
+		 std::string err_string = "unknown function '";
+		 err_string += (yyvsp[-2].lexeme);
+                 err_string += "'";
+		 yyerror(err_string);
+                 exit(1);
+               }
+               ASTNode_FunctionCall * node = new ASTNode_FunctionCall(cur_fun, symbol_table);
+               node->TypeCheckArgs();
+               (yyval.ast_node) = node;
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1912 "tube8-parser.tab.cc"
+    break;
+
+  case 52: /* expression: ID '(' argument_list ')'  */
+#line 357 "tube8.y"
+                                      {
+	       tableFunction * cur_fun = symbol_table.LookupFunction((yyvsp[-3].lexeme));
+               if (cur_fun == NULL) {
+		 std::string err_string = "unknown function '";
+		 err_string += (yyvsp[-3].lexeme);
+                 err_string += "'";
+		 yyerror(err_string);
+                 exit(1);
+               }
+               ASTNode_FunctionCall * node = new ASTNode_FunctionCall(cur_fun, symbol_table);
+	       node->TransferChildren((yyvsp[-1].ast_node));
+	       delete (yyvsp[-1].ast_node);
+               node->TypeCheckArgs();
+               (yyval.ast_node) = node;
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1933 "tube8-parser.tab.cc"
+    break;
+
+  case 53: /* expression: expression '.' ID '(' ')'  */
+#line 373 "tube8.y"
+                                       {
+               ASTNode_MethodCall * node = new ASTNode_MethodCall((yyvsp[-4].ast_node), (yyvsp[-2].lexeme));
+               node->TypeCheckArgs();
+               (yyval.ast_node) = node;
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1944 "tube8-parser.tab.cc"
+    break;
+
+  case 54: /* expression: expression '.' ID '(' argument_list ')'  */
+#line 379 "tube8.y"
+                                                     {
+               ASTNode_MethodCall * node = new ASTNode_MethodCall((yyvsp[-5].ast_node), (yyvsp[-3].lexeme));
+	       node->TransferChildren((yyvsp[-1].ast_node));
+	       delete (yyvsp[-1].ast_node);
+               node->TypeCheckArgs();
+               (yyval.ast_node) = node;
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1957 "tube8-parser.tab.cc"
+    break;
+
+  case 55: /* expression: COMMAND_RANDOM '(' expression ')'  */
+#line 387 "tube8.y"
+                                               {
+               (yyval.ast_node) = new ASTNode_Random((yyvsp[-1].ast_node));
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1966 "tube8-parser.tab.cc"
+    break;
+
+  case 56: /* expression: expression '?' expression ':' expression  */
+#line 391 "tube8.y"
+                                                      {
+               (yyval.ast_node) = new ASTNode_Ternary((yyvsp[-4].ast_node), (yyvsp[-2].ast_node), (yyvsp[0].ast_node));
+               (yyval.ast_node)->SetLineNum(line_num);
+             }
+#line 1975 "tube8-parser.tab.cc"
+    break;
+
+  case 57: /* argument_list: argument_list ',' argument  */
+#line 396 "tube8.y"
+                                           {
+		  ASTNode * node = (yyvsp[-2].ast_node); // Grab the node used for arg list.
+		  node->AddChild((yyvsp[0].ast_node));    // Save this argument in the node.
+		  (yyval.ast_node) = node;
+		}
+#line 1985 "tube8-parser.tab.cc"
+    break;
+
+  case 58: /* argument_list: argument  */
+#line 401 "tube8.y"
+                         {
+		  // Create a temporary AST node to hold the arg list.
+		  (yyval.ast_node) = new ASTNode_TempNode(Type::VOID);
+		  (yyval.ast_node)->AddChild((yyvsp[0].ast_node));   // Save this argument in the temp node.
+                  (yyval.ast_node)->SetLineNum(line_num);
+		}
+#line 1996 "tube8-parser.tab.cc"
+    break;
+
+  case 59: /* argument: expression  */
+#line 408 "tube8.y"
+                           { (yyval.ast_node) = (yyvsp[0].ast_node); }
+#line 2002 "tube8-parser.tab.cc"
+    break;
+
+  case 60: /* command: COMMAND_PRINT '(' argument_list ')'  */
+#line 411 "tube8.y"
+                                               {
+	     (yyval.ast_node) = new ASTNode_Print(NULL);
+	     (yyval.ast_node)->TransferChildren((yyvsp[-1].ast_node));
+             (yyval.ast_node)->SetLineNum(line_num);
+	     delete (yyvsp[-1].ast_node);
+           }
+#line 2013 "tube8-parser.tab.cc"
+    break;
+
+  case 61: /* command: COMMAND_BREAK  */
+#line 417 "tube8.y"
+                         {
+             (yyval.ast_node) = new ASTNode_Break();
+             (yyval.ast_node)->SetLineNum(line_num);
+           }
+#line 2022 "tube8-parser.tab.cc"
+    break;
+
+  case 62: /* command: COMMAND_CONTINUE  */
+#line 421 "tube8.y"
+                            {
+             (yyval.ast_node) = new ASTNode_Continue();
+             (yyval.ast_node)->SetLineNum(line_num);
+           }
+#line 2031 "tube8-parser.tab.cc"
+    break;
+
+  case 63: /* command: COMMAND_RETURN expression  */
+#line 425 "tube8.y"
+                                     {
+             (yyval.ast_node) = new ASTNode_Return((yyvsp[0].ast_node), symbol_table);
+             (yyval.ast_node)->SetLineNum(line_num);
+           }
+#line 2040 "tube8-parser.tab.cc"
+    break;
+
+  case 64: /* if_start: COMMAND_IF '(' expression ')'  */
+#line 430 "tube8.y"
+                                         {
+             (yyval.ast_node) = new ASTNode_If((yyvsp[-1].ast_node), NULL, NULL);
+             (yyval.ast_node)->SetLineNum(line_num);
+           }
+#line 2049 "tube8-parser.tab.cc"
+    break;
+
+  case 65: /* while_start: COMMAND_WHILE '(' expression ')'  */
+#line 435 "tube8.y"
+                                               {
+                (yyval.ast_node) = new ASTNode_While((yyvsp[-1].ast_node), NULL);
+                (yyval.ast_node)->SetLineNum(line_num);
+              }
+#line 2058 "tube8-parser.tab.cc"
+    break;
+
+  case 66: /* for_init: var_declare  */
+#line 440 "tube8.y"
+                        { (yyval.ast_node) = NULL; }
+#line 2064 "tube8-parser.tab.cc"
+    break;
+
+  case 67: /* for_init: declare_assign  */
+#line 441 "tube8.y"
+                           { (yyval.ast_node) = (yyvsp[0].ast_node); }
+#line 2070 "tube8-parser.tab.cc"
+    break;
+
+  case 68: /* for_init: expression  */
+#line 442 "tube8.y"
+                       { (yyval.ast_node) = (yyvsp[0].ast_node); }
+#line 2076 "tube8-parser.tab.cc"
+    break;
+
+  case 69: /* for_init: %empty  */
+#line 443 "tube8.y"
+            { (yyval.ast_node) = NULL; }
+#line 2082 "tube8-parser.tab.cc"
+    break;
+
+  case 70: /* opt_expr: expression  */
+#line 445 "tube8.y"
+                       { (yyval.ast_node) = (yyvsp[0].ast_node); }
+#line 2088 "tube8-parser.tab.cc"
+    break;
+
+  case 71: /* opt_expr: %empty  */
+#line 446 "tube8.y"
+            { (yyval.ast_node) = NULL; }
+#line 2094 "tube8-parser.tab.cc"
+    break;
+
+  case 72: /* for_start: COMMAND_FOR '(' for_init ';' opt_expr ';' opt_expr ')'  */
+#line 448 "tube8.y"
+                                                                   {
+                (yyval.ast_node) = new ASTNode_For((yyvsp[-5].ast_node), (yyvsp[-3].ast_node), (yyvsp[-1].ast_node), NULL);
+                (yyval.ast_node)->SetLineNum(line_num);
+            }
+#line 2103 "tube8-parser.tab.cc"
+    break;
+
+  case 73: /* flow_command: if_start statement COMMAND_ELSE statement  */
+#line 453 "tube8.y"
+                                                         {
+                 (yyval.ast_node)->SetChild(1, (yyvsp[-2].ast_node));
+                 (yyval.ast_node)->SetChild(2, (yyvsp[0].ast_node));
+                 (yyval.ast_node) = (yyvsp[-3].ast_node);
+               }
+#line 2113 "tube8-parser.tab.cc"
+    break;
+
+  case 74: /* flow_command: if_start statement  */
+#line 458 "tube8.y"
+                                               {
+                 (yyval.ast_node) = (yyvsp[-1].ast_node);
+                 (yyval.ast_node)->SetChild(1, (yyvsp[0].ast_node));
+               }
+#line 2122 "tube8-parser.tab.cc"
+    break;
+
+  case 75: /* flow_command: while_start statement  */
+#line 462 "tube8.y"
+                                     {
+                 (yyval.ast_node) = (yyvsp[-1].ast_node);
+                 (yyval.ast_node)->SetChild(1, (yyvsp[0].ast_node));
+               }
+#line 2131 "tube8-parser.tab.cc"
+    break;
+
+  case 76: /* flow_command: for_start statement  */
+#line 466 "tube8.y"
+                                   {
+                 (yyval.ast_node) = (yyvsp[-1].ast_node);
+                 (yyval.ast_node)->SetChild(3, (yyvsp[0].ast_node));
+               }
+#line 2140 "tube8-parser.tab.cc"
+    break;
+
+  case 77: /* flow_command: COMMAND_SWITCH '(' expression ')' block_start case_list block_end  */
+#line 470 "tube8.y"
+                                                                                 {
+                 ASTNode_Switch * node = new ASTNode_Switch((yyvsp[-4].ast_node));
+                 node->TransferChildren((yyvsp[-1].ast_node));
+                 delete (yyvsp[-1].ast_node);
+                 node->CheckCases();
+                 (yyval.ast_node) = node;
+                 (yyval.ast_node)->SetLineNum(line_num);
+               }
+#line 2153 "tube8-parser.tab.cc"
+    break;
+
+  case 78: /* case_list: %empty  */
+#line 479 "tube8.y"
+            {
+              // Collect (value, body) pairs in a temporary node; the default has no value.
+              (yyval.ast_node) = new ASTNode_TempNode(Type::VOID);
+            }
+#line 2162 "tube8-parser.tab.cc"
+    break;
+
+  case 79: /* case_list: case_list COMMAND_CASE expression ':' statement  */
+#line 483 "tube8.y"
+                                                            {
+              (yyvsp[-4].ast_node)->AddChild((yyvsp[-2].ast_node));
+              (yyvsp[-4].ast_node)->AddChild((yyvsp[0].ast_node));
+              (yyval.ast_node) = (yyvsp[-4].ast_node);
+            }
+#line 2172 "tube8-parser.tab.cc"
+    break;
+
+  case 80: /* case_list: case_list COMMAND_DEFAULT ':' statement  */
+#line 488 "tube8.y"
+                                                    {
+              (yyvsp[-3].ast_node)->AddChild(NULL);
+              (yyvsp[-3].ast_node)->AddChild((yyvsp[0].ast_node));
+              (yyval.ast_node) = (yyvsp[-3].ast_node);
+            }
+#line 2182 "tube8-parser.tab.cc"
+    break;
+
+  case 81: /* declare_start: COMMAND_DECLARE type_any ID  */
+#line 494 "tube8.y"
+                                           {
+                 if (symbol_table.GetCurScope() != 0) {
+       std::string err_string = "Attempting to define function '";
+       err_string += (yyvsp[0].lexeme);
+                   err_string += "' outside of global scope!";
+       yyerror(err_string);
+                   exit(1);
+                 }
+                 (yyval.symbol_table_function) = symbol_table.StartFunction((yyvsp[-1].value), (yyvsp[0].lexeme));
+                 if ((yyval.symbol_table_function) == NULL) { // Return types do not match!
+       std::string err_string = "Attempting to define function '";
+       err_string += (yyvsp[0].lexeme);
+                   err_string += "', with return type '";
+                   err_string += Type::AsString((yyvsp[-1].value));
+                   err_string += ", but previously declared as type '";
+                   err_string += Type::AsString(symbol_table.LookupFunction((yyvsp[0].lexeme))->GetReturnType());
+                   err_string += "'.";
+       yyerror(err_string);
+                   exit(1);
+                 } else if ((yyval.symbol_table_function)->GetAST() != NULL) {
+       std::string err_string = "Attempting to re-define function '";
+       err_string += (yyvsp[0].lexeme);
+                   err_string += "'.";
+       yyerror(err_string);
+                   exit(1);
+                 }
+}
+#line 2214 "tube8-parser.tab.cc"
+    break;
+
+  case 82: /* define_start: COMMAND_DEFINE type_any ID  */
+#line 522 "tube8.y"
+                                          {
+                 if (symbol_table.GetCurScope() != 0) {
+		   std::string err_string = "Attempting to define function '";
+		   err_string += (yyvsp[0].lexeme);
+                   err_string += "' outside of global scope!";
+		   yyerror(err_string);
+                   exit(1);
+                 }
+                 (yyval.symbol_table_function) = symbol_table.StartFunction((yyvsp[-1].value), (yyvsp[0].lexeme));
+                 if ((yyval.symbol_table_function) == NULL) { // Return types do not match!
+		   std::string err_string = "Attempting to define function '";
+		   err_string += (yyvsp[0].lexeme);
+                   err_string += "', with return type '";
+                   err_string += Type::AsString((yyvsp[-1].value));
+                   err_string += ", but previously declared as type '";
+                   err_string += Type::AsString(symbol_table.LookupFunction((yyvsp[0].lexeme))->GetReturnType());
+                   err_string += "'.";
+		   yyerror(err_string);
+                   exit(1);
+                 } else if ((yyval.symbol_table_function)->GetAST() != NULL) {
+		   std::string err_string = "Attempting to re-define function '";
+		   err_string += (yyvsp[0].lexeme);
+                   err_string += "'.";
+		   yyerror(err_string);
+                   exit(1);
+                 }
+               }
+#line 2246 "tube8-parser.tab.cc"
+    break;
+
+  case 83: /* fun_arg_list: var_declare  */
+#line 550 "tube8.y"
+                           { ; }
+#line 2252 "tube8-parser.tab.cc"
+    break;
+
+  case 84: /* fun_arg_list: fun_arg_list ',' var_declare  */
+#line 551 "tube8.y"
+                                            { ; }
+#line 2258 "tube8-parser.tab.cc"
+    break;
+
+  case 85: /* fun_arg_test: fun_arg_list  */
+#line 553 "tube8.y"
+                            { ; }
+#line 2264 "tube8-parser.tab.cc"
+    break;
+
+  case 86: /* fun_arg_test: %empty  */
+#line 554 "tube8.y"
+               { ; }
+#line 2270 "tube8-parser.tab.cc"
+    break;
+
+  case 87: /* $@1: %empty  */
+#line 556 "tube8.y"
+                                                   {
+                     (yyvsp[-3].symbol_table_function)->SetArgs(symbol_table.GetScopeVars(1));
+                 }
+#line 2278 "tube8-parser.tab.cc"
+    break;
+
+  case 88: /* define_command: define_start '(' fun_arg_test ')' $@1 statement  */
+#line 558 "tube8.y"
+                             {
+                     (yyvsp[-5].symbol_table_function)->SetAST((yyvsp[0].ast_node));
+                     symbol_table.EndFunction();
+                 }
+#line 2287 "tube8-parser.tab.cc"
+    break;
+
+  case 89: /* declare_command: declare_start '(' fun_arg_test ')'  */
+#line 563 "tube8.y"
+                                                    {
+                     (yyvsp[-3].symbol_table_function)->SetArgs(symbol_table.GetScopeVars(1));
+                     symbol_table.EndFunction();
+                 }
+#line 2296 "tube8-parser.tab.cc"
+    break;
+
+  case 90: /* block_start: '{'  */
+#line 568 "tube8.y"
+                 { symbol_table.IncScope(); }
+#line 2302 "tube8-parser.tab.cc"
+    break;
+
+  case 91: /* block_end: '}'  */
+#line 569 "tube8.y"
+                 { symbol_table.DecScope(); }
+#line 2308 "tube8-parser.tab.cc"
+    break;
+
+  case 92: /* code_block: block_start statement_list block_end  */
+#line 570 "tube8.y"
+                                                  { (yyval.ast_node) = (yyvsp[-1].ast_node); }
+#line 2314 "tube8-parser.tab.cc"
+    break;
+
+
+#line 2318 "tube8-parser.tab.cc"
+
+      default: break;
+    }
+  /* User semantic actions sometimes alter yychar, and that requires
+     that yytoken be updated with the new translation.  We take the
+     approach of translating immediately before every use of yytoken.
+     One alternative is translating here after every semantic action,
+     but that translation would be missed if the semantic action invokes
+     YYABORT, YYACCEPT, or YYERROR immediately after altering yychar or
+     if it invokes YYBACKUP.  In the case of YYABORT or YYACCEPT, an
+     incorrect destructor might then be invoked immediately.  In the
+     case of YYERROR or YYBACKUP, subsequent parser actions might lead
+     to an incorrect destructor call or verbose syntax error message
+     before the lookahead is translated.  */
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
+
+  YYPOPSTACK (yylen);
+  yylen = 0;
+
+  *++yyvsp = yyval;
+
+  /* Now 'shift' the result of the reduction.  Determine what state
+     that goes to, based on the state we popped back to and the rule
+     number reduced by.  */
+  {
+    const int yylhs = yyr1[yyn] - YYNTOKENS;
+    const int yyi = yypgoto[yylhs] + *yyssp;
+    yystate = (0 <= yyi && yyi <= YYLAST && yycheck[yyi] == *yyssp
+               ? yytable[yyi]
+               : yydefgoto[yylhs]);
+  }
+
+  goto yynewstate;
+
+
+/*--------------------------------------.
+| yyerrlab -- here on detecting error.  |
+`--------------------------------------*/
+yyerrlab:
+  /* Make sure we have latest lookahead translation.  See comments at
+     user semantic actions for why this is necessary.  */
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
+  /* If not already recovering from an error, report this error.  */
+  if (!yyerrstatus)
+    {
+      ++yynerrs;
+      yyerror (YY_("syntax error"));
+    }
+
+  if (yyerrstatus == 3)
+    {
+      /* If just tried and failed to reuse lookahead token after an
+         error, discard it.  */
+
+      if (yychar <= YYEOF)
+        {
+          /* Return failure if at end of input.  */
+          if (yychar == YYEOF)
+            YYABORT;
+        }
+      else
+        {
+          yydestruct ("Error: discarding",
+                      yytoken, &yylval);
+          yychar = YYEMPTY;
+        }
+    }
+
+  /* Else will try to reuse lookahead token after shifting the error
+     token.  */
+  goto yyerrlab1;
+
+
+/*---------------------------------------------------.
+| yyerrorlab -- error raised explicitly by YYERROR.  |
+`---------------------------------------------------*/
+yyerrorlab:
+  /* Pacify compilers when the user code never invokes YYERROR and the
+     label yyerrorlab therefore never appears in user code.  */
+  if (0)
+    YYERROR;
+  ++yynerrs;
+
+  /* Do not reclaim the symbols of the rule whose action triggered
+     this YYERROR.  */
+  YYPOPSTACK (yylen);
+  yylen = 0;
+  YY_STACK_PRINT (yyss, yyssp);
+  yystate = *yyssp;
+  goto yyerrlab1;
+
+
+/*-------------------------------------------------------------.
+| yyerrlab1 -- common code for both syntax error and YYERROR.  |
+`-------------------------------------------------------------*/
+yyerrlab1:
+  yyerrstatus = 3;      /* Each real token shifted decrements this.  */
+
+  /* Pop stack until we find a state that shifts the error token.  */
+  for (;;)
+    {
+      yyn = yypact[yystate];
+      if (!yypact_value_is_default (yyn))
+        {
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
+            {
+              yyn = yytable[yyn];
+              if (0 < yyn)
+                break;
+            }
+        }
+
+      /* Pop the current state because it cannot handle the error token.  */
+      if (yyssp == yyss)
+        YYABORT;
+
+
+      yydestruct ("Error: popping",
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp);
+      YYPOPSTACK (1);
+      yystate = *yyssp;
+      YY_STACK_PRINT (yyss, yyssp);
+    }
+
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+
+
+  /* Shift the error token.  */
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
+
+  yystate = yyn;
+  goto yynewstate;
+
+
+/*-------------------------------------.
+| yyacceptlab -- YYACCEPT comes here.  |
+`-------------------------------------*/
+yyacceptlab:
+  yyresult = 0;
+  goto yyreturnlab;
+
+
+/*-----------------------------------.
+| yyabortlab -- YYABORT comes here.  |
+`-----------------------------------*/
+yyabortlab:
+  yyresult = 1;
+  goto yyreturnlab;
+
+
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
+yyexhaustedlab:
+  yyerror (YY_("memory exhausted"));
+  yyresult = 2;
+  goto yyreturnlab;
+
+
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
+  if (yychar != YYEMPTY)
+    {
+      /* Make sure we have latest lookahead translation.  See comments at
+         user semantic actions for why this is necessary.  */
+      yytoken = YYTRANSLATE (yychar);
+      yydestruct ("Cleanup: discarding lookahead",
+                  yytoken, &yylval);
+    }
+  /* Do not reclaim the symbols of the rule whose action triggered
+     this YYABORT or YYACCEPT.  */
+  YYPOPSTACK (yylen);
+  YY_STACK_PRINT (yyss, yyssp);
+  while (yyssp != yyss)
+    {
+      yydestruct ("Cleanup: popping",
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp);
+      YYPOPSTACK (1);
+    }
+#ifndef yyoverflow
+  if (yyss != yyssa)
+    YYSTACK_FREE (yyss);
+#endif
+
+  return yyresult;
+}
+
+#line 572 "tube8.y"
+
+void LexMain(int argc, char * argv[]);
+
+int main(int argc, char * argv[])
+{
+  error_count = 0;
+  LexMain(argc, argv);
+
+  yyparse();
+
+  if (error_count == 0) std::cout << "Parse Successful!" << std::endl;
+
+  return error_count;
+}
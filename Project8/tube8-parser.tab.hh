@@ -0,0 +1,123 @@
+/* A Bison parser, made by GNU Bison 3.8.2.  */
+
+/* Bison interface for Yacc-like parsers in C
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* As a special exception, you may create a larger work that contains
+   part or all of the Bison parser skeleton and distribute that work
+   under terms of your choice, so long as that work isn't itself a
+   parser generator using the skeleton or a modified version thereof
+   as a parser skeleton.  Alternatively, if you modify or redistribute
+   the parser skeleton itself, you may (at your option) remove this
+   special exception, which will cause the skeleton and the resulting
+   Bison output files to be licensed under the GNU General Public
+   License without this special exception.
+
+   This special exception was added by the Free Software Foundation in
+   version 2.2 of Bison.  */
+
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+#ifndef YY_YY_TUBE8_PARSER_TAB_HH_INCLUDED
+# define YY_YY_TUBE8_PARSER_TAB_HH_INCLUDED
+/* Debug traces.  */
+#ifndef YYDEBUG
+# define YYDEBUG 0
+#endif
+#if YYDEBUG
+extern int yydebug;
+#endif
+
+/* Token kinds.  */
+#ifndef YYTOKENTYPE
+# define YYTOKENTYPE
+  enum yytokentype
+  {
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    CASSIGN_ADD = 258,             /* CASSIGN_ADD  */
+    CASSIGN_SUB = 259,             /* CASSIGN_SUB  */
+    CASSIGN_MULT = 260,            /* CASSIGN_MULT  */
+    CASSIGN_DIV = 261,             /* CASSIGN_DIV  */
+    CASSIGN_MOD = 262,             /* CASSIGN_MOD  */
+    COMP_EQU = 263,                /* COMP_EQU  */
+    COMP_NEQU = 264,               /* COMP_NEQU  */
+    COMP_LESS = 265,               /* COMP_LESS  */
+    COMP_LTE = 266,                /* COMP_LTE  */
+    COMP_GTR = 267,                /* COMP_GTR  */
+    COMP_GTE = 268,                /* COMP_GTE  */
+    BOOL_AND = 269,                /* BOOL_AND  */
+    BOOL_OR = 270,                 /* BOOL_OR  */
+    COMMAND_PRINT = 271,           /* COMMAND_PRINT  */
+    COMMAND_IF = 272,              /* COMMAND_IF  */
+    COMMAND_ELSE = 273,            /* COMMAND_ELSE  */
+    COMMAND_WHILE = 274,           /* COMMAND_WHILE  */
+    COMMAND_FOR = 275,             /* COMMAND_FOR  */
+    COMMAND_BREAK = 276,           /* COMMAND_BREAK  */
+    COMMAND_CONTINUE = 277,        /* COMMAND_CONTINUE  */
+    COMMAND_RANDOM = 278,          /* COMMAND_RANDOM  */
+    COMMAND_RETURN = 279,          /* COMMAND_RETURN  */
+    COMMAND_DEFINE = 280,          /* COMMAND_DEFINE  */
+    COMMAND_DECLARE = 281,         /* COMMAND_DECLARE  */
+    COMMAND_SWITCH = 282,          /* COMMAND_SWITCH  */
+    COMMAND_CASE = 283,            /* COMMAND_CASE  */
+    COMMAND_DEFAULT = 284,         /* COMMAND_DEFAULT  */
+    VAL_LIT = 285,                 /* VAL_LIT  */
+    CHAR_LIT = 286,                /* CHAR_LIT  */
+    STRING_LIT = 287,              /* STRING_LIT  */
+    TYPE = 288,                    /* TYPE  */
+    META_TYPE = 289,               /* META_TYPE  */
+    ID = 290,                      /* ID  */
+    UMINUS = 291,                  /* UMINUS  */
+    NOELSE = 292                   /* NOELSE  */
+  };
+  typedef enum yytokentype yytoken_kind_t;
+#endif
+
+/* Value type.  */
+#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
+union YYSTYPE
+{
+#line 38 "tube8.y"
+
+  char * lexeme;
+  int value;
+  ASTNode * ast_node;
+  tableEntry * symbol_table_entry;
+  tableFunction * symbol_table_function;
+
+#line 109 "tube8-parser.tab.hh"
+
+};
+typedef union YYSTYPE YYSTYPE;
+# define YYSTYPE_IS_TRIVIAL 1
+# define YYSTYPE_IS_DECLARED 1
+#endif
+
+
+extern YYSTYPE yylval;
+
+
+int yyparse (void);
+
+
+#endif /* !YY_YY_TUBE8_PARSER_TAB_HH_INCLUDED  */
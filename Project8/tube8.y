@@ -1,4 +1,6 @@
 %{
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <string>
 #include <fstream>
@@ -12,6 +14,7 @@ extern int line_num;
 extern int yylex();
 extern std::string out_filename;
 extern bool use_int_code;
+extern bool cost_report;
  
 symbolTable symbol_table;
 int error_count = 0;
@@ -40,16 +43,16 @@ void yyerror2(std::string err_string, int orig_line) {
   tableFunction * symbol_table_function;
 }
 
-%token CASSIGN_ADD CASSIGN_SUB CASSIGN_MULT CASSIGN_DIV COMP_EQU COMP_NEQU COMP_LESS COMP_LTE COMP_GTR COMP_GTE BOOL_AND BOOL_OR COMMAND_PRINT COMMAND_IF COMMAND_ELSE COMMAND_WHILE COMMAND_FOR COMMAND_BREAK COMMAND_CONTINUE COMMAND_RANDOM COMMAND_RETURN COMMAND_DEFINE COMMAND_DECLARE
+%token CASSIGN_ADD CASSIGN_SUB CASSIGN_MULT CASSIGN_DIV CASSIGN_MOD COMP_EQU COMP_NEQU COMP_LESS COMP_LTE COMP_GTR COMP_GTE BOOL_AND BOOL_OR COMMAND_PRINT COMMAND_IF COMMAND_ELSE COMMAND_WHILE COMMAND_FOR COMMAND_BREAK COMMAND_CONTINUE COMMAND_RANDOM COMMAND_RETURN COMMAND_DEFINE COMMAND_DECLARE COMMAND_SWITCH COMMAND_CASE COMMAND_DEFAULT
 %token <lexeme> VAL_LIT CHAR_LIT STRING_LIT TYPE META_TYPE ID
 
-%right '=' CASSIGN_ADD CASSIGN_SUB CASSIGN_MULT CASSIGN_DIV
+%right '=' CASSIGN_ADD CASSIGN_SUB CASSIGN_MULT CASSIGN_DIV CASSIGN_MOD
 %right ':' '?'
 %left BOOL_OR
 %left BOOL_AND
 %nonassoc COMP_EQU COMP_NEQU COMP_LESS COMP_LTE COMP_GTR COMP_GTE
 %left '+' '-'
-%left '*' '/'
+%left '*' '/' '%'
 %nonassoc UMINUS '!'
 %left '.'
 
@@ -57,7 +60,7 @@ void yyerror2(std::string err_string, int orig_line) {
 %nonassoc COMMAND_ELSE
 
 
-%type <ast_node> expression declare_assign statement statement_list var_usage array_index lhs_ok command argument_list argument code_block for_init opt_expr if_start while_start for_start flow_command
+%type <ast_node> expression declare_assign statement statement_list var_usage array_index lhs_ok command argument_list argument code_block for_init opt_expr if_start while_start for_start flow_command case_list
 %type <value> type_any
 %type <symbol_table_entry> var_declare
 %type <symbol_table_function> define_start declare_start
@@ -68,12 +71,19 @@ program:      statement_list {
 
                 IC_Array ic_array;  // Intermediate code container
 
+                // Find the functions the program uses and what each one does, before
+                // compiling any calls to them.
+                symbol_table.AnalyzeEffects($1);
+
                 // Traverse the AST, filling ic_array with code
                 $1->CompileTubeIC(symbol_table, ic_array);
 
                 // Generate function code from the symbol table
                 symbol_table.CompileTubeIC(ic_array);
 
+                // Fill in the string literals the code uses before anything else runs.
+                ic_array.AddLiteralPool();
+
                 ic_array.AddBlock();
                 ic_array.AddLocal();
                 ic_array.AlgebraicOpt();
@@ -88,6 +98,15 @@ program:      statement_list {
                 } else {
                   ic_array.PrintTubeCode(out_file);  // Write TubeCode Assembly
                 }
+
+                // Estimate the cycles the TubeCode would use, if requested.
+                if (cost_report == true) {
+                  if (use_int_code == true) {
+                    std::stringstream tube_code;
+                    ic_array.PrintTubeCode(tube_code);
+                  }
+                  ic_array.PrintCostReport(std::cout);
+                }
               }
 
 statement_list:	 {
@@ -151,6 +170,42 @@ var_declare:	type_any ID {
 
                   $$ = symbol_table.AddEntry($1, $2);
 	        }
+        |	META_TYPE '(' TYPE ',' VAL_LIT ')' ID {
+		  std::string type_name = $3;
+		  if (type_name != "val") {
+		    std::string err_string = "unknown type 'array(";
+		    err_string += $3;
+                    err_string += ", N)'";
+		    yyerror(err_string);
+		    exit(1);
+		  }
+	          if (symbol_table.InCurScope($7) == true) {
+		    std::string err_string = "redeclaration of variable '";
+		    err_string += $7;
+                    err_string += "'";
+                    yyerror(err_string);
+		    exit(1);
+                  }
+                  // The elements have fixed memory cells, so each call can't get its own.
+                  if (symbol_table.GetCurFunction() != NULL) {
+                    yyerror("fixed-size arrays cannot be declared inside functions");
+                    exit(1);
+                  }
+                  double size = std::stod($5);
+                  if (size < 1 || size != std::floor(size)) {
+                    yyerror("size of a fixed-size array must be a whole number of at least 1");
+                    exit(1);
+                  }
+
+                  $$ = symbol_table.AddFixedArray($7, (int) std::min(size, 10000.0));
+                  if ($$ == NULL) {
+		    std::string err_string = "fixed-size array '";
+		    err_string += $7;
+                    err_string += "' does not fit in static memory";
+                    yyerror(err_string);
+		    exit(1);
+                  }
+	        }
 
 declare_assign:  var_declare '=' expression {
                    ASTNode_Variable * var_node = new ASTNode_Variable($1);
@@ -197,6 +252,10 @@ expression:  expression '+' expression {
 	       $$ = new ASTNode_Math2($1, $3, '/');
                $$->SetLineNum(line_num);
              }
+	|    expression '%' expression {
+	       $$ = new ASTNode_Math2($1, $3, '%');
+               $$->SetLineNum(line_num);
+             }
 	|    expression COMP_EQU expression {
                $$ = new ASTNode_Math2($1, $3, COMP_EQU);
                $$->SetLineNum(line_num);
@@ -249,6 +308,10 @@ expression:  expression '+' expression {
                $$ = new ASTNode_Assign($1, new ASTNode_Math2($1, $3, '/') );
                $$->SetLineNum(line_num);
              }
+	|    lhs_ok CASSIGN_MOD expression {
+               $$ = new ASTNode_Assign($1, new ASTNode_Math2($1, $3, '%') );
+               $$->SetLineNum(line_num);
+             }
 	|    '-' expression %prec UMINUS {
                $$ = new ASTNode_Math1($2, '-');
                $$->SetLineNum(line_num);
@@ -270,6 +333,11 @@ expression:  expression '+' expression {
                $$ = new ASTNode_Literal(Type::STRING, $1);
                $$->SetLineNum(line_num);
              }
+        |    '[' argument_list ']' {
+               $$ = new ASTNode_ArrayLiteral($2);
+               delete $2;
+               $$->SetLineNum(line_num);
+             }
 	|    var_usage { $$ = $1; }
 	|    array_index { $$ = $1; }
         |    ID '(' ')' {
@@ -399,6 +467,29 @@ flow_command:  if_start statement COMMAND_ELSE statement {
                  $$ = $1;
                  $$->SetChild(3, $2);
                }
+            |  COMMAND_SWITCH '(' expression ')' block_start case_list block_end {
+                 ASTNode_Switch * node = new ASTNode_Switch($3);
+                 node->TransferChildren($6);
+                 delete $6;
+                 node->CheckCases();
+                 $$ = node;
+                 $$->SetLineNum(line_num);
+               }
+
+case_list:  {
+              // Collect (value, body) pairs in a temporary node; the default has no value.
+              $$ = new ASTNode_TempNode(Type::VOID);
+            }
+        |   case_list COMMAND_CASE expression ':' statement {
+              $1->AddChild($3);
+              $1->AddChild($5);
+              $$ = $1;
+            }
+        |   case_list COMMAND_DEFAULT ':' statement {
+              $1->AddChild(NULL);
+              $1->AddChild($4);
+              $$ = $1;
+            }
 
 declare_start: COMMAND_DECLARE type_any ID {
                  if (symbol_table.GetCurScope() != 0) {
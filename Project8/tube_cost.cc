@@ -0,0 +1,187 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "tube_cost.h"
+
+CostTable cost_table;
+
+CostTable::CostTable()
+{
+  // Cycle counts charged by the tubecode VM.
+  const char * basic_insts[] = {
+    "val_copy", "add", "sub", "mult", "div", "mod", "test_less", "test_gtr", "test_equ",
+    "test_nequ", "test_gte", "test_lte", "jump", "jump_if_0", "jump_if_n0", "random",
+    "out_val", "out_int", "out_float", "out_char"
+  };
+  for (const char * inst : basic_insts) tc_costs[inst] = 1;
+  tc_costs["nop"] = 0;
+  tc_costs["load"] = 100;
+  tc_costs["store"] = 100;
+  tc_costs["mem_copy"] = 100;
+}
+
+int CostTable::TubeCode(const std::string & inst) const
+{
+  std::map<std::string, int>::const_iterator it = tc_costs.find(inst);
+  if (it == tc_costs.end()) return 1;
+  return it->second;
+}
+
+int CostTable::IC(const std::string & inst) const
+{
+  // These costs follow the TubeCode that IC_Entry::PrintTubeCode generates.
+  if (inst == "")           return 0;
+  if (inst == "push" || inst == "ar_push") return TubeCode("store") + TubeCode("add");
+  if (inst == "pop" || inst == "ar_pop")   return TubeCode("sub") + TubeCode("load");
+  if (inst == "ar_get_idx") return 2 * TubeCode("add") + TubeCode("load");
+  if (inst == "ar_set_idx") return 2 * TubeCode("add") + TubeCode("store");
+  if (inst == "ar_get_siz") return TubeCode("load");
+  if (inst == "jump_table") return TubeCode("add") + 2 * TubeCode("jump");
+  if (inst == "ar_set_siz") {   // Resizing within the space the array already has
+    return TubeCode("jump_if_0") + TubeCode("sub") + 2 * TubeCode("load") + TubeCode("test_gtr")
+      + 2 * TubeCode("jump_if_n0") + TubeCode("store") + TubeCode("test_gte");
+  }
+  if (inst == "ar_copy") {      // Including a fresh block from the allocator
+    return 4 * TubeCode("jump_if_n0") + 3 * TubeCode("load") + 5 * TubeCode("val_copy")
+      + 6 * TubeCode("add") + 3 * TubeCode("store") + TubeCode("test_gte") + TubeCode("test_gtr")
+      + TubeCode("jump_if_0") + TubeCode("sub") + 2 * TubeCode("jump");
+  }
+  if (inst == "ar_free") {
+    return TubeCode("jump_if_0") + TubeCode("sub") + TubeCode("add")
+      + 2 * TubeCode("load") + 2 * TubeCode("store");
+  }
+  return TubeCode(inst);
+}
+
+int CostTable::ICPerElement(const std::string & inst) const
+{
+  if (inst == "ar_set_siz") {   // Copying when it has to move, then zeroing the new positions
+    return 4 * TubeCode("add") + TubeCode("test_gtr") + TubeCode("test_gte")
+      + 2 * TubeCode("jump_if_n0") + TubeCode("mem_copy") + TubeCode("store") + 2 * TubeCode("jump");
+  }
+  if (inst == "ar_copy") {
+    return TubeCode("test_gtr") + TubeCode("jump_if_n0") + TubeCode("mem_copy")
+      + 2 * TubeCode("add") + TubeCode("jump");
+  }
+  return 0;
+}
+
+
+namespace {
+  // Run a TubeCode program on the VM and return the cycles it reports (-1 on failure).
+  int RunMicroprogram(const std::string & vm_path, const std::string & code)
+  {
+    char filename[] = "/tmp/tube8_calibrate_XXXXXX";
+    int fd = mkstemp(filename);
+    if (fd == -1) return -1;
+    close(fd);
+    std::ofstream ofs(filename);
+    ofs << code;
+    ofs.close();
+
+    // Run the VM directly so the path never passes through a shell.
+    int pipe_fds[2];
+    if (pipe(pipe_fds) == -1) { std::remove(filename); return -1; }
+    pid_t pid = fork();
+    if (pid == -1) {
+      close(pipe_fds[0]);
+      close(pipe_fds[1]);
+      std::remove(filename);
+      return -1;
+    }
+    if (pid == 0) {
+      dup2(pipe_fds[1], STDOUT_FILENO);
+      dup2(pipe_fds[1], STDERR_FILENO);
+      close(pipe_fds[0]);
+      close(pipe_fds[1]);
+      execl(vm_path.c_str(), vm_path.c_str(), "-c", filename, (char *) NULL);
+      _exit(127);
+    }
+    close(pipe_fds[1]);
+    std::string output;
+    char buffer[256];
+    ssize_t count;
+    while ((count = read(pipe_fds[0], buffer, sizeof(buffer))) > 0) output.append(buffer, count);
+    close(pipe_fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    std::remove(filename);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return -1;
+
+    const std::string marker = "Total CPU cycles used:";
+    size_t pos = output.rfind(marker);
+    if (pos == std::string::npos) return -1;
+    return atoi(output.c_str() + pos + marker.size());
+  }
+}
+
+bool CostTable::Calibrate(const std::string & vm_path, std::ostream & log)
+{
+  const int reps = 10;
+  const std::string setup =
+    "  val_copy 7 regA\n  val_copy 3 regB\n  val_copy 100 regC\n  val_copy 0 regE\n";
+
+  const int base_cycles = RunMicroprogram(vm_path, setup);
+  if (base_cycles < 0) {
+    log << "ERROR: Unable to run '" << vm_path << "' for calibration." << std::endl;
+    return false;
+  }
+
+  // Build a line exercising each instruction; jumps go to the very next line.
+  std::map<std::string, int> measured;
+  for (const std::pair<const std::string, int> & entry : tc_costs) {
+    const std::string & inst = entry.first;
+    std::stringstream code;
+    code << setup;
+    for (int i = 0; i < reps; i++) {
+      if (inst == "jump") code << "  jump L" << i << "\nL" << i << ":\n";
+      else if (inst == "jump_if_0") code << "  jump_if_0 regE L" << i << "\nL" << i << ":\n";
+      else if (inst == "jump_if_n0") code << "  jump_if_n0 regA L" << i << "\nL" << i << ":\n";
+      else if (inst == "nop") code << "  nop\n";
+      else if (inst == "val_copy") code << "  val_copy regA regD\n";
+      else if (inst == "random") code << "  random 10 regD\n";
+      else if (inst == "out_char") code << "  out_char 32\n";
+      else if (inst.compare(0, 4, "out_") == 0) code << "  " << inst << " regA\n";
+      else if (inst == "load") code << "  load regC regD\n";
+      else if (inst == "store") code << "  store regA regC\n";
+      else if (inst == "mem_copy") code << "  mem_copy regC 101\n";
+      else code << "  " << inst << " regA regB regD\n";
+    }
+    const int cycles = RunMicroprogram(vm_path, code.str());
+    if (cycles < 0) {
+      log << "WARNING: Unable to calibrate '" << inst << "'; keeping default." << std::endl;
+      continue;
+    }
+    measured[inst] = (cycles - base_cycles + reps / 2) / reps;
+  }
+
+  for (const std::pair<const std::string, int> & entry : measured) tc_costs[entry.first] = entry.second;
+  return true;
+}
+
+void CostTable::Print(std::ostream & ofs) const
+{
+  ofs << "# TubeCode instruction costs (cycles)" << std::endl;
+  for (const std::pair<const std::string, int> & entry : tc_costs) {
+    ofs << "  " << entry.first;
+    for (int i = (int) entry.first.size(); i < 12; i++) ofs << " ";
+    ofs << entry.second << std::endl;
+  }
+  ofs << "# Intermediate code instruction costs (cycles, + per element copied)" << std::endl;
+  const char * ic_insts[] = {
+    "push", "pop", "ar_get_idx", "ar_set_idx", "ar_get_siz", "ar_set_siz", "ar_copy",
+    "ar_free", "ar_push", "ar_pop"
+  };
+  for (const char * inst : ic_insts) {
+    ofs << "  " << inst;
+    for (int i = (int) std::string(inst).size(); i < 12; i++) ofs << " ";
+    ofs << IC(inst);
+    if (ICPerElement(inst)) ofs << " + " << ICPerElement(inst) << "/element";
+    ofs << std::endl;
+  }
+}
@@ -0,0 +1,35 @@
+#ifndef TUBE_COST_H
+#define TUBE_COST_H
+
+// The CostTable class records how many CPU cycles the tubecode virtual machine
+// charges for each TubeCode instruction, and from those estimates the cost of each
+// intermediate-code instruction once it has been converted to TubeCode.
+//
+// The default values match the tubecode VM (memory accesses are slow; nop is
+// free); Calibrate() re-derives them by timing small programs on a real VM.
+//
+
+#include <iostream>
+#include <map>
+#include <string>
+
+class CostTable {
+private:
+  std::map<std::string, int> tc_costs;   // Cycles charged for each TubeCode instruction
+
+public:
+  CostTable();
+  ~CostTable() { ; }
+
+  int TubeCode(const std::string & inst) const;   // Cycles for one TubeCode instruction
+  int IC(const std::string & inst) const;         // Cycles for an IC instruction (operands in registers)
+  int ICPerElement(const std::string & inst) const;  // Extra cycles per array element copied
+
+  // Measure the costs by running microprograms on the given tubecode executable.
+  bool Calibrate(const std::string & vm_path, std::ostream & log);
+  void Print(std::ostream & ofs) const;
+};
+
+extern CostTable cost_table;
+
+#endif
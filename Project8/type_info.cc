@@ -8,13 +8,14 @@ namespace Type {
     case CHAR: return "char";
     case STRING: return "array(char)";
     case VALUE_ARRAY: return "array(val)";
+    case FIXED_VALUE_ARRAY: return "array(val, N)";
     };
     return "unknown";
   }
 
   int InternalType(int type) {
     if (type == STRING) return CHAR;
-    if (type == VALUE_ARRAY) return VALUE;
+    if (type == VALUE_ARRAY || type == FIXED_VALUE_ARRAY) return VALUE;
     return VOID;
   }
 
@@ -4,12 +4,13 @@
 #include <string>
 
 namespace Type {
-  enum TypeNames { VOID=0, VALUE, CHAR, STRING, VALUE_ARRAY };
+  enum TypeNames { VOID=0, VALUE, CHAR, STRING, VALUE_ARRAY, FIXED_VALUE_ARRAY };
   
   std::string AsString(int type); // Convert the internal type to a string like "int"
   int InternalType(int type);     // Determine the internal type for arrays (or return Type::VOID)
   bool IsArray(int type);         // Determine if the type passed in is an array
-  inline bool IsScalar(int type) { return !IsArray(type); }
+  inline bool IsFixedArray(int type) { return type == FIXED_VALUE_ARRAY; }  // Static block, not on the heap
+  inline bool IsScalar(int type) { return !IsArray(type) && !IsFixedArray(type); }
 };
 
 #endif